@@ -73,3 +73,24 @@ ENDIF(COMMAND cmake_policy)
 
 #ADD_DEFINITIONS(-DSAFE_MEMORY)
 
+
+# Internal pixel format: float ARGB (default) or packed 8-bit ARGB
+OPTION(OPENWF_INTEGER_PIXEL "Use packed 8-bit internal pixel format" OFF)
+IF (OPENWF_INTEGER_PIXEL)
+  MESSAGE(STATUS "*** 8-bit internal pixel format ***")
+  ADD_DEFINITIONS(-DOWF_USE_INTEGER_PIXEL)
+ENDIF (OPENWF_INTEGER_PIXEL)
+
+# Byte alignment of image buffers (power of two)
+SET(OPENWF_IMAGE_ALIGNMENT 64 CACHE STRING "Byte alignment of image buffers")
+ADD_DEFINITIONS(-DOWF_IMAGE_ALIGNMENT=${OPENWF_IMAGE_ALIGNMENT})
+
+# Byte alignment of internal format image rows (power of two)
+SET(OPENWF_IMAGE_ROW_ALIGNMENT ${OPENWF_IMAGE_ALIGNMENT} CACHE STRING
+    "Byte alignment of internal image rows")
+ADD_DEFINITIONS(-DOWF_IMAGE_ROW_ALIGNMENT=${OPENWF_IMAGE_ROW_ALIGNMENT})
+
+# Most threads a composition context preprocesses elements on; the
+# processor count is used if it is lower
+SET(OPENWF_MAX_WORKERS 8 CACHE STRING "Most composition worker threads")
+ADD_DEFINITIONS(-DWFC_MAX_WORKERS=${OPENWF_MAX_WORKERS})
@@ -37,6 +37,21 @@ OWF_API_CALL OWFint OWF_Mutex_Lock(OWF_MUTEX *mutex);
 
 OWF_API_CALL OWFint OWF_Mutex_Unlock(OWF_MUTEX *mutex);
 
+/* once-control for OWF_Once; must be statically set to OWF_ONCE_INIT */
+typedef OWFint OWF_ONCE;
+
+#define OWF_ONCE_INIT 0
+
+/*! \brief Run an initialization function exactly once
+ *
+ *  \param once once-control belonging to init
+ *  \param init function to run
+ *
+ *  Returns only after init has completed, so everything init wrote is
+ *  visible to the caller. init must not call OWF_Once itself.
+ */
+OWF_API_CALL void OWF_Once(OWF_ONCE *once, void (*init)(void));
+
 #ifdef __cplusplus
 }
 #endif
@@ -62,7 +62,9 @@ typedef enum {
  *
  *  \param width            Stream image buffer width
  *  \param height           Stream image buffer height
- *  \param imageFormat      Stream image buffer format
+ *  \param imageFormat      Stream image buffer format. Buffers are
+ *                          OWF_IMAGE_ALIGNMENT aligned; a rowPadding that
+ *                          is a power of two up to that aligns every row.
  *  \param nbufs            Number of image buffers to allocate
  *
  *  \param Handle to newly created stream or OWF_INVALID_HANDLe if no
@@ -250,6 +252,19 @@ OWF_API_CALL void owfNativeStreamSetBlocking(OWFNativeStreamType stream,
 OWF_PUBLIC void *owfNativeStreamGetBufferPtr(OWFNativeStreamType stream,
                                              OWFNativeStreamBuffer buffer);
 
+/*!---------------------------------------------------------------------------
+ *  Return content serial of a stream buffer. The serial changes every time
+ *  the buffer is committed to the stream.
+ *
+ *  \param stream           Stream handle
+ *  \param buffer           Buffer handle
+ *
+ *  \return Buffer's content serial, or zero if the stream is invalid.
+ *----------------------------------------------------------------------------*/
+OWF_API_CALL OWFuint32
+owfNativeStreamGetBufferSerial(OWFNativeStreamType stream,
+                               OWFNativeStreamBuffer buffer);
+
 /*!---------------------------------------------------------------------------
  *  Set/reset stream's protection flag. This flag is used for preventing the
  *  user from deleting a stream that s/he doesn't really own or should
@@ -46,6 +46,12 @@ OWF_API_CALL void OWF_Thread_MicroSleep(OWFuint32 usecs);
 
 OWF_API_CALL void OWF_Thread_Sleep(OWFuint32 secs);
 
+/* Monotonic time in nanoseconds, for measuring intervals only */
+OWF_API_CALL OWFuint64 OWF_Thread_GetNanoTime(void);
+
+/* Number of processors online, at least 1 */
+OWF_API_CALL OWFint OWF_Thread_GetProcessorCount(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,56 @@
+/* Copyright (c) 2009 The Khronos Group Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Materials.
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+#ifndef OWFWORKERPOOL_H_
+#define OWFWORKERPOOL_H_
+
+#include "owftypes.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void *OWF_WORKER_POOL;
+
+/* Job run once for each item; worker is the index of the worker running
+ * it, 0 being the thread that called OWF_WorkerPool_Run */
+typedef void (*OWF_WORKER_JOB)(void *data, OWFint item, OWFint worker);
+
+/* Create a pool of the given number of workers, counting the thread that
+ * runs the jobs; one thread fewer is started */
+OWF_API_CALL OWF_WORKER_POOL OWF_WorkerPool_Create(OWFint workers);
+
+OWF_API_CALL OWFint OWF_WorkerPool_GetWorkerCount(OWF_WORKER_POOL pool);
+
+/* Run job for items 0 to items - 1 on all workers and wait until every
+ * one has finished. Items are handed out in order, one at a time. Without
+ * a pool the items are run on the calling thread. */
+OWF_API_CALL void OWF_WorkerPool_Run(OWF_WORKER_POOL pool, OWFint items,
+                                     OWF_WORKER_JOB job, void *data);
+
+OWF_API_CALL void OWF_WorkerPool_Destroy(OWF_WORKER_POOL pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
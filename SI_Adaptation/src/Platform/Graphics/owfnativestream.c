@@ -98,6 +98,8 @@ typedef struct {
     OWFNativeStreamType handle; /* stream handle */
     void **bufferList;
     OWFint *bufferRefs;
+    OWFuint32 *bufferSerials; /* content serial of each buffer */
+    OWFuint32 serial;         /* last serial handed out */
     OWFint bufferCount;
     OWFint lockCount;
     OWFint screenNumber;
@@ -122,8 +124,9 @@ typedef struct {
     NS_FLIPPED_TARGET newFlip;
 } OWF_NATIVE_STREAM;
 
-static const OWF_IMAGE_FORMAT owfOnScreenColorFormat = {OWF_IMAGE_ARGB8888,
-                                                        OWF_FALSE, OWF_TRUE, 4};
+static const OWF_IMAGE_FORMAT owfOnScreenColorFormat = {
+    OWF_IMAGE_ARGB8888, OWF_FALSE, OWF_TRUE, 4, OWF_FALSE,
+    OWF_YUV_BT601_LIMITED};
 
 /*============================================================================
  * PRIVATE PARTS
@@ -292,6 +295,7 @@ static void owfNativeStreamDoDestroy(OWF_NATIVE_STREAM *ns) {
     }
 
     xfree(ns->bufferSyncs);
+    xfree(ns->bufferSerials);
     xfree(ns->bufferRefs);
     xfree(ns);
 }
@@ -305,7 +309,9 @@ static void owfNativeStreamDoDestroy(OWF_NATIVE_STREAM *ns) {
  *
  *  \param width            Stream image buffer width
  *  \param height           Stream image buffer height
- *  \param imageFormat      Stream image buffer format
+ *  \param imageFormat      Stream image buffer format. Buffers are
+ *                          OWF_IMAGE_ALIGNMENT aligned; a rowPadding that
+ *                          is a power of two up to that aligns every row.
  *  \param nbufs            Number of image buffers to allocate
  *
  *  \param Handle to newly created stream or OWF_INVALID_HANDLe if no
@@ -318,24 +324,29 @@ OWF_PUBLIC OWFNativeStreamType owfNativeStreamCreateImageStream(
     OWFint multiFail = 0;
     void **bufferList = NULL;
     OWFint *bufferRefs = NULL;
+    OWFuint32 *bufferSerials = NULL;
     OWF_SYNC_DESC *bufferSyncs = NULL;
     OWFint ii = 0, j = 0;
     OWFint ok = 0;
+    OWFint stride;
 
     OWF_ASSERT(nbufs >= 1);
 
+    stride = OWF_Image_GetStride(width, imageFormat, 0);
+
     /* stream must have at least 2 buffers (front & back) */
     ns = NEW0(OWF_NATIVE_STREAM);
     bufferList = xalloc(sizeof(void *), nbufs);
     bufferRefs = xalloc(sizeof(int *), nbufs);
+    bufferSerials = xalloc(sizeof(OWFuint32), nbufs);
 
     bufferSyncs = xalloc(sizeof(OWF_SYNC_DESC), nbufs);
 
     /* initialize surface/buffer list */
     if (bufferList) {
         for (ii = 0; ii < nbufs; ii++) {
-            bufferList[ii] =
-                OWF_Image_AllocData(width, height, imageFormat->pixelFormat);
+            bufferList[ii] = OWF_Image_AllocDataWithStride(
+                stride, height, imageFormat->pixelFormat);
             if (!bufferList[ii]) {
                 multiFail++;
                 break;
@@ -343,7 +354,8 @@ OWF_PUBLIC OWFNativeStreamType owfNativeStreamCreateImageStream(
         }
     }
 
-    if (!ns || !bufferList || multiFail || !bufferRefs || !bufferSyncs) {
+    if (!ns || !bufferList || multiFail || !bufferRefs || !bufferSerials ||
+        !bufferSyncs) {
         xfree(ns);
         if (bufferList) {
             for (j = 0; j < ii; j++) {
@@ -352,6 +364,7 @@ OWF_PUBLIC OWFNativeStreamType owfNativeStreamCreateImageStream(
         }
         xfree(bufferList);
         xfree(bufferRefs);
+        xfree(bufferSerials);
         xfree(bufferSyncs);
 
         return OWF_INVALID_HANDLE;
@@ -359,15 +372,22 @@ OWF_PUBLIC OWFNativeStreamType owfNativeStreamCreateImageStream(
 
     ns->bufferList = bufferList;
     ns->bufferRefs = bufferRefs;
+    ns->bufferSerials = bufferSerials;
     ns->bufferCount = nbufs;
 
+    /* unwritten buffers all share the first serial */
+    ns->serial = 1;
+    for (ii = 0; ii < nbufs; ii++) {
+        bufferSerials[ii] = ns->serial;
+    }
+
     ns->width = width;
     ns->height = height;
 
     ns->idxFront = 0;
     ns->idxNextFree = 1;
     memcpy(&ns->colorFormat, imageFormat, sizeof(ns->colorFormat));
-    ns->stride = OWF_Image_GetStride(width, imageFormat, 0);
+    ns->stride = stride;
     ns->referenceCount = 1;
     ns->sendNotifications = OWF_TRUE;
     ns->protected = OWF_FALSE;
@@ -634,6 +654,7 @@ OWF_PUBLIC void owfNativeStreamReleaseWriteBuffer(OWFNativeStreamType stream,
     --(ns->bufferRefs[bufferIndex]); /* Decrease buffer's reference count */
     ns->idxFront = bufferIndex;      /* Update front buffer to point to new
                                         front buffer */
+    ns->bufferSerials[bufferIndex] = ++ns->serial;
 
     OWF_Semaphore_Post(&ns->writer);
 
@@ -810,6 +831,35 @@ OWF_PUBLIC void *owfNativeStreamGetBufferPtr(OWFNativeStreamType stream,
     return bufferPtr;
 }
 
+/*!---------------------------------------------------------------------------
+ *  Return content serial of a stream buffer. The serial changes every time
+ *  the buffer is committed to the stream, so consumers may cache data
+ *  derived from a buffer for as long as its serial stays the same.
+ *
+ *  \param stream           Stream handle
+ *  \param buffer           Buffer handle
+ *
+ *  \return Buffer's content serial, or zero if the stream is invalid.
+ *----------------------------------------------------------------------------*/
+OWF_API_CALL OWFuint32
+owfNativeStreamGetBufferSerial(OWFNativeStreamType stream,
+                               OWFNativeStreamBuffer buffer) {
+    OWFuint32 serial;
+
+    OWF_NATIVE_STREAM *ns;
+
+    GET_STREAM(ns, stream);
+    CHECK_STREAM(0);
+
+    OWF_Mutex_Lock(&ns->mutex);
+
+    serial = ns->bufferSerials[HANDLE_TO_INDEX(buffer)];
+
+    OWF_Mutex_Unlock(&ns->mutex);
+
+    return serial;
+}
+
 /*!---------------------------------------------------------------------------
  *  Set/reset stream's protection flag. This flag is used for preventing the
  *  user from deleting a stream that s/he doesn't really own or should
@@ -76,6 +76,18 @@ OWF_API_CALL OWFint OWF_Mutex_Unlock(OWF_MUTEX *mutex) {
     return pthread_mutex_unlock(MUTEX(mutex));
 }
 
+/* serializes all OWF_Once calls; they are few and init is short */
+static pthread_mutex_t onceMutex = PTHREAD_MUTEX_INITIALIZER;
+
+OWF_API_CALL void OWF_Once(OWF_ONCE *once, void (*init)(void)) {
+    pthread_mutex_lock(&onceMutex);
+    if (!*once) {
+        init();
+        *once = 1;
+    }
+    pthread_mutex_unlock(&onceMutex);
+}
+
 #ifdef __cplusplus
 }
 #endif
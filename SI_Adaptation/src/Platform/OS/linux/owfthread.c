@@ -106,6 +106,29 @@ OWF_API_CALL void OWF_Thread_MicroSleep(OWFuint32 usecs) {
 
 OWF_API_CALL void OWF_Thread_Sleep(OWFuint32 secs) { sleep(secs); }
 
+OWF_API_CALL OWFuint64 OWF_Thread_GetNanoTime(void) {
+#if _POSIX_C_SOURCE >= 199309L
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (OWFuint64)ts.tv_sec * 1000000000 + (OWFuint64)ts.tv_nsec;
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (OWFuint64)tv.tv_sec * 1000000000 + (OWFuint64)tv.tv_usec * 1000;
+#endif
+}
+
+OWF_API_CALL OWFint OWF_Thread_GetProcessorCount(void) {
+#ifdef _SC_NPROCESSORS_ONLN
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (count > 0) {
+        return (OWFint)count;
+    }
+#endif
+    return 1;
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,203 @@
+/* Copyright (c) 2009 The Khronos Group Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Materials.
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "owfworkerpool.h"
+
+#include <pthread.h>
+
+#include "owfdebug.h"
+#include "owfmemory.h"
+
+typedef struct OWF_WORKER_POOL_DATA_ OWF_WORKER_POOL_DATA;
+
+typedef struct {
+    OWF_WORKER_POOL_DATA *pool;
+    OWFint index;
+    pthread_t thread;
+} OWF_WORKER;
+
+struct OWF_WORKER_POOL_DATA_ {
+    pthread_mutex_t mutex;
+    /* signalled when a run starts and when the pool is destroyed */
+    pthread_cond_t start;
+    /* signalled when the last item of a run has finished */
+    pthread_cond_t done;
+    OWF_WORKER *workers;
+    OWFint workerCount;
+    OWFint threadCount;
+    /* incremented on every run so that sleeping workers notice it */
+    OWFuint32 generation;
+    OWFboolean quit;
+
+    OWF_WORKER_JOB job;
+    void *data;
+    OWFint items;
+    OWFint nextItem;
+    OWFint unfinished;
+};
+
+#define POOL(x) ((OWF_WORKER_POOL_DATA *)(x))
+
+/* run items of the current run until none are left; called with the
+   pool's mutex held */
+static void OWF_WorkerPool_Work(OWF_WORKER_POOL_DATA *pool, OWFint worker) {
+    while (pool->nextItem < pool->items) {
+        OWFint item = pool->nextItem++;
+
+        pthread_mutex_unlock(&pool->mutex);
+        pool->job(pool->data, item, worker);
+        pthread_mutex_lock(&pool->mutex);
+
+        if (--pool->unfinished == 0) {
+            pthread_cond_signal(&pool->done);
+        }
+    }
+}
+
+static void *OWF_WorkerPool_Thread(void *data) {
+    OWF_WORKER *worker = (OWF_WORKER *)data;
+    OWF_WORKER_POOL_DATA *pool = worker->pool;
+    OWFuint32 generation;
+
+    pthread_mutex_lock(&pool->mutex);
+    generation = pool->generation;
+    for (;;) {
+        while (!pool->quit && pool->generation == generation) {
+            pthread_cond_wait(&pool->start, &pool->mutex);
+        }
+        if (pool->quit) {
+            break;
+        }
+        generation = pool->generation;
+        OWF_WorkerPool_Work(pool, worker->index);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    return NULL;
+}
+
+OWF_API_CALL OWF_WORKER_POOL OWF_WorkerPool_Create(OWFint workers) {
+    OWF_WORKER_POOL_DATA *pool;
+    OWFint i;
+
+    if (workers < 1) {
+        return NULL;
+    }
+
+    pool = xalloc(1, sizeof(OWF_WORKER_POOL_DATA));
+    if (!pool) {
+        return NULL;
+    }
+
+    pool->workers = xalloc(workers, sizeof(OWF_WORKER));
+    if (!pool->workers) {
+        xfree(pool);
+        return NULL;
+    }
+
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    pool->workerCount = workers;
+
+    /* worker 0 is the thread running the jobs */
+    for (i = 1; i < workers; i++) {
+        OWF_WORKER *worker = &pool->workers[i];
+
+        worker->pool = pool;
+        worker->index = i;
+        if (pthread_create(&worker->thread, NULL, OWF_WorkerPool_Thread,
+                           worker)) {
+            DPRINT(("OWF_WorkerPool_Create: only %d of %d workers started",
+                    i, workers));
+            pool->workerCount = i;
+            break;
+        }
+        pool->threadCount++;
+    }
+
+    return (OWF_WORKER_POOL)pool;
+}
+
+OWF_API_CALL OWFint OWF_WorkerPool_GetWorkerCount(OWF_WORKER_POOL pool) {
+    return pool ? POOL(pool)->workerCount : 1;
+}
+
+OWF_API_CALL void OWF_WorkerPool_Run(OWF_WORKER_POOL p, OWFint items,
+                                     OWF_WORKER_JOB job, void *data) {
+    OWF_WORKER_POOL_DATA *pool = POOL(p);
+    OWFint i;
+
+    if (!pool || pool->threadCount == 0 || items < 2) {
+        for (i = 0; i < items; i++) {
+            job(data, i, 0);
+        }
+        return;
+    }
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->job = job;
+    pool->data = data;
+    pool->items = items;
+    pool->nextItem = 0;
+    pool->unfinished = items;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+
+    OWF_WorkerPool_Work(pool, 0);
+    while (pool->unfinished > 0) {
+        pthread_cond_wait(&pool->done, &pool->mutex);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+OWF_API_CALL void OWF_WorkerPool_Destroy(OWF_WORKER_POOL p) {
+    OWF_WORKER_POOL_DATA *pool = POOL(p);
+    OWFint i;
+
+    if (!pool) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->quit = OWF_TRUE;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (i = 1; i <= pool->threadCount; i++) {
+        pthread_join(pool->workers[i].thread, NULL);
+    }
+
+    pthread_mutex_destroy(&pool->mutex);
+    pthread_cond_destroy(&pool->start);
+    pthread_cond_destroy(&pool->done);
+    xfree(pool->workers);
+    xfree(pool);
+}
+
+#ifdef __cplusplus
+}
+#endif
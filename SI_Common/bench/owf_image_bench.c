@@ -0,0 +1,731 @@
+/* Copyright (c) 2009 The Khronos Group Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Materials.
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+/*!
+ * \file owf_image_bench.c
+ * \brief Headless microbenchmark for the SI_Common image kernels.
+ *
+ * Every kernel is run on synthetic images at each selected resolution:
+ * a few untimed warmup runs, then a number of individually timed
+ * repetitions. The median and fastest repetition are reported as
+ * Mpixel/s and ns/pixel of the kernel's output. Results go to stdout as a
+ * table and, with -o, to a CSV or JSON file.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "owfcpu.h"
+#include "owfimage.h"
+#include "owfutils.h"
+
+#define BENCH_MAX_REPS 1000
+
+typedef struct {
+    const char *name;
+    OWFint width;
+    OWFint height;
+} BENCH_RESOLUTION;
+
+static const BENCH_RESOLUTION benchResolutions[] = {
+    {"480p", 854, 480},
+    {"720p", 1280, 720},
+    {"1080p", 1920, 1080},
+    {"1440p", 2560, 1440},
+    {"4k", 3840, 2160}};
+
+#define BENCH_RESOLUTION_COUNT \
+    (sizeof(benchResolutions) / sizeof(benchResolutions[0]))
+
+/* images shared by all kernels of one resolution */
+typedef struct {
+    OWFint width;
+    OWFint height;
+
+    /* source and mask formats */
+    OWF_IMAGE *argb;
+    OWF_IMAGE *xrgb;
+    OWF_IMAGE *rgb565;
+    OWF_IMAGE *nv12;
+    OWF_IMAGE *i420;
+    OWF_IMAGE *yuyv;
+    OWF_IMAGE *l1;
+    OWF_IMAGE *l8;
+
+    /* internal format: translucent premultiplied source, blend target,
+       a scratch image for kernel output and an opaque source half of
+       whose pixels match colorKey */
+    OWF_IMAGE *src;
+    OWF_IMAGE *dst;
+    OWF_IMAGE *tmp;
+    OWF_IMAGE *keyed;
+
+    /* converted mask */
+    OWF_IMAGE *mask;
+
+    /* destination format */
+    OWF_IMAGE *out;
+
+    OWF_BLEND_INFO blend;
+    OWF_RECTANGLE blendRect;
+    OWFpixel colorKey;
+} BENCH_DATA;
+
+typedef struct {
+    const char *name;
+    /* sets up a run; returns the number of output pixels, 0 to skip */
+    OWFint (*prepare)(BENCH_DATA *data, OWFint param, OWFfloat scale);
+    /* untimed, before every run; may be NULL */
+    void (*reset)(BENCH_DATA *data);
+    void (*run)(BENCH_DATA *data, OWFint param, OWFfloat scale);
+    OWFint param;
+    OWFfloat scale;
+} BENCH_CASE;
+
+typedef struct {
+    OWFint reps;
+    OWFint warmup;
+    const char *kernelFilter;
+    const char *resolutions;
+    const char *outputFile;
+    OWFboolean json;
+    OWFboolean noSimd;
+} BENCH_OPTIONS;
+
+/*----------------------------------------------------------------------------*/
+static double Bench_Now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static int Bench_CompareDouble(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+/* small deterministic generator so that runs are comparable */
+static OWFuint32 benchSeed = 12345;
+
+static OWFuint32 Bench_Random(void) {
+    benchSeed = benchSeed * 1103515245 + 12345;
+    return benchSeed >> 8;
+}
+
+static void Bench_FillRandom(OWF_IMAGE *image) {
+    OWFuint8 *bytes = (OWFuint8 *)image->data;
+    OWFint i;
+
+    for (i = 0; i < image->dataMax; i++) {
+        bytes[i] = (OWFuint8)Bench_Random();
+    }
+}
+
+/* translucent premultiplied ARGB8888 */
+static void Bench_FillArgb(OWF_IMAGE *image) {
+    OWFint x, y;
+
+    for (y = 0; y < image->height; y++) {
+        OWFuint32 *row =
+            (OWFuint32 *)((OWFuint8 *)image->data + y * image->stride);
+
+        for (x = 0; x < image->width; x++) {
+            OWFuint32 a = Bench_Random() & 0xFF;
+            OWFuint32 r = (Bench_Random() & 0xFF) * a / 255;
+            OWFuint32 g = (Bench_Random() & 0xFF) * a / 255;
+            OWFuint32 b = (Bench_Random() & 0xFF) * a / 255;
+
+            row[x] = (a << ARGB8888_ALPHA_SHIFT) | (r << ARGB8888_RED_SHIFT) |
+                     (g << ARGB8888_GREEN_SHIFT) | (b << ARGB8888_BLUE_SHIFT);
+        }
+    }
+}
+
+/*
+ * Opaque source for color keying. Half of the pixels are set to the key:
+ * in each 32 pixels, runs of 8 first and then every other pixel, so both
+ * long runs and single pixels are skipped.
+ */
+static void Bench_FillKeyed(BENCH_DATA *data) {
+    OWFint x, y;
+
+    OWF_Image_SourceFormatConversion(data->keyed, data->xrgb);
+    data->colorKey = *(OWFpixel *)data->keyed->data;
+    data->colorKey.color.red = OWF_SUBPIXEL_FROM_BYTE(0x12);
+    data->colorKey.color.green = OWF_SUBPIXEL_FROM_BYTE(0x34);
+    data->colorKey.color.blue = OWF_SUBPIXEL_FROM_BYTE(0x56);
+
+    for (y = 0; y < data->keyed->height; y++) {
+        OWFpixel *row = (OWFpixel *)((OWFuint8 *)data->keyed->data +
+                                     y * data->keyed->stride);
+
+        for (x = 0; x < data->keyed->width; x++) {
+            if ((x & 16) ? (x & 1) : (x & 8)) {
+                row[x] = data->colorKey;
+            }
+        }
+    }
+}
+
+static OWF_IMAGE *Bench_CreateImage(OWFint width, OWFint height,
+                                    OWF_PIXEL_FORMAT pixelFormat) {
+    OWF_IMAGE_FORMAT format;
+
+    memset(&format, 0, sizeof(format));
+    format.pixelFormat = pixelFormat;
+    format.premultiplied = OWF_TRUE;
+    format.rowPadding = OWF_Image_GetFormatPadding(pixelFormat);
+    format.yuvColorSpace = OWF_YUV_BT709_LIMITED;
+
+    return OWF_Image_Create(width, height, &format, NULL, 0);
+}
+
+static void Bench_DestroyData(BENCH_DATA *data) {
+    OWF_Image_Destroy(data->argb);
+    OWF_Image_Destroy(data->xrgb);
+    OWF_Image_Destroy(data->rgb565);
+    OWF_Image_Destroy(data->nv12);
+    OWF_Image_Destroy(data->i420);
+    OWF_Image_Destroy(data->yuyv);
+    OWF_Image_Destroy(data->l1);
+    OWF_Image_Destroy(data->l8);
+    OWF_Image_Destroy(data->src);
+    OWF_Image_Destroy(data->dst);
+    OWF_Image_Destroy(data->tmp);
+    OWF_Image_Destroy(data->keyed);
+    OWF_Image_Destroy(data->mask);
+    OWF_Image_Destroy(data->out);
+    memset(data, 0, sizeof(*data));
+}
+
+static OWFboolean Bench_CreateData(BENCH_DATA *data, OWFint width,
+                                   OWFint height) {
+    memset(data, 0, sizeof(*data));
+    data->width = width;
+    data->height = height;
+
+    data->argb = Bench_CreateImage(width, height, OWF_IMAGE_ARGB8888);
+    data->xrgb = Bench_CreateImage(width, height, OWF_IMAGE_XRGB8888);
+    data->rgb565 = Bench_CreateImage(width, height, OWF_IMAGE_RGB565);
+    data->nv12 = Bench_CreateImage(width, height, OWF_IMAGE_NV12);
+    data->i420 = Bench_CreateImage(width, height, OWF_IMAGE_I420);
+    data->yuyv = Bench_CreateImage(width, height, OWF_IMAGE_YUYV);
+    data->l1 = Bench_CreateImage(width, height, OWF_IMAGE_L1);
+    data->l8 = Bench_CreateImage(width, height, OWF_IMAGE_L8);
+    data->src = Bench_CreateImage(width, height, OWF_IMAGE_ARGB_INTERNAL);
+    data->dst = Bench_CreateImage(width, height, OWF_IMAGE_ARGB_INTERNAL);
+    data->tmp = Bench_CreateImage(width, height, OWF_IMAGE_ARGB_INTERNAL);
+    data->keyed = Bench_CreateImage(width, height, OWF_IMAGE_ARGB_INTERNAL);
+    data->mask = Bench_CreateImage(width, height, OWF_IMAGE_L32);
+    data->out = Bench_CreateImage(width, height, OWF_IMAGE_ARGB8888);
+
+    if (!data->argb || !data->xrgb || !data->rgb565 || !data->nv12 ||
+        !data->i420 || !data->yuyv || !data->l1 || !data->l8 || !data->src ||
+        !data->dst || !data->tmp || !data->keyed || !data->mask ||
+        !data->out) {
+        Bench_DestroyData(data);
+        return OWF_FALSE;
+    }
+
+    Bench_FillArgb(data->argb);
+    Bench_FillRandom(data->xrgb);
+    Bench_FillRandom(data->rgb565);
+    Bench_FillRandom(data->nv12);
+    Bench_FillRandom(data->i420);
+    Bench_FillRandom(data->yuyv);
+    Bench_FillRandom(data->l1);
+    Bench_FillRandom(data->l8);
+
+    OWF_Image_SourceFormatConversion(data->src, data->argb);
+    OWF_Image_SourceFormatConversion(data->dst, data->xrgb);
+    OWF_Image_ConvertMask(data->mask, data->l8);
+    Bench_FillKeyed(data);
+
+    return OWF_TRUE;
+}
+
+/* undo the size changes of earlier kernels */
+static void Bench_ResetSizes(BENCH_DATA *data) {
+    OWF_Image_SetSize(data->tmp, data->width, data->height);
+    OWF_Image_SetFlags(data->tmp, OWF_TRUE, OWF_FALSE);
+}
+
+/*----------------------------------------------------------------------------*/
+static OWFint Bench_PrepareBlend(BENCH_DATA *data, OWFint param,
+                                 OWFfloat scale) {
+    (void)scale;
+
+    Bench_ResetSizes(data);
+    OWF_Rect_Set(&data->blendRect, 0, 0, data->width, data->height);
+    data->blend.destination.image = data->dst;
+    data->blend.destination.rectangle = &data->blendRect;
+    data->blend.source.image = data->src;
+    data->blend.source.rectangle = &data->blendRect;
+    data->blend.mask = (param & OWF_TRANSPARENCY_MASK) ? data->mask : NULL;
+    data->blend.globalAlpha = OWF_ALPHA_MAX_VALUE / 2;
+    data->blend.destinationFullyOpaque = OWF_FALSE;
+    data->blend.tsColor = NULL;
+
+    if (param & OWF_TRANSPARENCY_COLOR_KEY) {
+        data->blend.source.image = data->keyed;
+        data->blend.destination.image = data->tmp;
+        data->blend.tsColor = &data->colorKey;
+    }
+
+    return data->width * data->height;
+}
+
+static void Bench_RunBlend(BENCH_DATA *data, OWFint param, OWFfloat scale) {
+    (void)scale;
+
+    OWF_Image_Blend(&data->blend,
+                    (OWF_TRANSPARENCY)(param & ~OWF_TRANSPARENCY_COLOR_KEY));
+}
+
+/*----------------------------------------------------------------------------*/
+static OWFint Bench_PrepareStretch(BENCH_DATA *data, OWFint param,
+                                   OWFfloat scale) {
+    (void)param;
+
+    Bench_ResetSizes(data);
+    /* neither image may exceed the resolution: downscales read all of the
+       source, upscales fill all of the destination */
+    if (scale < 1.0f) {
+        return (OWFint)(data->width * scale) * (OWFint)(data->height * scale);
+    }
+    return data->width * data->height;
+}
+
+static void Bench_RunStretch(BENCH_DATA *data, OWFint param, OWFfloat scale) {
+    OWF_RECTANGLE dstRect;
+    OWFfloat srcRect[4];
+
+    srcRect[0] = 0.0f;
+    srcRect[1] = 0.0f;
+    if (scale < 1.0f) {
+        srcRect[2] = (OWFfloat)data->width;
+        srcRect[3] = (OWFfloat)data->height;
+        OWF_Rect_Set(&dstRect, 0, 0, (OWFint)(data->width * scale),
+                     (OWFint)(data->height * scale));
+    } else {
+        srcRect[2] = data->width / scale;
+        srcRect[3] = data->height / scale;
+        OWF_Rect_Set(&dstRect, 0, 0, data->width, data->height);
+    }
+
+    OWF_Image_Stretch(data->tmp, &dstRect, data->src, srcRect,
+                      (OWF_FILTERING)param);
+}
+
+/*----------------------------------------------------------------------------*/
+static OWFint Bench_PrepareRotate(BENCH_DATA *data, OWFint param,
+                                  OWFfloat scale) {
+    (void)scale;
+
+    if (param == OWF_ROTATION_90 || param == OWF_ROTATION_270) {
+        OWF_Image_SetSize(data->tmp, data->height, data->width);
+    } else {
+        OWF_Image_SetSize(data->tmp, data->width, data->height);
+    }
+    return data->width * data->height;
+}
+
+static void Bench_RunRotate(BENCH_DATA *data, OWFint param, OWFfloat scale) {
+    (void)scale;
+
+    OWF_Image_Rotate(data->tmp, data->src, (OWF_ROTATION)param);
+}
+
+/*----------------------------------------------------------------------------*/
+static OWFint Bench_PrepareFull(BENCH_DATA *data, OWFint param,
+                                OWFfloat scale) {
+    (void)param;
+    (void)scale;
+
+    Bench_ResetSizes(data);
+    return data->width * data->height;
+}
+
+static void Bench_RunFlip(BENCH_DATA *data, OWFint param, OWFfloat scale) {
+    (void)scale;
+
+    OWF_Image_Flip(data->tmp, (OWF_FLIP_DIRECTION)param);
+}
+
+static void Bench_RunClear(BENCH_DATA *data, OWFint param, OWFfloat scale) {
+    (void)param;
+    (void)scale;
+
+    OWF_Image_Clear(data->tmp, OWF_RED_MAX_VALUE / 2, OWF_GREEN_MAX_VALUE / 4,
+                    OWF_BLUE_MAX_VALUE, OWF_ALPHA_MAX_VALUE / 2);
+}
+
+/* premultiplying works in place, so it starts from the source every run */
+static void Bench_ResetPremultiply(BENCH_DATA *data) {
+    memcpy(data->tmp->data, data->src->data,
+           data->src->stride * data->src->height);
+    OWF_Image_SetFlags(data->tmp, OWF_FALSE, OWF_FALSE);
+    data->tmp->format.opaque = OWF_FALSE;
+}
+
+static void Bench_RunPremultiply(BENCH_DATA *data, OWFint param,
+                                 OWFfloat scale) {
+    (void)param;
+    (void)scale;
+
+    OWF_Image_PremultiplyAlpha(data->tmp);
+}
+
+/*----------------------------------------------------------------------------*/
+static OWF_IMAGE *Bench_SourceImage(BENCH_DATA *data, OWFint format) {
+    switch (format) {
+        case OWF_IMAGE_ARGB8888:
+            return data->argb;
+        case OWF_IMAGE_XRGB8888:
+            return data->xrgb;
+        case OWF_IMAGE_RGB565:
+            return data->rgb565;
+        case OWF_IMAGE_NV12:
+            return data->nv12;
+        case OWF_IMAGE_I420:
+            return data->i420;
+        case OWF_IMAGE_YUYV:
+            return data->yuyv;
+        case OWF_IMAGE_L1:
+            return data->l1;
+        case OWF_IMAGE_L8:
+            return data->l8;
+        default:
+            return NULL;
+    }
+}
+
+static void Bench_RunSourceConversion(BENCH_DATA *data, OWFint param,
+                                      OWFfloat scale) {
+    (void)scale;
+
+    OWF_Image_SourceFormatConversion(data->tmp,
+                                     Bench_SourceImage(data, param));
+}
+
+static void Bench_RunMaskConversion(BENCH_DATA *data, OWFint param,
+                                    OWFfloat scale) {
+    (void)scale;
+
+    OWF_Image_ConvertMask(data->mask, Bench_SourceImage(data, param));
+}
+
+/* param: destination format; scale: non-zero for a non-premultiplied
+   destination */
+static OWFint Bench_PrepareDestinationConversion(BENCH_DATA *data,
+                                                 OWFint param,
+                                                 OWFfloat scale) {
+    data->out->format.pixelFormat = (OWF_PIXEL_FORMAT)param;
+    data->out->format.premultiplied = (scale != 0.0f) ? OWF_FALSE : OWF_TRUE;
+    return data->width * data->height;
+}
+
+static void Bench_RunDestinationConversion(BENCH_DATA *data, OWFint param,
+                                           OWFfloat scale) {
+    (void)param;
+    (void)scale;
+
+    OWF_Image_DestinationFormatConversion(data->out, data->src);
+}
+
+/*----------------------------------------------------------------------------*/
+#define BLEND_CASE(name, mode) \
+    {name, Bench_PrepareBlend, NULL, Bench_RunBlend, mode, 0.0f}
+#define STRETCH_CASE(name, filter, scale) \
+    {name, Bench_PrepareStretch, NULL, Bench_RunStretch, filter, scale}
+#define FULL_CASE(name, run, param) \
+    {name, Bench_PrepareFull, NULL, run, param, 0.0f}
+
+static const BENCH_CASE benchCases[] = {
+    BLEND_CASE("blend_none", OWF_TRANSPARENCY_NONE),
+    BLEND_CASE("blend_ga", OWF_TRANSPARENCY_GLOBAL_ALPHA),
+    BLEND_CASE("blend_sa", OWF_TRANSPARENCY_SOURCE_ALPHA),
+    BLEND_CASE("blend_mask", OWF_TRANSPARENCY_MASK),
+    BLEND_CASE("blend_ga_sa",
+               OWF_TRANSPARENCY_GLOBAL_ALPHA | OWF_TRANSPARENCY_SOURCE_ALPHA),
+    BLEND_CASE("blend_ga_mask",
+               OWF_TRANSPARENCY_GLOBAL_ALPHA | OWF_TRANSPARENCY_MASK),
+    BLEND_CASE("blend_colorkey", OWF_TRANSPARENCY_COLOR_KEY),
+
+    STRETCH_CASE("stretch_point_x0.5", OWF_FILTER_POINT_SAMPLING, 0.5f),
+    STRETCH_CASE("stretch_point_x0.75", OWF_FILTER_POINT_SAMPLING, 0.75f),
+    STRETCH_CASE("stretch_point_x1.5", OWF_FILTER_POINT_SAMPLING, 1.5f),
+    STRETCH_CASE("stretch_point_x2", OWF_FILTER_POINT_SAMPLING, 2.0f),
+    STRETCH_CASE("stretch_bilinear_x0.5", OWF_FILTER_BILINEAR, 0.5f),
+    STRETCH_CASE("stretch_bilinear_x0.75", OWF_FILTER_BILINEAR, 0.75f),
+    STRETCH_CASE("stretch_bilinear_x1.5", OWF_FILTER_BILINEAR, 1.5f),
+    STRETCH_CASE("stretch_bilinear_x2", OWF_FILTER_BILINEAR, 2.0f),
+
+    {"rotate_90", Bench_PrepareRotate, NULL, Bench_RunRotate,
+     OWF_ROTATION_90, 0.0f},
+    {"rotate_180", Bench_PrepareRotate, NULL, Bench_RunRotate,
+     OWF_ROTATION_180, 0.0f},
+    {"rotate_270", Bench_PrepareRotate, NULL, Bench_RunRotate,
+     OWF_ROTATION_270, 0.0f},
+
+    FULL_CASE("flip_vertical", Bench_RunFlip, OWF_FLIP_VERTICALLY),
+    FULL_CASE("flip_horizontal", Bench_RunFlip, OWF_FLIP_HORIZONTALLY),
+
+    FULL_CASE("srcconv_argb8888", Bench_RunSourceConversion,
+              OWF_IMAGE_ARGB8888),
+    FULL_CASE("srcconv_xrgb8888", Bench_RunSourceConversion,
+              OWF_IMAGE_XRGB8888),
+    FULL_CASE("srcconv_rgb565", Bench_RunSourceConversion, OWF_IMAGE_RGB565),
+    FULL_CASE("srcconv_nv12", Bench_RunSourceConversion, OWF_IMAGE_NV12),
+    FULL_CASE("srcconv_i420", Bench_RunSourceConversion, OWF_IMAGE_I420),
+    FULL_CASE("srcconv_yuyv", Bench_RunSourceConversion, OWF_IMAGE_YUYV),
+
+    {"dstconv_argb8888", Bench_PrepareDestinationConversion, NULL,
+     Bench_RunDestinationConversion, OWF_IMAGE_ARGB8888, 0.0f},
+    {"dstconv_argb8888_unpremultiply", Bench_PrepareDestinationConversion,
+     NULL, Bench_RunDestinationConversion, OWF_IMAGE_ARGB8888, 1.0f},
+    {"dstconv_xrgb8888", Bench_PrepareDestinationConversion, NULL,
+     Bench_RunDestinationConversion, OWF_IMAGE_XRGB8888, 0.0f},
+
+    FULL_CASE("mask_l1", Bench_RunMaskConversion, OWF_IMAGE_L1),
+    FULL_CASE("mask_l8", Bench_RunMaskConversion, OWF_IMAGE_L8),
+    FULL_CASE("mask_argb8888", Bench_RunMaskConversion, OWF_IMAGE_ARGB8888),
+
+    FULL_CASE("clear", Bench_RunClear, 0),
+    {"premultiply", Bench_PrepareFull, Bench_ResetPremultiply,
+     Bench_RunPremultiply, 0, 0.0f}};
+
+#define BENCH_CASE_COUNT (sizeof(benchCases) / sizeof(benchCases[0]))
+
+/*----------------------------------------------------------------------------*/
+static void Bench_Usage(const char *program) {
+    printf(
+        "usage: %s [options]\n"
+        "  -r N        timed repetitions per kernel (default 10, max %d)\n"
+        "  -w N        untimed warmup runs per kernel (default 2)\n"
+        "  -s LIST     comma separated resolutions (default all):\n"
+        "              480p, 720p, 1080p, 1440p, 4k\n"
+        "  -k TEXT     only kernels whose name contains TEXT\n"
+        "  -n          disable SIMD kernels\n"
+        "  -o FILE     write results to FILE as CSV\n"
+        "  -j          write JSON instead of CSV\n",
+        program, BENCH_MAX_REPS);
+}
+
+static OWFboolean Bench_ParseOptions(BENCH_OPTIONS *options, int argc,
+                                     char **argv) {
+    int i;
+
+    options->reps = 10;
+    options->warmup = 2;
+    options->kernelFilter = NULL;
+    options->resolutions = NULL;
+    options->outputFile = NULL;
+    options->json = OWF_FALSE;
+    options->noSimd = OWF_FALSE;
+
+    for (i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (!strcmp(arg, "-n")) {
+            options->noSimd = OWF_TRUE;
+        } else if (!strcmp(arg, "-j")) {
+            options->json = OWF_TRUE;
+        } else if (value && !strcmp(arg, "-r")) {
+            options->reps = atoi(value);
+            i++;
+        } else if (value && !strcmp(arg, "-w")) {
+            options->warmup = atoi(value);
+            i++;
+        } else if (value && !strcmp(arg, "-s")) {
+            options->resolutions = value;
+            i++;
+        } else if (value && !strcmp(arg, "-k")) {
+            options->kernelFilter = value;
+            i++;
+        } else if (value && !strcmp(arg, "-o")) {
+            options->outputFile = value;
+            i++;
+        } else {
+            return OWF_FALSE;
+        }
+    }
+
+    return (options->reps >= 1 && options->reps <= BENCH_MAX_REPS &&
+            options->warmup >= 0)
+               ? OWF_TRUE
+               : OWF_FALSE;
+}
+
+/* whole-word match in a comma separated list */
+static OWFboolean Bench_ListContains(const char *list, const char *name) {
+    size_t length = strlen(name);
+
+    while (list && *list) {
+        if (!strncmp(list, name, length) &&
+            (list[length] == ',' || list[length] == '\0')) {
+            return OWF_TRUE;
+        }
+        list = strchr(list, ',');
+        if (list) {
+            list++;
+        }
+    }
+    return OWF_FALSE;
+}
+
+/*----------------------------------------------------------------------------*/
+int main(int argc, char **argv) {
+    BENCH_OPTIONS options;
+    FILE *output = NULL;
+    OWFboolean firstRecord = OWF_TRUE;
+    double times[BENCH_MAX_REPS];
+    size_t r, c;
+    OWFint i;
+
+    if (!Bench_ParseOptions(&options, argc, argv)) {
+        Bench_Usage(argv[0]);
+        return 1;
+    }
+
+    if (options.noSimd) {
+        OWF_Cpu_SetFeatureMask(0);
+    }
+
+    if (options.outputFile) {
+        output = fopen(options.outputFile, "w");
+        if (!output) {
+            printf("cannot open %s\n", options.outputFile);
+            return 1;
+        }
+        if (options.json) {
+            fprintf(output, "[\n");
+        } else {
+            fprintf(output,
+                    "kernel,resolution,width,height,pixels,simd,reps,"
+                    "median_ns,min_ns,mpixel_per_s,ns_per_pixel\n");
+        }
+    }
+
+    printf("%-32s %-6s %12s %12s %12s\n", "kernel", "res", "Mpixel/s",
+           "ns/pixel", "min ns/px");
+
+    for (r = 0; r < BENCH_RESOLUTION_COUNT; r++) {
+        const BENCH_RESOLUTION *res = &benchResolutions[r];
+        BENCH_DATA data;
+
+        if (options.resolutions &&
+            !Bench_ListContains(options.resolutions, res->name)) {
+            continue;
+        }
+
+        if (!Bench_CreateData(&data, res->width, res->height)) {
+            printf("%s: out of memory, skipped\n", res->name);
+            continue;
+        }
+
+        for (c = 0; c < BENCH_CASE_COUNT; c++) {
+            const BENCH_CASE *bc = &benchCases[c];
+            OWFint pixels;
+            double median, fastest, mpixels, nsPerPixel;
+
+            if (options.kernelFilter &&
+                !strstr(bc->name, options.kernelFilter)) {
+                continue;
+            }
+
+            pixels = bc->prepare(&data, bc->param, bc->scale);
+            if (pixels <= 0) {
+                continue;
+            }
+
+            for (i = 0; i < options.warmup; i++) {
+                if (bc->reset) {
+                    bc->reset(&data);
+                }
+                bc->run(&data, bc->param, bc->scale);
+            }
+
+            for (i = 0; i < options.reps; i++) {
+                double start;
+
+                if (bc->reset) {
+                    bc->reset(&data);
+                }
+                start = Bench_Now();
+                bc->run(&data, bc->param, bc->scale);
+                times[i] = Bench_Now() - start;
+            }
+
+            qsort(times, options.reps, sizeof(times[0]), Bench_CompareDouble);
+            median = times[options.reps / 2];
+            fastest = times[0];
+            nsPerPixel = median / pixels;
+            mpixels = (median > 0.0) ? pixels * 1e3 / median : 0.0;
+
+            printf("%-32s %-6s %12.1f %12.3f %12.3f\n", bc->name, res->name,
+                   mpixels, nsPerPixel, fastest / pixels);
+            fflush(stdout);
+
+            if (!output) {
+                continue;
+            }
+            if (options.json) {
+                fprintf(output,
+                        "%s  {\"kernel\": \"%s\", \"resolution\": \"%s\", "
+                        "\"width\": %d, \"height\": %d, \"pixels\": %d, "
+                        "\"simd\": %s, \"reps\": %d, \"median_ns\": %.0f, "
+                        "\"min_ns\": %.0f, \"mpixel_per_s\": %.3f, "
+                        "\"ns_per_pixel\": %.4f}",
+                        firstRecord ? "" : ",\n", bc->name, res->name,
+                        res->width, res->height, pixels,
+                        options.noSimd ? "false" : "true", options.reps,
+                        median, fastest, mpixels, nsPerPixel);
+            } else {
+                fprintf(output, "%s,%s,%d,%d,%d,%d,%d,%.0f,%.0f,%.3f,%.4f\n",
+                        bc->name, res->name, res->width, res->height, pixels,
+                        options.noSimd ? 0 : 1, options.reps, median, fastest,
+                        mpixels, nsPerPixel);
+            }
+            firstRecord = OWF_FALSE;
+        }
+
+        Bench_DestroyData(&data);
+    }
+
+    if (output) {
+        if (options.json) {
+            fprintf(output, "\n]\n");
+        }
+        fclose(output);
+    }
+
+    return 0;
+}
@@ -0,0 +1,59 @@
+/* Copyright (c) 2009 The Khronos Group Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Materials.
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+#ifndef OWFCPU_H_
+#define OWFCPU_H_
+
+#include "owftypes.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* instruction set extensions usable by the image kernels */
+#define OWF_CPU_FEATURE_SSE2 (1 << 0)
+#define OWF_CPU_FEATURE_AVX2 (1 << 1)
+#define OWF_CPU_FEATURE_NEON (1 << 2)
+
+/*!---------------------------------------------------------------------------
+ *  \brief Query instruction set extensions supported by both the build and
+ *  the CPU the code is running on. Detection is done once; the result is
+ *  cached and filtered through the current feature mask.
+ *
+ *  \return Bitwise-or of OWF_CPU_FEATURE_* flags
+ *----------------------------------------------------------------------------*/
+OWF_API_CALL OWFuint32 OWF_Cpu_GetFeatures(void);
+
+/*!---------------------------------------------------------------------------
+ *  \brief Restrict the features reported by OWF_Cpu_GetFeatures. Mostly
+ *  useful for forcing the scalar reference kernels (mask 0) when verifying
+ *  or benchmarking vectorized code paths.
+ *
+ *  \param mask             Bitwise-or of OWF_CPU_FEATURE_* flags to allow
+ *----------------------------------------------------------------------------*/
+OWF_API_CALL void OWF_Cpu_SetFeatureMask(OWFuint32 mask);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OWFCPU_H_ */
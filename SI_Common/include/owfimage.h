@@ -35,8 +35,15 @@ extern "C" {
  * This is and always should be the only place where USE_FLOAT_PIXEL is
  * defined so if #define USE_FLOAT_PIXEL is absent in owfimage.h then it
  * can be assumed it is not defined elsewhere.
+ *
+ * Defining OWF_USE_INTEGER_PIXEL at build time (CMake option
+ * OPENWF_INTEGER_PIXEL) selects the packed 8-bit-per-channel internal
+ * format instead, which carries 4 bytes per pixel through the pipelines
+ * rather than 16.
  */
+#ifndef OWF_USE_INTEGER_PIXEL
 #define USE_FLOAT_PIXEL
+#endif
 
 /* --
  * internal pixel format
@@ -64,6 +71,11 @@ typedef OWFfloat OWFsubpixel; /* subpixel representation */
 #define OWF_BILINEAR_ROUNDING_VALUE 0.0f
 #define OWF_BLEND_ROUNDING_VALUE 0.0f
 #define OWF_PREMUL_ROUNDING_FACTOR 0.0f
+#define OWF_CONVERSION_ROUNDING_VALUE 0.0f
+
+/* map 8-bit channel value / normalized [0, 1] float to subpixel */
+#define OWF_SUBPIXEL_FROM_BYTE(b) ((OWFsubpixel)(b) / OWF_BYTE_MAX_VALUE)
+#define OWF_SUBPIXEL_FROM_FLOAT(f) ((OWFsubpixel)(f))
 
 #else
 #undef OWF_IMAGE_INTERNAL_PIXEL_IS_FLOAT
@@ -86,6 +98,12 @@ typedef OWFuint8 OWFsubpixel; /* subpixel representation */
 #define OWF_BILINEAR_ROUNDING_VALUE 0.5f
 #define OWF_BLEND_ROUNDING_VALUE (OWF_ALPHA_MAX_VALUE / 2)
 #define OWF_PREMUL_ROUNDING_FACTOR (OWF_ALPHA_MAX_VALUE / 2)
+#define OWF_CONVERSION_ROUNDING_VALUE 0.5f
+
+/* map 8-bit channel value / normalized [0, 1] float to subpixel */
+#define OWF_SUBPIXEL_FROM_BYTE(b) ((OWFsubpixel)(b))
+#define OWF_SUBPIXEL_FROM_FLOAT(f) \
+    ((OWFsubpixel)((f) * OWF_BYTE_MAX_VALUE + 0.5f))
 
 #endif
 
@@ -139,9 +157,30 @@ typedef union {
 /* filters used in OWF_Image_Stretch */
 typedef enum {
     OWF_FILTER_POINT_SAMPLING, /* nearest pixel */
-    OWF_FILTER_BILINEAR        /* nearest 4 */
+    OWF_FILTER_BILINEAR,       /* nearest 4 */
+    OWF_FILTER_AREA,           /* average of covered pixels */
+    OWF_FILTER_LANCZOS2        /* separable Lanczos, 2 lobes */
 } OWF_FILTERING;
 
+/* Byte alignment of buffers allocated by OWF_Image_AllocData, a power of
+ * two. Defining OWF_IMAGE_ALIGNMENT at build time (CMake option
+ * OPENWF_IMAGE_ALIGNMENT) overrides the default of one cache line.
+ */
+#ifndef OWF_IMAGE_ALIGNMENT
+#define OWF_IMAGE_ALIGNMENT 64
+#endif
+
+/* Rows of internal format images are padded to a multiple of this many
+ * bytes, a power of two, whatever rowPadding the image was created with.
+ * Defining OWF_IMAGE_ROW_ALIGNMENT at build time (CMake option
+ * OPENWF_IMAGE_ROW_ALIGNMENT) overrides the default of OWF_IMAGE_ALIGNMENT;
+ * the pixel size gives packed rows. The alignment field of an image
+ * records how far its data and rows are aligned.
+ */
+#ifndef OWF_IMAGE_ROW_ALIGNMENT
+#define OWF_IMAGE_ROW_ALIGNMENT OWF_IMAGE_ALIGNMENT
+#endif
+
 typedef struct {
     OWFint width;
     OWFint height;
@@ -151,6 +190,7 @@ typedef struct {
     OWFboolean foreign;
     OWFint dataMax; /* data buffer max size */
     void *data;
+    OWFint alignment; /* byte alignment of data and of every row start */
 } OWF_IMAGE;
 
 /* This typedef denotes an owned OWF_IMAGE, as opposed to a temporary
@@ -197,6 +237,17 @@ typedef struct _OWF_BLEND_INFO {
     OWFpixel *tsColor;
 } OWF_BLEND_INFO;
 
+/* Converted mask keyed on the identity of the mask buffer it was made
+ * from: the buffer's pixel pointer and its content serial. */
+typedef struct {
+    OWF_IMAGE *image;
+    const void *pixels;
+    OWFuint32 serial;
+} OWF_MASK_CACHE;
+
+/* Content serial meaning "unknown"; masks with it are always converted */
+#define OWF_MASK_SERIAL_NONE 0
+
 /*!---------------------------------------------------------------------------
  *  \brief Initialize image object
  *
@@ -323,9 +374,48 @@ OWF_API_CALL OWFboolean OWF_Image_Stretch(OWF_IMAGE *dst,
                                           OWF_IMAGE *src, OWFfloat *srcRect,
                                           OWF_FILTERING filter);
 
+/*!---------------------------------------------------------------------------
+ *  \brief Flip, rotate and stretch-blit an image in a single pass.
+ *
+ *  The result equals flipping the source with OWF_Image_Flip, rotating it
+ *  with OWF_Image_Rotate and stretching srcRect of the rotated image into
+ *  dstRect, but no intermediate image is written.
+ *
+ *  \param dst              Destination image
+ *  \param dstRect          Destination rectangle
+ *  \param src              Source image
+ *  \param srcRect          Source rectangle, in flipped and rotated
+ *                          source coordinates
+ *  \param rotation         Clockwise rotation applied after flipping
+ *  \param flip             Flip direction(s) applied to the source
+ *  \param filter           Resampling filter
+ *
+ *  \return Boolean value indicating whether pixels were copied or not.
+ *----------------------------------------------------------------------------*/
+OWF_API_CALL OWFboolean OWF_Image_Transform(OWF_IMAGE *dst,
+                                            OWF_RECTANGLE *dstRect,
+                                            OWF_IMAGE *src, OWFfloat *srcRect,
+                                            OWF_ROTATION rotation,
+                                            OWF_FLIP_DIRECTION flip,
+                                            OWF_FILTERING filter);
+
+/*!---------------------------------------------------------------------------
+ *  \brief Select the best-quality stretch filter for a scaling ratio.
+ *  Bilinear is used up to 2x minification, Lanczos-2 up to 4x and area
+ *  averaging beyond that.
+ *
+ *  \param xRatio           Source width divided by destination width
+ *  \param yRatio           Source height divided by destination height
+ *
+ *  \return Filter to pass to OWF_Image_Stretch
+ *----------------------------------------------------------------------------*/
+OWF_API_CALL OWF_FILTERING OWF_Image_SelectQualityFilter(OWFfloat xRatio,
+                                                         OWFfloat yRatio);
+
 /*!---------------------------------------------------------------------------
  *  \brief Multiply pixels' alpha value into rgb-color components.
- *  Multiplies only if image source image is non-premultiplied.
+ *  Multiplies only if image source image is non-premultiplied and not
+ *  opaque; for an opaque image only the premultiplied flag changes.
  *  \param image            Image to convert to pre-multiplied domain.
  *----------------------------------------------------------------------------*/
 OWF_API_CALL void OWF_Image_PremultiplyAlpha(OWF_IMAGE *image);
@@ -382,11 +472,11 @@ OWF_API_CALL void OWF_Image_Rotate(OWF_IMAGE *dst, OWF_IMAGE *src,
                                    OWF_ROTATION rotation);
 
 /*!---------------------------------------------------------------------------
- *  \brief
+ *  \brief Blend source image onto destination image. Source alpha
+ *  transparency is ignored for opaque source images.
  *
- *  \param
- *
- *  \return
+ *  \param blend            Blend parameters
+ *  \param transparency     Transparency types to apply
  *----------------------------------------------------------------------------*/
 OWF_API_CALL void OWF_Image_Blend(OWF_BLEND_INFO *blend,
                                   OWF_TRANSPARENCY transparency);
@@ -402,9 +492,25 @@ OWF_API_CALL void OWF_Image_Clear(OWF_IMAGE *image, OWFsubpixel red,
                                   OWFsubpixel green, OWFsubpixel blue,
                                   OWFsubpixel alpha);
 
+/*!---------------------------------------------------------------------------
+ *  \brief Fill a rectangle of an internal format image with a color
+ *
+ *  \param image            Image in internal format
+ *  \param rect             Rectangle to fill, clipped to the image
+ *  \param red, green, blue, alpha  Fill color
+ *----------------------------------------------------------------------------*/
+OWF_API_CALL void OWF_Image_ClearRect(OWF_IMAGE *image,
+                                      OWF_RECTANGLE const *rect,
+                                      OWFsubpixel red, OWFsubpixel green,
+                                      OWFsubpixel blue, OWFsubpixel alpha);
+
 /*!---------------------------------------------------------------------------
  *  \brief Convert image data from internal color format to destination format
  *
+ *  Supported destination formats are ARGB8888, XRGB8888 and RGB565. Alpha
+ *  is (un)premultiplied on the fly if the formats disagree; the source
+ *  image is not modified.
+ *
  *  \param dst
  *  \param src
  *
@@ -413,6 +519,35 @@ OWF_API_CALL void OWF_Image_Clear(OWF_IMAGE *image, OWFsubpixel red,
 OWF_API_CALL OWFboolean OWF_Image_DestinationFormatConversion(OWF_IMAGE *dst,
                                                               OWF_IMAGE *src);
 
+/*!---------------------------------------------------------------------------
+ *  \brief Convert a rectangle of internal format image data to destination
+ *  format
+ *
+ *  Same as OWF_Image_DestinationFormatConversion, but pixels of dst outside
+ *  the rectangle are left untouched.
+ *
+ *  \param dst              Destination image, same size as src
+ *  \param src              Image in internal format
+ *  \param rect             Rectangle to convert, clipped to the images
+ *
+ *  \return OWF_FALSE if the sizes or destination format are not supported
+ *----------------------------------------------------------------------------*/
+OWF_API_CALL OWFboolean OWF_Image_DestinationFormatConversionRect(
+    OWF_IMAGE *dst, OWF_IMAGE *src, OWF_RECTANGLE const *rect);
+
+/*!---------------------------------------------------------------------------
+ *  \brief Check whether images of a format can be used as sources
+ *
+ *  Supported source formats are ARGB8888, XRGB8888, RGB565 and the YUV
+ *  formats NV12, I420 and YUYV.
+ *
+ *  \param format           Pixel format
+ *
+ *  \return OWF_TRUE if source format conversion supports the format
+ *----------------------------------------------------------------------------*/
+OWF_API_CALL OWFboolean
+OWF_Image_IsSupportedSourceFormat(OWF_PIXEL_FORMAT format);
+
 /*!---------------------------------------------------------------------------
  *  \brief Convert image data from source format to internal format
  *
@@ -425,21 +560,79 @@ OWF_API_CALL OWFboolean OWF_Image_SourceFormatConversion(OWF_IMAGE *dst,
                                                          OWF_IMAGE *src);
 
 /*!---------------------------------------------------------------------------
- *  \brief
+ *  \brief Convert a rectangle of source image data to internal format
  *
- *  \param
+ *  Only the pixels inside the rectangle are read. Parts of the rectangle
+ *  outside the source image are filled by replicating the nearest edge
+ *  pixels, so a rectangle grown by one pixel on every side yields the
+ *  edge-replicated border the filters need.
  *
- *  \return
+ *  YUV sources are converted with the matrix and range given by the
+ *  format's yuvColorSpace; chroma is shared by each horizontal pixel pair
+ *  and vertical row pair (NV12, I420).
+ *
+ *  \param dst              Destination image, exactly the rectangle's size
+ *  \param src              Source image
+ *  \param srcRect          Rectangle in source image coordinates
+ *
+ *  \return OWF_FALSE if the size or source format is not supported
+ *----------------------------------------------------------------------------*/
+OWF_API_CALL OWFboolean OWF_Image_CroppedSourceFormatConversion(
+    OWF_IMAGE *dst, OWF_IMAGE *src, OWF_RECTANGLE const *srcRect);
+
+/*!---------------------------------------------------------------------------
+ *  \brief Convert a source rectangle straight into a destination rectangle
+ *
+ *  Single-pass replacement for conversion, cropping and an unblended copy
+ *  when no flip, rotation, scaling or filtering is needed. The destination
+ *  rectangle is clipped to the destination image; the source rectangle
+ *  must lie inside the source image.
+ *
+ *  \param dst              Destination image in internal format
+ *  \param dstRect          Rectangle in destination image coordinates
+ *  \param src              Source image
+ *  \param srcRect          Rectangle in source image coordinates, same size
+ *                          as dstRect
+ *
+ *  \return OWF_FALSE if the rectangles or source format are not supported
+ *----------------------------------------------------------------------------*/
+OWF_API_CALL OWFboolean OWF_Image_ConvertSourceRect(
+    OWF_IMAGE *dst, OWF_RECTANGLE const *dstRect, OWF_IMAGE *src,
+    OWF_RECTANGLE const *srcRect);
+
+/*!---------------------------------------------------------------------------
+ *  \brief Allocate a zeroed, OWF_IMAGE_ALIGNMENT aligned image buffer
+ *
+ *  Rows are padded to the format's default padding.
+ *
+ *  \param width            Image width (in pixels)
+ *  \param height           Image height (in pixels)
+ *  \param format           Pixel format
+ *
+ *  \return Buffer to be released with OWF_Image_FreeData, or NULL
  *----------------------------------------------------------------------------*/
 OWF_API_CALL void *OWF_Image_AllocData(OWFint width, OWFint height,
                                        OWF_PIXEL_FORMAT format);
 
 /*!---------------------------------------------------------------------------
- *  \brief
+ *  \brief Allocate a zeroed, OWF_IMAGE_ALIGNMENT aligned image buffer
  *
- *  \param
+ *  As OWF_Image_AllocData, for rows of a given stride; planar formats get
+ *  room for their chroma planes too.
  *
- *  \return
+ *  \param stride           Row size in bytes
+ *  \param height           Image height (in pixels)
+ *  \param format           Pixel format
+ *
+ *  \return Buffer to be released with OWF_Image_FreeData, or NULL
+ *----------------------------------------------------------------------------*/
+OWF_API_CALL void *OWF_Image_AllocDataWithStride(OWFint stride, OWFint height,
+                                                 OWF_PIXEL_FORMAT format);
+
+/*!---------------------------------------------------------------------------
+ *  \brief Release a buffer allocated by OWF_Image_AllocData
+ *
+ *  \param buffer           Buffer pointer, set to NULL on return
  *----------------------------------------------------------------------------*/
 OWF_API_CALL void OWF_Image_FreeData(void **buffer);
 
@@ -498,6 +691,29 @@ OWF_API_CALL void OWF_Image_SwapWidthAndHeight(OWF_IMAGE *image);
 OWF_API_CALL OWFboolean OWF_Image_ConvertMask(OWF_IMAGE *output,
                                               OWF_IMAGE *input);
 
+/*!---------------------------------------------------------------------------
+ *  \brief Return mask converted to internal format, converting it only if
+ *  the cache does not already hold the same buffer content.
+ *
+ *  \param cache            Cache entry owned by the caller
+ *  \param input            Input mask image (e.g. a locked stream buffer)
+ *  \param serial           Content serial of the input buffer, or
+ *                          OWF_MASK_SERIAL_NONE if it is not known
+ *
+ *  \return Converted mask, owned by the cache, or NULL if the input mask
+ *  is unsupported or there is not enough memory.
+ *----------------------------------------------------------------------------*/
+OWF_API_CALL OWF_IMAGE *OWF_Image_GetCachedMask(OWF_MASK_CACHE *cache,
+                                                OWF_IMAGE *input,
+                                                OWFuint32 serial);
+
+/*!---------------------------------------------------------------------------
+ *  \brief Release converted mask held by a cache entry.
+ *
+ *  \param cache            Cache entry
+ *----------------------------------------------------------------------------*/
+OWF_API_CALL void OWF_Image_DestroyMaskCache(OWF_MASK_CACHE *cache);
+
 /*!---------------------------------------------------------------------------
  *  \brief Return pointer to given pixel in image.
  *
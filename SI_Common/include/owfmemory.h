@@ -41,14 +41,22 @@ extern "C" {
     (((OWFint)n * c < c) ? NULL \
                          : OWF_Memory_Alloc(__FILE__, __LINE__, (n) * (c)))
 #define xfree(p) OWF_Memory_Free(p)
+#define xalloc_aligned(n, c, a)                                        \
+    (((OWFint)n * c < c) ? NULL                                        \
+                         : OWF_Memory_AllocAligned(__FILE__, __LINE__, \
+                                                   (n) * (c), a))
 
 #else
 
 #define xalloc(n, c) calloc(n, c);
 #define xfree(p) free(p);
+#define xalloc_aligned(n, c, a) OWF_Memory_AllocAligned(NULL, 0, (n) * (c), a)
 
 #endif
 
+/* blocks from xalloc_aligned must be released with xfree_aligned */
+#define xfree_aligned(p) OWF_Memory_FreeAligned(p)
+
 #define NEW0N(x, n) (x *)xalloc(sizeof(x), n)
 #define NEW0(x) NEW0N(x, 1)
 
@@ -57,6 +65,12 @@ OWF_API_CALL void *OWF_Memory_Alloc(const char *file, OWFint line,
 
 OWF_API_CALL void OWF_Memory_Free(void *ptr);
 
+OWF_API_CALL void *OWF_Memory_AllocAligned(const char *file, OWFint line,
+                                           OWFuint32 size,
+                                           OWFuint32 alignment);
+
+OWF_API_CALL void OWF_Memory_FreeAligned(void *ptr);
+
 OWF_API_CALL void OWF_Memory_BlockDump();
 
 #ifdef __cplusplus
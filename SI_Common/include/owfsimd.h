@@ -0,0 +1,118 @@
+/* Copyright (c) 2009 The Khronos Group Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Materials.
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+#ifndef OWFSIMD_H_
+#define OWFSIMD_H_
+
+/*
+ * Thin abstraction over the vector instruction sets used by the image
+ * kernels. Kernels written against the OWF_V4F_* macros compile to SSE on
+ * x86 and to NEON on ARM; code that uses raw intrinsics must be guarded by
+ * the matching OWF_SIMD_* define.
+ *
+ * OWF_SIMD_SSE2       SSE2 is part of the build target (always on x86-64)
+ * OWF_SIMD_NEON       NEON is part of the build target
+ * OWF_SIMD_AVX2       AVX2 kernels can be built for runtime dispatch; such
+ *                     functions must be declared with OWF_SIMD_TARGET_AVX2
+ *                     and only called if OWF_Cpu_GetFeatures() reports
+ *                     OWF_CPU_FEATURE_AVX2
+ * OWF_SIMD_V4F        4 x float vector macros are available
+ *
+ * Define OWF_NO_SIMD at build time to use scalar kernels only.
+ */
+
+#include "owftypes.h"
+
+#ifndef OWF_NO_SIMD
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OWF_SIMD_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define OWF_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(OWF_SIMD_SSE2) && defined(__GNUC__) && \
+    (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define OWF_SIMD_AVX2
+#define OWF_SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+
+#endif /* OWF_NO_SIMD */
+
+/* --
+ * 4 x float vectors. One vector holds exactly one float ARGB pixel.
+ */
+#if defined(OWF_SIMD_SSE2)
+#define OWF_SIMD_V4F
+
+typedef __m128 OWFv4f;
+
+#define OWF_V4F_LOAD(p) _mm_loadu_ps((const float *)(p))
+#define OWF_V4F_STORE(p, v) _mm_storeu_ps((float *)(p), v)
+#define OWF_V4F_SPLAT(f) _mm_set1_ps(f)
+#define OWF_V4F_ADD(a, b) _mm_add_ps(a, b)
+#define OWF_V4F_SUB(a, b) _mm_sub_ps(a, b)
+#define OWF_V4F_MUL(a, b) _mm_mul_ps(a, b)
+#define OWF_V4F_AND(a, b) _mm_and_ps(a, b)
+#define OWF_V4F_OR(a, b) _mm_or_ps(a, b)
+#define OWF_V4F_MIN(a, b) _mm_min_ps(a, b)
+#define OWF_V4F_MAX(a, b) _mm_max_ps(a, b)
+#define OWF_V4F_SPLAT3(v) _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))
+/* four unsigned bytes to float lanes */
+#define OWF_V4F_LOAD_U8(p)                                            \
+    _mm_cvtepi32_ps(_mm_unpacklo_epi16(                               \
+        _mm_unpacklo_epi8(_mm_cvtsi32_si128(*(const int *)(p)),       \
+                          _mm_setzero_si128()),                       \
+        _mm_setzero_si128()))
+
+#elif defined(OWF_SIMD_NEON)
+#define OWF_SIMD_V4F
+
+typedef float32x4_t OWFv4f;
+
+#define OWF_V4F_LOAD(p) vld1q_f32((const float *)(p))
+#define OWF_V4F_STORE(p, v) vst1q_f32((float *)(p), v)
+#define OWF_V4F_SPLAT(f) vdupq_n_f32(f)
+#define OWF_V4F_ADD(a, b) vaddq_f32(a, b)
+#define OWF_V4F_SUB(a, b) vsubq_f32(a, b)
+#define OWF_V4F_MUL(a, b) vmulq_f32(a, b)
+#define OWF_V4F_AND(a, b)                                      \
+    vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a), \
+                                    vreinterpretq_u32_f32(b)))
+#define OWF_V4F_OR(a, b)                                       \
+    vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(a), \
+                                    vreinterpretq_u32_f32(b)))
+#define OWF_V4F_MIN(a, b) vminq_f32(a, b)
+#define OWF_V4F_MAX(a, b) vmaxq_f32(a, b)
+#define OWF_V4F_SPLAT3(v) vdupq_n_f32(vgetq_lane_f32(v, 3))
+/* four unsigned bytes to float lanes */
+#define OWF_V4F_LOAD_U8(p)                                        \
+    vcvtq_f32_u32(vmovl_u16(vget_low_u16(vmovl_u8(vreinterpret_u8_u32( \
+        vld1_dup_u32((const uint32_t *)(p)))))))
+
+#endif
+
+#endif /* OWFSIMD_H_ */
@@ -78,9 +78,20 @@ typedef enum {
     OWF_IMAGE_L16 = 0xA16,
     OWF_IMAGE_L8 = 0xA8,
     OWF_IMAGE_L1 = 0xA1,
+    OWF_IMAGE_NV12 = 0x4212, /* Y plane, then interleaved U/V plane */
+    OWF_IMAGE_I420 = 0x4420, /* Y plane, then U plane, then V plane */
+    OWF_IMAGE_YUYV = 0x4422, /* packed Y0 U Y1 V */
     OWF_IMAGE_ARGB_INTERNAL = 0x666 /* OWFpixel rep */
 } OWF_PIXEL_FORMAT;
 
+/* YUV to RGB conversion matrix and range of YUV formats */
+typedef enum {
+    OWF_YUV_BT601_LIMITED = 0,
+    OWF_YUV_BT601_FULL,
+    OWF_YUV_BT709_LIMITED,
+    OWF_YUV_BT709_FULL
+} OWF_YUV_COLOR_SPACE;
+
 typedef enum {
     OWF_FALSE = KHR_BOOLEAN_FALSE,
     OWF_TRUE = KHR_BOOLEAN_TRUE
@@ -91,6 +102,9 @@ typedef struct {
     OWFboolean linear;
     OWFboolean premultiplied;
     OWFint rowPadding; /* row alignment, in bytes */
+    OWFboolean opaque; /* every alpha is fully opaque; maintained by the
+                          image functions, not taken from callers */
+    OWF_YUV_COLOR_SPACE yuvColorSpace; /* YUV formats only */
 } OWF_IMAGE_FORMAT;
 
 typedef struct {
@@ -0,0 +1,74 @@
+/* Copyright (c) 2009 The Khronos Group Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Materials.
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+#include "owfcpu.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OWF_CPU_FEATURES_UNKNOWN 0x80000000
+
+static OWFuint32 cpuFeatures = OWF_CPU_FEATURES_UNKNOWN;
+static OWFuint32 cpuFeatureMask = ~(OWFuint32)0;
+
+/*----------------------------------------------------------------------------*/
+static OWFuint32 OWF_Cpu_Detect(void) {
+    OWFuint32 features = 0;
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) {
+        features |= OWF_CPU_FEATURE_SSE2;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        features |= OWF_CPU_FEATURE_AVX2;
+    }
+#elif defined(_M_X64) || defined(__SSE2__)
+    features |= OWF_CPU_FEATURE_SSE2;
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    /* NEON availability is decided at build time */
+    features |= OWF_CPU_FEATURE_NEON;
+#endif
+
+    return features;
+}
+
+/*----------------------------------------------------------------------------*/
+OWF_API_CALL OWFuint32 OWF_Cpu_GetFeatures(void) {
+    /* detection is idempotent, so racing threads at worst detect twice */
+    if (cpuFeatures == OWF_CPU_FEATURES_UNKNOWN) {
+        cpuFeatures = OWF_Cpu_Detect();
+    }
+    return cpuFeatures & cpuFeatureMask;
+}
+
+/*----------------------------------------------------------------------------*/
+OWF_API_CALL void OWF_Cpu_SetFeatureMask(OWFuint32 mask) {
+    cpuFeatureMask = mask;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -31,9 +31,12 @@ extern "C" {
 #include <stdlib.h>
 #include <string.h>
 
+#include "owfcpu.h"
 #include "owfdebug.h"
 #include "owfmemory.h"
+#include "owfmutex.h"
 #include "owfobject.h"
+#include "owfsimd.h"
 #include "owfutils.h"
 
 #ifdef OWF_IMAGE_INTERNAL_PIXEL_IS_FLOAT
@@ -42,6 +45,14 @@ extern "C" {
 #define roundSubPixel(p) (p)
 #endif
 
+/* padding of internal format rows; whole pixels, so that rows can be
+   stepped in pixels */
+#define OWF_INTERNAL_ROW_PADDING \
+    ((OWFint)MAX(OWF_IMAGE_ROW_ALIGNMENT, sizeof(OWFpixel)))
+
+/* distance between row starts of an internal format image, in pixels */
+#define OWF_ROW_PIXELS(image) ((image)->stride / (OWFint)sizeof(OWFpixel))
+
 /*----------------------------------------------------------------------------*/
 OWF_API_CALL void OWF_IMAGE_Ctor(void *self) { self = self; }
 
@@ -79,10 +90,208 @@ static OWFfloat Linear(OWFfloat x) {
 }
 
 /*----------------------------------------------------------------------------*/
-OWF_API_CALL void OWF_Image_NonLinearizeData(OWF_IMAGE *image) {
-    OWFpixel *ptr;
-    OWFint count;
+/*
+ * sRGB and gamma transfer functions are applied through lookup tables.
+ * Packed 8-bit channels index a 256-entry table holding exactly the value
+ * the arithmetic would produce. Float channels are clamped, quantized to
+ * OWF_TRANSFER_LUT_BITS of fixed point and interpolated linearly between
+ * entries. Gamma curves below 1 are too steep near zero to interpolate,
+ * so values below OWF_TRANSFER_EXACT_LIMIT are computed directly. Red,
+ * green and blue share one table as their maximum values are equal.
+ */
+#ifdef OWF_IMAGE_INTERNAL_PIXEL_IS_FLOAT
+#define OWF_TRANSFER_LUT_BITS 12
+#define OWF_TRANSFER_LUT_SIZE ((1 << OWF_TRANSFER_LUT_BITS) + 1)
+#define OWF_TRANSFER_EXACT_LIMIT (8.0f / (OWF_TRANSFER_LUT_SIZE - 1))
+#else
+#define OWF_TRANSFER_LUT_SIZE (OWF_RED_MAX_VALUE + 1)
+#endif
+
+#define OWF_TRANSFER_LINEAR 0
+#define OWF_TRANSFER_NONLINEAR 1
+#define OWF_TRANSFER_GAMMA 2
+
+/* number of gamma values whose tables are kept */
+#define OWF_GAMMA_CACHE_SIZE 4
+
+typedef struct {
+    OWFfloat gamma;
+    /* OWF_Image_Gamma calls applying the table; it is only replaced
+       while this is zero */
+    OWFint users;
+    /* gammaCacheClock at the latest lookup */
+    OWFuint32 lastUse;
+    OWFsubpixel table[OWF_TRANSFER_LUT_SIZE];
+} OWF_GAMMA_LUT;
+
+static OWFsubpixel linearTable[OWF_TRANSFER_LUT_SIZE];
+static OWFsubpixel nonLinearTable[OWF_TRANSFER_LUT_SIZE];
+static OWF_ONCE transferTablesOnce = OWF_ONCE_INIT;
+
+static OWF_GAMMA_LUT gammaCache[OWF_GAMMA_CACHE_SIZE];
+static OWFint gammaCacheCount = 0;
+static OWFuint32 gammaCacheClock = 0;
+static OWF_MUTEX gammaCacheMutex;
+
+#define GAMMA(color, max, gamma)                     \
+    ((max) * pow((color) / (OWFfloat)(max), gamma) + \
+     OWF_CONVERSION_ROUNDING_VALUE)
+
+/* transfer function of a subpixel value, computed without a table */
+static OWFsubpixel OWF_Image_TransferValue(OWFint curve, OWFfloat gamma,
+                                           OWFfloat value) {
+    switch (curve) {
+        case OWF_TRANSFER_LINEAR: {
+            return (OWFsubpixel)(Linear(value / (OWFfloat)OWF_RED_MAX_VALUE) *
+                                     OWF_RED_MAX_VALUE +
+                                 OWF_CONVERSION_ROUNDING_VALUE);
+        }
+        case OWF_TRANSFER_NONLINEAR: {
+            return (OWFsubpixel)(
+                NonLinear(value / (OWFfloat)OWF_RED_MAX_VALUE) *
+                    OWF_RED_MAX_VALUE +
+                OWF_CONVERSION_ROUNDING_VALUE);
+        }
+        default: {
+            return (OWFsubpixel)GAMMA(value, OWF_RED_MAX_VALUE, gamma);
+        }
+    }
+}
+
+static void OWF_Image_BuildTransferTable(OWFsubpixel *table, OWFint curve,
+                                         OWFfloat gamma) {
+    OWFint i;
+
+    for (i = 0; i < OWF_TRANSFER_LUT_SIZE; i++) {
+#ifdef OWF_IMAGE_INTERNAL_PIXEL_IS_FLOAT
+        OWFfloat value = (OWFfloat)i / (OWFfloat)(OWF_TRANSFER_LUT_SIZE - 1);
+#else
+        OWFfloat value = (OWFfloat)i;
+#endif
+
+        table[i] = OWF_Image_TransferValue(curve, gamma, value);
+    }
+}
+
+static void OWF_Image_GammaCacheCleanup(void) {
+    OWF_Mutex_Destroy(&gammaCacheMutex);
+}
+
+/* run through OWF_Once: also creates the gamma cache lock */
+static void OWF_Image_InitTransferTables(void) {
+    OWF_Image_BuildTransferTable(linearTable, OWF_TRANSFER_LINEAR, 1.0f);
+    OWF_Image_BuildTransferTable(nonLinearTable, OWF_TRANSFER_NONLINEAR,
+                                 1.0f);
+
+    if (OWF_Mutex_Init(&gammaCacheMutex) == 0) {
+        atexit(OWF_Image_GammaCacheCleanup);
+    }
+}
+
+/* cached table of a gamma value, or NULL when the cache has no lock or
+   every table is being applied. When the cache is full, the least
+   recently used table nobody is applying is rebuilt for the new value.
+   The table stays valid without holding the lock until it is handed
+   back with OWF_Image_ReleaseGammaTable. */
+static OWF_GAMMA_LUT *OWF_Image_GetGammaTable(OWFfloat gamma) {
+    OWF_GAMMA_LUT *entry = NULL;
+    OWFint i;
+
+    OWF_Once(&transferTablesOnce, OWF_Image_InitTransferTables);
+    if (!gammaCacheMutex) {
+        return NULL;
+    }
+    OWF_Mutex_Lock(&gammaCacheMutex);
+
+    for (i = 0; i < gammaCacheCount; i++) {
+        if (gammaCache[i].gamma == gamma) {
+            entry = &gammaCache[i];
+            break;
+        }
+    }
+
+    if (!entry) {
+        if (gammaCacheCount < OWF_GAMMA_CACHE_SIZE) {
+            entry = &gammaCache[gammaCacheCount++];
+        } else {
+            for (i = 0; i < OWF_GAMMA_CACHE_SIZE; i++) {
+                if (gammaCache[i].users == 0 &&
+                    (!entry || gammaCache[i].lastUse < entry->lastUse)) {
+                    entry = &gammaCache[i];
+                }
+            }
+        }
+
+        if (entry) {
+            entry->gamma = gamma;
+            OWF_Image_BuildTransferTable(entry->table, OWF_TRANSFER_GAMMA,
+                                         gamma);
+        }
+    }
+
+    if (entry) {
+        entry->users++;
+        entry->lastUse = ++gammaCacheClock;
+    }
+
+    OWF_Mutex_Unlock(&gammaCacheMutex);
+
+    return entry;
+}
+
+static void OWF_Image_ReleaseGammaTable(OWF_GAMMA_LUT *entry) {
+    OWF_Mutex_Lock(&gammaCacheMutex);
+    entry->users--;
+    OWF_Mutex_Unlock(&gammaCacheMutex);
+}
+
+#ifdef OWF_IMAGE_INTERNAL_PIXEL_IS_FLOAT
+static OWFsubpixel OWF_Image_TransferLookup(const OWFsubpixel *table,
+                                            OWFint curve, OWFfloat gamma,
+                                            OWFsubpixel value) {
+    OWFfloat t;
+    OWFint i;
+
+    if (value < OWF_TRANSFER_EXACT_LIMIT) {
+        return OWF_Image_TransferValue(curve, gamma, MAX(value, 0.0f));
+    }
+
+    t = MIN(value, 1.0f) * (OWF_TRANSFER_LUT_SIZE - 1);
+    i = (OWFint)t;
+
+    if (i >= OWF_TRANSFER_LUT_SIZE - 1) {
+        return table[OWF_TRANSFER_LUT_SIZE - 1];
+    }
+    return table[i] + (table[i + 1] - table[i]) * (t - (OWFfloat)i);
+}
+#else
+/* the 8-bit tables are exact for every value */
+#define OWF_Image_TransferLookup(table, curve, gamma, value) \
+    ((void)(curve), (void)(gamma), (table)[value])
+#endif
+
+/* applies the table of a curve to the color channels of every pixel */
+static void OWF_Image_ApplyTransferTable(OWF_IMAGE *image,
+                                         const OWFsubpixel *table,
+                                         OWFint curve, OWFfloat gamma) {
+    OWFint x, y;
+
+    for (y = 0; y < image->height; y++) {
+        OWFpixel *ptr = (OWFpixel *)image->data + y * OWF_ROW_PIXELS(image);
+
+        for (x = 0; x < image->width; x++, ptr++) {
+            ptr->color.red =
+                OWF_Image_TransferLookup(table, curve, gamma, ptr->color.red);
+            ptr->color.green = OWF_Image_TransferLookup(table, curve, gamma,
+                                                        ptr->color.green);
+            ptr->color.blue =
+                OWF_Image_TransferLookup(table, curve, gamma, ptr->color.blue);
+        }
+    }
+}
 
+/*----------------------------------------------------------------------------*/
+OWF_API_CALL void OWF_Image_NonLinearizeData(OWF_IMAGE *image) {
     OWF_ASSERT(image != NULL && image->data != NULL);
     OWF_ASSERT(image->format.pixelFormat == OWF_IMAGE_ARGB_INTERNAL);
 
@@ -90,32 +299,15 @@ OWF_API_CALL void OWF_Image_NonLinearizeData(OWF_IMAGE *image) {
         return;
     }
 
-    ptr = (OWFpixel *)image->data;
-    count = image->width * image->height;
-
-    while (count > 0) {
-        ptr->color.red =
-            (OWFsubpixel)NonLinear(ptr->color.red / OWF_RED_MAX_VALUE) *
-            OWF_RED_MAX_VALUE;
-        ptr->color.green =
-            (OWFsubpixel)NonLinear(ptr->color.green / OWF_GREEN_MAX_VALUE) *
-            OWF_GREEN_MAX_VALUE;
-        ptr->color.blue =
-            (OWFsubpixel)NonLinear(ptr->color.blue / OWF_BLUE_MAX_VALUE) *
-            OWF_BLUE_MAX_VALUE;
-
-        --count;
-        ptr++;
-    }
+    OWF_Once(&transferTablesOnce, OWF_Image_InitTransferTables);
+    OWF_Image_ApplyTransferTable(image, nonLinearTable,
+                                 OWF_TRANSFER_NONLINEAR, 1.0f);
 
     image->format.linear = OWF_FALSE;
 }
 
 /*----------------------------------------------------------------------------*/
 OWF_API_CALL void OWF_Image_LinearizeData(OWF_IMAGE *image) {
-    OWFpixel *ptr;
-    OWFuint count;
-
     OWF_ASSERT(image != NULL && image->data != NULL);
     OWF_ASSERT(image->format.pixelFormat == OWF_IMAGE_ARGB_INTERNAL);
 
@@ -123,32 +315,18 @@ OWF_API_CALL void OWF_Image_LinearizeData(OWF_IMAGE *image) {
         return;
     }
 
-    ptr = (OWFpixel *)image->data;
-    count = image->width * image->height;
-
-    while (count > 0) {
-        ptr->color.red =
-            (OWFsubpixel)Linear(ptr->color.red / OWF_RED_MAX_VALUE) *
-            OWF_RED_MAX_VALUE;
-        ptr->color.green =
-            (OWFsubpixel)Linear(ptr->color.green / OWF_GREEN_MAX_VALUE) *
-            OWF_GREEN_MAX_VALUE;
-        ptr->color.blue =
-            (OWFsubpixel)Linear(ptr->color.blue / OWF_BLUE_MAX_VALUE) *
-            OWF_BLUE_MAX_VALUE;
-        --count;
-        ptr += image->pixelSize;
-    }
+    OWF_Once(&transferTablesOnce, OWF_Image_InitTransferTables);
+    OWF_Image_ApplyTransferTable(image, linearTable, OWF_TRANSFER_LINEAR,
+                                 1.0f);
 
     image->format.linear = OWF_TRUE;
 }
 
 /*----------------------------------------------------------------------------*/
-#define GAMMA(color, max, gamma) (max * pow(color / max, gamma))
-
 OWF_API_CALL void OWF_Image_Gamma(OWF_IMAGE *image, OWFfloat gamma) {
-    OWFpixel *ptr;
-    OWFint count;
+    OWF_GAMMA_LUT *entry;
+    const OWFsubpixel *table;
+    OWFsubpixel *scratch = NULL;
 
     OWF_ASSERT(image != NULL && image->data != NULL);
     OWF_ASSERT(image->format.pixelFormat == OWF_IMAGE_ARGB_INTERNAL);
@@ -157,340 +335,1176 @@ OWF_API_CALL void OWF_Image_Gamma(OWF_IMAGE *image, OWFfloat gamma) {
         return;
     }
 
-    ptr = (OWFpixel *)image->data;
-    count = image->width * image->height;
+    entry = OWF_Image_GetGammaTable(gamma);
+    if (entry) {
+        table = entry->table;
+    } else {
+        /* every cached table is in use: build a one-off table */
+        scratch = xalloc(OWF_TRANSFER_LUT_SIZE, sizeof(OWFsubpixel));
+        if (!scratch) {
+            return;
+        }
+        OWF_Image_BuildTransferTable(scratch, OWF_TRANSFER_GAMMA, gamma);
+        table = scratch;
+    }
 
-    while (count > 0) {
-        ptr->color.red =
-            (OWFsubpixel)GAMMA(ptr->color.red, OWF_RED_MAX_VALUE, gamma);
-        ptr->color.green =
-            (OWFsubpixel)GAMMA(ptr->color.green, OWF_GREEN_MAX_VALUE, gamma);
-        ptr->color.blue =
-            (OWFsubpixel)GAMMA(ptr->color.blue, OWF_BLUE_MAX_VALUE, gamma);
+    OWF_Image_ApplyTransferTable(image, table, OWF_TRANSFER_GAMMA, gamma);
 
-        --count;
-        ptr++;
+    if (entry) {
+        OWF_Image_ReleaseGammaTable(entry);
+    }
+    if (scratch) {
+        xfree(scratch);
     }
 }
 
 /*----------------------------------------------------------------------------*/
-OWF_API_CALL void OWF_Image_EdgeReplication(OWF_IMAGE *image) {
-    OWFint y;
-    OWFint copyStride;
-    OWFuint8 *srcPtr = NULL;
-    OWFuint8 *dstPtr = NULL;
+/*
+ * Source format conversion is done one row at a time by a row converter
+ * chosen once per image. Per-channel conversions go through lookup tables
+ * that hold exactly the values the arithmetic conversion would produce.
+ */
+typedef void (*OWF_CONVERT_ROW_FUNC)(OWFpixel *dstPtr, const void *srcLinePtr,
+                                     OWFint count);
 
-    OWF_ASSERT(image);
-    OWF_ASSERT(image->format.pixelFormat == OWF_IMAGE_ARGB_INTERNAL);
-    OWF_ASSERT(image->width >= 3 && image->height >= 3);
+static OWFsubpixel byteToSubpixel[256];
+static OWFsubpixel rgb565FiveBitToSubpixel[32];
+static OWFsubpixel rgb565SixBitToSubpixel[64];
+static OWF_ONCE conversionTablesOnce = OWF_ONCE_INIT;
 
-    copyStride = image->width * image->pixelSize;
+/* run through OWF_Once; conversions run on several threads at a time */
+static void OWF_Image_InitConversionTables(void) {
+    OWFint i;
 
-    /* top side replication */
-    srcPtr = (OWFuint8 *)image->data;
-    srcPtr += 1 * image->stride + 0 * image->pixelSize;
-    dstPtr = (OWFuint8 *)image->data;
+    for (i = 0; i < 256; i++) {
+        byteToSubpixel[i] =
+            (OWFsubpixel)OWF_ALPHA_MAX_VALUE * i / OWF_BYTE_MAX_VALUE;
+    }
 
-    memcpy(dstPtr, srcPtr, copyStride);
+    /*
+     * Formula for converting channel value is:
+     * Each channel is multiplied by (2^d - 1)/(2^s -1)
+     * where d is dest channel bits and s is source channel
+     * bits.
+     */
+    for (i = 0; i < 32; i++) {
+        rgb565FiveBitToSubpixel[i] = (OWFsubpixel)(
+            OWF_RED_MAX_VALUE * (OWFfloat)i / 31.0f +
+            OWF_CONVERSION_ROUNDING_VALUE);
+    }
+    for (i = 0; i < 64; i++) {
+        rgb565SixBitToSubpixel[i] = (OWFsubpixel)(
+            OWF_GREEN_MAX_VALUE * (OWFfloat)i / 63.0f +
+            OWF_CONVERSION_ROUNDING_VALUE);
+    }
+}
 
-    /* bottom side replication */
-    srcPtr = (OWFuint8 *)image->data;
-    srcPtr += (image->height - 2) * image->stride + 0 * image->pixelSize;
-    dstPtr = (OWFuint8 *)image->data;
-    dstPtr += (image->height - 1) * image->stride + 0 * image->pixelSize;
+static void OWF_ConvertRow_ARGB8888(OWFpixel *dstPtr, const void *srcLinePtr,
+                                    OWFint count) {
+    const OWFuint32 *srcPtr = (const OWFuint32 *)srcLinePtr;
+    OWFint i;
+
+    for (i = 0; i < count; i++) {
+        OWFuint32 p = srcPtr[i];
+
+        dstPtr[i].color.alpha =
+            byteToSubpixel[(p & ARGB8888_ALPHA_MASK) >> ARGB8888_ALPHA_SHIFT];
+        dstPtr[i].color.red =
+            byteToSubpixel[(p & ARGB8888_RED_MASK) >> ARGB8888_RED_SHIFT];
+        dstPtr[i].color.green =
+            byteToSubpixel[(p & ARGB8888_GREEN_MASK) >> ARGB8888_GREEN_SHIFT];
+        dstPtr[i].color.blue =
+            byteToSubpixel[(p & ARGB8888_BLUE_MASK) >> ARGB8888_BLUE_SHIFT];
+    }
+}
 
-    memcpy(dstPtr, srcPtr, copyStride);
+static void OWF_ConvertRow_XRGB8888(OWFpixel *dstPtr, const void *srcLinePtr,
+                                    OWFint count) {
+    const OWFuint32 *srcPtr = (const OWFuint32 *)srcLinePtr;
+    OWFint i;
+
+    for (i = 0; i < count; i++) {
+        OWFuint32 p = srcPtr[i];
+
+        dstPtr[i].color.alpha = OWF_FULLY_OPAQUE;
+        dstPtr[i].color.red =
+            byteToSubpixel[(p & ARGB8888_RED_MASK) >> ARGB8888_RED_SHIFT];
+        dstPtr[i].color.green =
+            byteToSubpixel[(p & ARGB8888_GREEN_MASK) >> ARGB8888_GREEN_SHIFT];
+        dstPtr[i].color.blue =
+            byteToSubpixel[(p & ARGB8888_BLUE_MASK) >> ARGB8888_BLUE_SHIFT];
+    }
+}
 
-    /* left side replication */
-    for (y = 0; y < image->height; y++) {
-        OWF_Image_SetPixel(image, 0, y, OWF_Image_GetPixelPtr(image, 1, y));
+static void OWF_ConvertRow_RGB565(OWFpixel *dstPtr, const void *srcLinePtr,
+                                  OWFint count) {
+    const OWFuint16 *srcPtr = (const OWFuint16 *)srcLinePtr;
+    OWFint i;
+
+    for (i = 0; i < count; i++) {
+        OWFuint16 p = srcPtr[i];
+
+        dstPtr[i].color.alpha = OWF_FULLY_OPAQUE;
+        dstPtr[i].color.red =
+            rgb565FiveBitToSubpixel[(p & RGB565_RED_MASK) >> RGB565_RED_SHIFT];
+        dstPtr[i].color.green =
+            rgb565SixBitToSubpixel[(p & RGB565_GREEN_MASK) >>
+                                   RGB565_GREEN_SHIFT];
+        dstPtr[i].color.blue = rgb565FiveBitToSubpixel[p & RGB565_BLUE_MASK];
     }
+}
 
-    /* right side replication */
-    for (y = 0; y < image->height; y++) {
-        OWF_Image_SetPixel(image, image->width - 1, y,
-                           OWF_Image_GetPixelPtr(image, image->width - 2, y));
+/* source already in internal layout */
+static void OWF_ConvertRow_Copy(OWFpixel *dstPtr, const void *srcLinePtr,
+                                OWFint count) {
+    memcpy(dstPtr, srcLinePtr, count * sizeof(OWFpixel));
+}
+
+#ifndef OWF_IMAGE_INTERNAL_PIXEL_IS_FLOAT
+/* packed 8-bit internal pixels share the XRGB8888 layout on little-endian
+ * hosts, so only the alpha byte needs to be set */
+static void OWF_ConvertRow_XRGB8888Packed(OWFpixel *dstPtr,
+                                          const void *srcLinePtr,
+                                          OWFint count) {
+    const OWFuint32 *srcPtr = (const OWFuint32 *)srcLinePtr;
+    OWFuint32 *dst32 = (OWFuint32 *)dstPtr;
+    OWFint i;
+
+    for (i = 0; i < count; i++) {
+        dst32[i] = srcPtr[i] | ARGB8888_ALPHA_MASK;
     }
 }
+#endif
+
+#if defined(OWF_IMAGE_INTERNAL_PIXEL_IS_FLOAT) && defined(OWF_SIMD_SSE2)
+/*
+ * Four pixels per iteration: bytes are widened to 32-bit lanes already in
+ * internal (b, g, r, a) order, converted to float and divided by 255, which
+ * gives the same results as the tables.
+ */
+#define SSE2_CONVERT_ROW(name, ALPHA_FIXUP, tailFunc)                       \
+    static void name(OWFpixel *dstPtr, const void *srcLinePtr,              \
+                     OWFint count) {                                        \
+        const OWFuint32 *srcPtr = (const OWFuint32 *)srcLinePtr;            \
+        const __m128i zero = _mm_setzero_si128();                           \
+        const __m128 scale = _mm_set1_ps(OWF_BYTE_MAX_VALUE);               \
+        const __m128 colorMask =                                            \
+            _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));                \
+        const __m128 alphaOne = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);        \
+        OWFint i;                                                           \
+                                                                            \
+        for (i = 0; i + 4 <= count; i += 4) {                               \
+            __m128i s = _mm_loadu_si128((const __m128i *)&srcPtr[i]);       \
+            __m128i lo = _mm_unpacklo_epi8(s, zero);                        \
+            __m128i hi = _mm_unpackhi_epi8(s, zero);                        \
+            __m128 p0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero));      \
+            __m128 p1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero));      \
+            __m128 p2 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero));      \
+            __m128 p3 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero));      \
+                                                                            \
+            _mm_storeu_ps((float *)&dstPtr[i],                              \
+                          ALPHA_FIXUP(_mm_div_ps(p0, scale)));              \
+            _mm_storeu_ps((float *)&dstPtr[i + 1],                          \
+                          ALPHA_FIXUP(_mm_div_ps(p1, scale)));              \
+            _mm_storeu_ps((float *)&dstPtr[i + 2],                          \
+                          ALPHA_FIXUP(_mm_div_ps(p2, scale)));              \
+            _mm_storeu_ps((float *)&dstPtr[i + 3],                          \
+                          ALPHA_FIXUP(_mm_div_ps(p3, scale)));              \
+        }                                                                   \
+        if (i < count) {                                                    \
+            tailFunc(dstPtr + i, srcPtr + i, count - i);                    \
+        }                                                                   \
+        (void)colorMask;                                                    \
+        (void)alphaOne;                                                     \
+    }
+
+#define SSE2_KEEP_ALPHA(v) (v)
+#define SSE2_OPAQUE_ALPHA(v) _mm_or_ps(_mm_and_ps(v, colorMask), alphaOne)
+
+SSE2_CONVERT_ROW(OWF_ConvertRowSse2_ARGB8888, SSE2_KEEP_ALPHA,
+                 OWF_ConvertRow_ARGB8888)
+SSE2_CONVERT_ROW(OWF_ConvertRowSse2_XRGB8888, SSE2_OPAQUE_ALPHA,
+                 OWF_ConvertRow_XRGB8888)
+#endif
 
 /*----------------------------------------------------------------------------*/
-OWF_API_CALL OWFboolean OWF_Image_SourceFormatConversion(OWF_IMAGE *dst,
-                                                         OWF_IMAGE *src) {
-    OWFint countY, widthDiff, heightDiff;
-    void *srcLinePtr;
-    OWFpixel *dstLinePtr;
-    OWFboolean replicateEdges = OWF_FALSE;
+static OWF_CONVERT_ROW_FUNC OWF_Image_GetConvertRowFunc(
+    OWF_PIXEL_FORMAT format) {
+#ifndef OWF_IMAGE_INTERNAL_PIXEL_IS_FLOAT
+    const OWFuint32 one = 1;
+    const OWFboolean littleEndian =
+        (*(const OWFuint8 *)&one == 1) ? OWF_TRUE : OWF_FALSE;
+#endif
+#if defined(OWF_IMAGE_INTERNAL_PIXEL_IS_FLOAT) && defined(OWF_SIMD_SSE2)
+    const OWFboolean useSse2 =
+        (OWF_Cpu_GetFeatures() & OWF_CPU_FEATURE_SSE2) ? OWF_TRUE : OWF_FALSE;
+#endif
 
-    OWF_ASSERT(dst != 0 && dst->data != NULL);
-    OWF_ASSERT(src != 0 && src->data != NULL);
-    OWF_ASSERT(dst->format.pixelFormat == OWF_IMAGE_ARGB_INTERNAL);
+    OWF_Once(&conversionTablesOnce, OWF_Image_InitConversionTables);
 
-    srcLinePtr = src->data;
-    dstLinePtr = (OWFpixel *)dst->data;
+    switch (format) {
+        case OWF_IMAGE_ARGB8888: {
+#ifndef OWF_IMAGE_INTERNAL_PIXEL_IS_FLOAT
+            if (littleEndian) {
+                return OWF_ConvertRow_Copy;
+            }
+#elif defined(OWF_SIMD_SSE2)
+            if (useSse2) {
+                return OWF_ConvertRowSse2_ARGB8888;
+            }
+#endif
+            return OWF_ConvertRow_ARGB8888;
+        }
 
-    /* dst image must either be the same size as the src image or 2 pixels
-       bigger (enough space to perform edge replication) */
-    if (dst->width != src->width || dst->height != src->height) {
-        widthDiff = dst->width - src->width;
-        heightDiff = dst->height - src->height;
+        case OWF_IMAGE_XRGB8888: {
+#ifndef OWF_IMAGE_INTERNAL_PIXEL_IS_FLOAT
+            if (littleEndian) {
+                return OWF_ConvertRow_XRGB8888Packed;
+            }
+#elif defined(OWF_SIMD_SSE2)
+            if (useSse2) {
+                return OWF_ConvertRowSse2_XRGB8888;
+            }
+#endif
+            return OWF_ConvertRow_XRGB8888;
+        }
 
-        if (widthDiff == 2 && heightDiff == 2) {
-            replicateEdges = OWF_TRUE;
-            /* start of the destination buffer should have a 1 pixel offset */
-            dstLinePtr = (OWFpixel *)dst->data + 1 * dst->width + 1;
-        } else {
-            return OWF_FALSE;
+        case OWF_IMAGE_RGB565: {
+            return OWF_ConvertRow_RGB565;
+        }
+
+        case OWF_IMAGE_ARGB_INTERNAL: {
+            return OWF_ConvertRow_Copy;
+        }
+
+        default: {
+            return NULL; /* source format not supported */
         }
     }
+}
 
-    if (dst->format.pixelFormat != OWF_IMAGE_ARGB_INTERNAL) {
-        return OWF_FALSE;
+/*----------------------------------------------------------------------------*/
+/*
+ * YUV sources are converted to XRGB8888 in chunks and then through the
+ * XRGB8888 row converter, so the cropping and edge replication of packed
+ * formats apply unchanged. Chroma is point sampled: both pixels of a pair
+ * use the same U and V.
+ *
+ * Conversion is done in 13-bit fixed point, e.g. for red
+ *
+ *   R = clamp((ky * (Y - yOffset) + krv * (V - 128) + 4096) >> 13)
+ *
+ * and the vector kernels compute exactly the same sums.
+ */
+#define OWF_YUV_FRACTION_BITS 13
+#define OWF_YUV_ROUNDING (1 << (OWF_YUV_FRACTION_BITS - 1))
+#define OWF_YUV_CHUNK_SIZE 256
+
+typedef struct {
+    OWFint yOffset;
+    OWFint16 ky, krv, kgu, kgv, kbu;
+} OWF_YUV_COEFFICIENTS;
+
+/* indexed by OWF_YUV_COLOR_SPACE */
+static const OWF_YUV_COEFFICIENTS yuvCoefficients[4] = {
+    {16, 9539, 13075, -3209, -6660, 16525}, /* BT.601, limited range */
+    {0, 8192, 11485, -2819, -5850, 14516},  /* BT.601, full range */
+    {16, 9539, 14686, -1747, -4366, 17305}, /* BT.709, limited range */
+    {0, 8192, 12901, -1535, -3835, 15201}   /* BT.709, full range */
+};
+
+/* luma and chroma samples of one source row */
+typedef struct {
+    const OWFuint8 *y;
+    const OWFuint8 *u;
+    const OWFuint8 *v;
+    OWFint yStep;  /* bytes between luma samples */
+    OWFint uvStep; /* bytes between chroma samples */
+} OWF_YUV_ROW;
+
+static OWFboolean OWF_Image_FormatIsYuv(OWF_PIXEL_FORMAT format) {
+    return (format == OWF_IMAGE_NV12 || format == OWF_IMAGE_I420 ||
+            format == OWF_IMAGE_YUYV)
+               ? OWF_TRUE
+               : OWF_FALSE;
+}
+
+/* size of image data including the chroma planes of planar formats */
+static OWFint OWF_Image_GetDataSize(OWFint stride, OWFint height,
+                                    OWF_PIXEL_FORMAT format) {
+    switch (format) {
+        case OWF_IMAGE_NV12: {
+            return stride * (height + (height + 1) / 2);
+        }
+        case OWF_IMAGE_I420: {
+            return stride * height + 2 * (stride / 2) * ((height + 1) / 2);
+        }
+        default: {
+            return stride * height;
+        }
     }
+}
 
-    for (countY = src->height; countY; countY--) {
-        OWFint count = src->width;
-        OWFpixel *dstPtr = dstLinePtr;
-
-        switch (src->format.pixelFormat) {
-            case OWF_IMAGE_ARGB8888: {
-                OWFuint32 *srcPtr = (OWFuint32 *)srcLinePtr;
-
-                while (count > 0) {
-                    dstPtr->color.alpha = (OWFsubpixel)OWF_ALPHA_MAX_VALUE *
-                                          ((*srcPtr & ARGB8888_ALPHA_MASK) >>
-                                           ARGB8888_ALPHA_SHIFT) /
-                                          OWF_BYTE_MAX_VALUE;
-                    dstPtr->color.red =
-                        (OWFsubpixel)OWF_RED_MAX_VALUE *
-                        ((*srcPtr & ARGB8888_RED_MASK) >> ARGB8888_RED_SHIFT) /
-                        OWF_BYTE_MAX_VALUE;
-                    dstPtr->color.green = (OWFsubpixel)OWF_GREEN_MAX_VALUE *
-                                          ((*srcPtr & ARGB8888_GREEN_MASK) >>
-                                           ARGB8888_GREEN_SHIFT) /
-                                          OWF_BYTE_MAX_VALUE;
-                    dstPtr->color.blue = (OWFsubpixel)OWF_BLUE_MAX_VALUE *
-                                         ((*srcPtr & ARGB8888_BLUE_MASK) >>
-                                          ARGB8888_BLUE_SHIFT) /
-                                         OWF_BYTE_MAX_VALUE;
-                    dstPtr++;
-                    srcPtr++;
-                    count--;
-                }
-                break;
-            }
+static void OWF_Image_GetYuvRow(OWF_YUV_ROW *row, const OWF_IMAGE *src,
+                                OWFint y) {
+    const OWFuint8 *data = (const OWFuint8 *)src->data;
+    const OWFuint8 *chroma = data + src->stride * src->height;
+
+    switch (src->format.pixelFormat) {
+        case OWF_IMAGE_NV12: {
+            row->y = data + y * src->stride;
+            row->u = chroma + (y >> 1) * src->stride;
+            row->v = row->u + 1;
+            row->yStep = 1;
+            row->uvStep = 2;
+            break;
+        }
+        case OWF_IMAGE_I420: {
+            OWFint chromaStride = src->stride / 2;
+
+            row->y = data + y * src->stride;
+            row->u = chroma + (y >> 1) * chromaStride;
+            row->v = chroma + ((src->height + 1) / 2 + (y >> 1)) * chromaStride;
+            row->yStep = 1;
+            row->uvStep = 1;
+            break;
+        }
+        default: {
+            OWF_ASSERT(src->format.pixelFormat == OWF_IMAGE_YUYV);
+            row->y = data + y * src->stride;
+            row->u = row->y + 1;
+            row->v = row->y + 3;
+            row->yStep = 2;
+            row->uvStep = 4;
+            break;
+        }
+    }
+}
 
-            case OWF_IMAGE_XRGB8888: {
-                OWFuint32 *srcPtr = (OWFuint32 *)srcLinePtr;
-                while (count > 0) {
-                    dstPtr->color.alpha = OWF_FULLY_OPAQUE;
-                    dstPtr->color.red =
-                        (OWFsubpixel)OWF_RED_MAX_VALUE *
-                        ((*srcPtr & ARGB8888_RED_MASK) >> ARGB8888_RED_SHIFT) /
-                        OWF_BYTE_MAX_VALUE;
-                    dstPtr->color.green = (OWFsubpixel)OWF_GREEN_MAX_VALUE *
-                                          ((*srcPtr & ARGB8888_GREEN_MASK) >>
-                                           ARGB8888_GREEN_SHIFT) /
-                                          OWF_BYTE_MAX_VALUE;
-                    dstPtr->color.blue = (OWFsubpixel)OWF_BLUE_MAX_VALUE *
-                                         ((*srcPtr & ARGB8888_BLUE_MASK) >>
-                                          ARGB8888_BLUE_SHIFT) /
-                                         OWF_BYTE_MAX_VALUE;
-                    dstPtr++;
-                    srcPtr++;
-                    count--;
-                }
-                break;
-            }
+static OWFuint32 OWF_Image_YuvToXrgb(const OWF_YUV_COEFFICIENTS *k, OWFint y,
+                                     OWFint u, OWFint v) {
+    OWFint luma = k->ky * (y - k->yOffset) + OWF_YUV_ROUNDING;
+    OWFint r, g, b;
+
+    u -= 128;
+    v -= 128;
+    r = luma + k->krv * v;
+    g = luma + k->kgu * u + k->kgv * v;
+    b = luma + k->kbu * u;
+
+    /* negative sums clamp to zero, so only the others are shifted */
+    r = (r < 0) ? 0 : MIN(r >> OWF_YUV_FRACTION_BITS, 255);
+    g = (g < 0) ? 0 : MIN(g >> OWF_YUV_FRACTION_BITS, 255);
+    b = (b < 0) ? 0 : MIN(b >> OWF_YUV_FRACTION_BITS, 255);
+
+    return ARGB8888_ALPHA_MASK | ((OWFuint32)r << ARGB8888_RED_SHIFT) |
+           ((OWFuint32)g << ARGB8888_GREEN_SHIFT) |
+           ((OWFuint32)b << ARGB8888_BLUE_SHIFT);
+}
 
-            case OWF_IMAGE_RGB565: {
-                OWFfloat tmp;
-                OWFuint16 *srcPtr = (OWFuint16 *)srcLinePtr;
-                while (count > 0) {
-                    /*
-                     * Formula for converting channel value is:
-                     * Each channel is multiplied by (2^d - 1)/(2^s -1)
-                     * where d is dest channel bits and s is source channel
-                     * bits.
-                     */
-                    dstPtr->color.alpha = (OWFsubpixel)OWF_FULLY_OPAQUE;
-
-                    tmp = (OWFfloat)((*srcPtr & RGB565_RED_MASK) >>
-                                     RGB565_RED_SHIFT);
-                    dstPtr->color.red =
-                        (OWFsubpixel)OWF_RED_MAX_VALUE * tmp / 31.0f;
-
-                    tmp = (OWFfloat)((*srcPtr & RGB565_GREEN_MASK) >>
-                                     RGB565_GREEN_SHIFT);
-                    dstPtr->color.green =
-                        (OWFsubpixel)OWF_GREEN_MAX_VALUE * tmp / 63.0f;
-
-                    tmp = (OWFfloat)(*srcPtr & RGB565_BLUE_MASK);
-                    dstPtr->color.blue =
-                        (OWFsubpixel)OWF_BLUE_MAX_VALUE * tmp / 31.0f;
-
-                    dstPtr++;
-                    srcPtr++;
-                    count--;
-                }
-                break;
-            }
+/* pixels x .. x + count - 1 of a YUV row to XRGB8888 */
+static void OWF_ConvertYuvRow(OWFuint32 *dstPtr, const OWF_YUV_ROW *row,
+                              const OWF_YUV_COEFFICIENTS *k, OWFint x,
+                              OWFint count) {
+    OWFint i;
 
-            default: {
-                return OWF_FALSE; /* source format not supported */
-            }
-        }
+    for (i = 0; i < count; i++, x++) {
+        OWFint c = (x >> 1) * row->uvStep;
 
-        dstLinePtr += dst->width;
-        srcLinePtr = (OWFuint8 *)srcLinePtr + src->stride;
+        dstPtr[i] = OWF_Image_YuvToXrgb(k, row->y[x * row->yStep], row->u[c],
+                                        row->v[c]);
     }
+}
 
-    if (replicateEdges) {
-        OWF_Image_EdgeReplication(dst);
+#ifdef OWF_SIMD_SSE2
+/* (a, b) pairs for _mm_madd_epi16 */
+#define SSE2_COEFF_PAIR(a, b) \
+    _mm_set1_epi32((OWFint)(((OWFuint32)(OWFuint16)(b) << 16) | (OWFuint16)(a)))
+
+/* rounded, shifted and clamped to 0..255 bytes in the low 8 lanes */
+#define SSE2_YUV_CHANNEL(lumaLo, lumaHi, uvLo, uvHi, coeffs)                  \
+    _mm_packus_epi16(                                                        \
+        _mm_packs_epi32(                                                     \
+            _mm_srai_epi32(                                                  \
+                _mm_add_epi32(lumaLo, _mm_madd_epi16(uvLo, coeffs)),         \
+                OWF_YUV_FRACTION_BITS),                                      \
+            _mm_srai_epi32(                                                  \
+                _mm_add_epi32(lumaHi, _mm_madd_epi16(uvHi, coeffs)),         \
+                OWF_YUV_FRACTION_BITS)),                                     \
+        _mm_setzero_si128())
+
+/*
+ * Eight pixels per iteration, starting at an even x. Luma and duplicated
+ * chroma are widened to 16-bit lanes; the products are summed in 32 bits
+ * with _mm_madd_epi16 on interleaved (U, V) pairs.
+ */
+static void OWF_ConvertYuvRowSse2(OWFuint32 *dstPtr, const OWF_YUV_ROW *row,
+                                  const OWF_YUV_COEFFICIENTS *k, OWFint x,
+                                  OWFint count) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i lowBytes = _mm_set1_epi16(0xFF);
+    const __m128i lowWords = _mm_set1_epi32(0xFFFF);
+    const __m128i yOffset = _mm_set1_epi16((short)k->yOffset);
+    const __m128i chromaOffset = _mm_set1_epi16(128);
+    const __m128i ky = SSE2_COEFF_PAIR(k->ky, 0);
+    const __m128i rounding = _mm_set1_epi32(OWF_YUV_ROUNDING);
+    const __m128i kr = SSE2_COEFF_PAIR(0, k->krv);
+    const __m128i kg = SSE2_COEFF_PAIR(k->kgu, k->kgv);
+    const __m128i kb = SSE2_COEFF_PAIR(k->kbu, 0);
+    const __m128i alpha = _mm_set1_epi8((char)0xFF);
+    OWFint i = 0;
+
+    /* odd first pixel shares its chroma with the pixel before it */
+    if ((x & 1) && count > 0) {
+        OWF_ConvertYuvRow(dstPtr, row, k, x, 1);
+        i = 1;
     }
 
-    return OWF_TRUE;
+    for (; i + 8 <= count; i += 8) {
+        OWFint px = x + i;
+        __m128i y16, uv16, u32, v32, u16, v16;
+        __m128i lumaLo, lumaHi, uvLo, uvHi, r, g, b, bg, ra;
+
+        if (row->yStep == 2) {
+            /* YUYV: Y0 U0 Y1 V0 ... */
+            __m128i s = _mm_loadu_si128(
+                (const __m128i *)(row->y + px * 2));
+
+            y16 = _mm_and_si128(s, lowBytes);
+            uv16 = _mm_srli_epi16(s, 8);
+        } else if (row->uvStep == 2) {
+            /* NV12: U0 V0 U1 V1 ... */
+            y16 = _mm_unpacklo_epi8(
+                _mm_loadl_epi64((const __m128i *)(row->y + px)), zero);
+            uv16 = _mm_unpacklo_epi8(
+                _mm_loadl_epi64((const __m128i *)(row->u + px)), zero);
+        } else {
+            /* I420: separate planes */
+            OWFuint32 u4, v4;
+
+            memcpy(&u4, row->u + (px >> 1), 4);
+            memcpy(&v4, row->v + (px >> 1), 4);
+            y16 = _mm_unpacklo_epi8(
+                _mm_loadl_epi64((const __m128i *)(row->y + px)), zero);
+            uv16 = _mm_unpacklo_epi8(
+                _mm_unpacklo_epi8(_mm_cvtsi32_si128((int)u4),
+                                  _mm_cvtsi32_si128((int)v4)),
+                zero);
+        }
+
+        /* chroma of each pair duplicated to both of its pixels */
+        u32 = _mm_and_si128(uv16, lowWords);
+        v32 = _mm_srli_epi32(uv16, 16);
+        u16 = _mm_sub_epi16(_mm_or_si128(u32, _mm_slli_epi32(u32, 16)),
+                            chromaOffset);
+        v16 = _mm_sub_epi16(_mm_or_si128(v32, _mm_slli_epi32(v32, 16)),
+                            chromaOffset);
+        y16 = _mm_sub_epi16(y16, yOffset);
+
+        lumaLo = _mm_add_epi32(
+            _mm_madd_epi16(_mm_unpacklo_epi16(y16, zero), ky), rounding);
+        lumaHi = _mm_add_epi32(
+            _mm_madd_epi16(_mm_unpackhi_epi16(y16, zero), ky), rounding);
+        uvLo = _mm_unpacklo_epi16(u16, v16);
+        uvHi = _mm_unpackhi_epi16(u16, v16);
+
+        r = SSE2_YUV_CHANNEL(lumaLo, lumaHi, uvLo, uvHi, kr);
+        g = SSE2_YUV_CHANNEL(lumaLo, lumaHi, uvLo, uvHi, kg);
+        b = SSE2_YUV_CHANNEL(lumaLo, lumaHi, uvLo, uvHi, kb);
+
+        /* little-endian ARGB8888 words: B G R A */
+        bg = _mm_unpacklo_epi8(b, g);
+        ra = _mm_unpacklo_epi8(r, alpha);
+        _mm_storeu_si128((__m128i *)&dstPtr[i], _mm_unpacklo_epi16(bg, ra));
+        _mm_storeu_si128((__m128i *)&dstPtr[i + 4],
+                         _mm_unpackhi_epi16(bg, ra));
+    }
+
+    if (i < count) {
+        OWF_ConvertYuvRow(dstPtr + i, row, k, x + i, count - i);
+    }
 }
+#endif
 
-/*----------------------------------------------------------------------------*/
-OWF_PUBLIC OWFint OWF_Image_GetStride(OWFint width,
-                                      const OWF_IMAGE_FORMAT *format,
-                                      OWFint minimumStride) {
-    OWFint size;
-    OWFint pixelSize;
+/* converts YUV pixels x .. x + count - 1 of row y via XRGB8888 chunks */
+static void OWF_Image_ConvertYuvSpan(OWFpixel *dstPtr, const OWF_IMAGE *src,
+                                     OWF_CONVERT_ROW_FUNC convertXrgb,
+                                     OWFint x, OWFint y, OWFint count) {
+    OWFuint32 chunk[OWF_YUV_CHUNK_SIZE];
+    const OWF_YUV_COEFFICIENTS *k;
+    OWF_YUV_ROW row;
+#ifdef OWF_SIMD_SSE2
+    const OWFuint32 one = 1;
+    const OWFboolean useSse2 =
+        ((OWF_Cpu_GetFeatures() & OWF_CPU_FEATURE_SSE2) &&
+         *(const OWFuint8 *)&one == 1)
+            ? OWF_TRUE
+            : OWF_FALSE;
+#endif
 
-    OWF_ASSERT(format);
+    k = &yuvCoefficients[CLAMP((OWFint)src->format.yuvColorSpace, 0, 3)];
+    OWF_Image_GetYuvRow(&row, src, y);
 
-    pixelSize = OWF_Image_GetFormatPixelSize(format->pixelFormat);
+    while (count > 0) {
+        OWFint n = MIN(count, OWF_YUV_CHUNK_SIZE);
 
-    if (pixelSize < 0) {
-        /* negative pixelSize means that pixel size is a fraction
-         * (1/-pixelSize) of a byte, e.g. -8 means pixel has size
-         * of one bit. */
+#ifdef OWF_SIMD_SSE2
+        if (useSse2) {
+            OWF_ConvertYuvRowSse2(chunk, &row, k, x, n);
+        } else
+#endif
+        {
+            OWF_ConvertYuvRow(chunk, &row, k, x, n);
+        }
+        convertXrgb(dstPtr, chunk, n);
 
-        size = (width + 1) / -pixelSize;
-    } else {
-        size = width * pixelSize;
+        dstPtr += n;
+        x += n;
+        count -= n;
     }
+}
 
-    if (size < minimumStride) {
-        size = minimumStride;
+/* converts source pixels x .. x + count - 1 of row y */
+static void OWF_Image_ConvertSpan(OWFpixel *dstPtr, const OWF_IMAGE *src,
+                                  OWF_CONVERT_ROW_FUNC convertRow,
+                                  OWFboolean yuv, OWFint x, OWFint y,
+                                  OWFint count) {
+    if (yuv) {
+        OWF_Image_ConvertYuvSpan(dstPtr, src, convertRow, x, y, count);
+    } else {
+        convertRow(dstPtr,
+                   (const OWFuint8 *)src->data + y * src->stride +
+                       x * src->pixelSize,
+                   count);
     }
-    if (format->rowPadding) {
-        size += format->rowPadding - 1;
-        size -= size % format->rowPadding;
+}
+
+/*----------------------------------------------------------------------------*/
+/* formats without an alpha channel are opaque whatever their data is */
+static OWFboolean OWF_Image_FormatIsOpaque(OWF_PIXEL_FORMAT format) {
+    switch (format) {
+        case OWF_IMAGE_XRGB8888:
+        case OWF_IMAGE_RGB888:
+        case OWF_IMAGE_RGB565:
+        case OWF_IMAGE_NV12:
+        case OWF_IMAGE_I420:
+        case OWF_IMAGE_YUYV: {
+            return OWF_TRUE;
+        }
+        default: {
+            return OWF_FALSE;
+        }
     }
+}
 
-    return size;
+/* dst keeps its opacity only where it is not overwritten by rect */
+static void OWF_Image_InheritOpacity(OWF_IMAGE *dst,
+                                     OWF_RECTANGLE const *rect,
+                                     OWFboolean srcOpaque) {
+    if (rect->x <= 0 && rect->y <= 0 && rect->x + rect->width >= dst->width &&
+        rect->y + rect->height >= dst->height) {
+        dst->format.opaque = srcOpaque;
+    } else {
+        dst->format.opaque = dst->format.opaque && srcOpaque;
+    }
 }
 
 /*----------------------------------------------------------------------------*/
-OWF_API_CALL OWFboolean OWF_Image_DestinationFormatConversion(OWF_IMAGE *dst,
-                                                              OWF_IMAGE *src) {
-    OWFint countY;
-    OWFuint32 *dstPtr;
-    OWFpixel *srcPtr;
+OWF_API_CALL OWFboolean OWF_Image_CroppedSourceFormatConversion(
+    OWF_IMAGE *dst, OWF_IMAGE *src, OWF_RECTANGLE const *srcRect) {
+    OWFint x, y, sy, prevSy = -1;
+    OWFint left, middle, firstX;
+    OWFpixel *dstLinePtr;
+    OWF_CONVERT_ROW_FUNC convertRow;
+    OWFboolean yuv;
 
     OWF_ASSERT(dst != 0 && dst->data != NULL);
     OWF_ASSERT(src != 0 && src->data != NULL);
-    OWF_ASSERT(src->format.pixelFormat == OWF_IMAGE_ARGB_INTERNAL);
+    OWF_ASSERT(srcRect != NULL);
+    OWF_ASSERT(dst->format.pixelFormat == OWF_IMAGE_ARGB_INTERNAL);
 
-    if (src->format.pixelFormat != OWF_IMAGE_ARGB_INTERNAL) {
+    if (dst->format.pixelFormat != OWF_IMAGE_ARGB_INTERNAL) {
         return OWF_FALSE;
     }
 
-    /* src and data must have equal amount of pixels */
-    if (dst->width != src->width || dst->height != src->height) {
+    /* dst image must be exactly the size of the source rectangle */
+    if (dst->width != srcRect->width || dst->height != srcRect->height ||
+        src->width <= 0 || src->height <= 0) {
         return OWF_FALSE;
     }
 
-    dstPtr = (OWFuint32 *)dst->data;
-    srcPtr = (OWFpixel *)src->data;
+    yuv = OWF_Image_FormatIsYuv(src->format.pixelFormat);
+    convertRow = OWF_Image_GetConvertRowFunc(
+        yuv ? OWF_IMAGE_XRGB8888 : src->format.pixelFormat);
+    if (!convertRow) {
+        return OWF_FALSE; /* source format not supported */
+    }
 
-    if (dst->format.premultiplied && !src->format.premultiplied) {
-        OWF_Image_PremultiplyAlpha(src);
-    } else if (!dst->format.premultiplied && src->format.premultiplied) {
-        OWF_Image_UnpremultiplyAlpha(src);
-    }
-
-    for (countY = 0; countY < src->height; countY++) {
-        OWFuint8 *destination = (OWFuint8 *)dst->data;
-        destination += countY * dst->stride;
-        dstPtr = (OWFuint32 *)destination;
-
-        switch (dst->format.pixelFormat) {
-            case OWF_IMAGE_ARGB8888: {
-                OWFint countX;
-                OWFuint32 dstPixel = 0;
-
-                for (countX = 0; countX < src->width; countX++) {
-                    dstPixel = ((OWFuint8)(roundSubPixel(OWF_BYTE_MAX_VALUE *
-                                                         srcPtr->color.alpha /
-                                                         OWF_ALPHA_MAX_VALUE))
-                                << ARGB8888_ALPHA_SHIFT);
-                    dstPixel |= ((OWFuint8)(roundSubPixel(OWF_BYTE_MAX_VALUE *
-                                                          srcPtr->color.red /
-                                                          OWF_RED_MAX_VALUE))
-                                 << ARGB8888_RED_SHIFT);
-                    dstPixel |= ((OWFuint8)(roundSubPixel(OWF_BYTE_MAX_VALUE *
-                                                          srcPtr->color.green /
-                                                          OWF_GREEN_MAX_VALUE))
-                                 << ARGB8888_GREEN_SHIFT);
-                    dstPixel |= ((OWFuint8)(roundSubPixel(OWF_BYTE_MAX_VALUE *
-                                                          srcPtr->color.blue /
-                                                          OWF_BLUE_MAX_VALUE))
-                                 << ARGB8888_BLUE_SHIFT);
-                    *dstPtr = dstPixel;
-                    dstPtr++;
-                    srcPtr++;
-                }
-                break;
-            }
+    /* columns of the rectangle left of and inside the source image */
+    left = CLAMP(-srcRect->x, 0, srcRect->width);
+    middle = MIN(srcRect->x + srcRect->width, src->width) -
+             MAX(srcRect->x, 0);
+    middle = MAX(middle, 0);
+
+    /* first source column converted; with no overlap, the nearest edge
+       column is replicated across the whole row */
+    firstX = CLAMP(srcRect->x, 0, src->width - 1);
+
+    dstLinePtr = (OWFpixel *)dst->data;
+
+    for (y = 0; y < srcRect->height; y++) {
+        sy = CLAMP(srcRect->y + y, 0, src->height - 1);
+
+        if (sy == prevSy) {
+            /* replicated edge row */
+            memcpy(dstLinePtr, dstLinePtr - OWF_ROW_PIXELS(dst),
+                   dst->width * sizeof(OWFpixel));
+        } else {
+            if (middle > 0) {
+                OWF_Image_ConvertSpan(dstLinePtr + left, src, convertRow, yuv,
+                                      firstX, sy, middle);
 
-            case OWF_IMAGE_XRGB8888: {
-                OWFint countX;
-                OWFuint32 dstPixel = 0;
-
-                for (countX = 0; countX < src->width; countX++) {
-                    dstPixel = ARGB8888_ALPHA_MASK;
-                    dstPixel |= ((OWFuint8)(roundSubPixel(OWF_BYTE_MAX_VALUE *
-                                                          srcPtr->color.red /
-                                                          OWF_RED_MAX_VALUE))
-                                 << ARGB8888_RED_SHIFT);
-                    dstPixel |= ((OWFuint8)(roundSubPixel(OWF_BYTE_MAX_VALUE *
-                                                          srcPtr->color.green /
-                                                          OWF_GREEN_MAX_VALUE))
-                                 << ARGB8888_GREEN_SHIFT);
-                    dstPixel |= ((OWFuint8)(roundSubPixel(OWF_BYTE_MAX_VALUE *
-                                                          srcPtr->color.blue /
-                                                          OWF_BLUE_MAX_VALUE))
-                                 << ARGB8888_BLUE_SHIFT);
-                    *dstPtr = dstPixel;
-                    dstPtr++;
-                    srcPtr++;
+                for (x = 0; x < left; x++) {
+                    dstLinePtr[x] = dstLinePtr[left];
                 }
-                break;
-            }
+                for (x = left + middle; x < srcRect->width; x++) {
+                    dstLinePtr[x] = dstLinePtr[left + middle - 1];
+                }
+            } else {
+                OWF_Image_ConvertSpan(dstLinePtr, src, convertRow, yuv, firstX,
+                                      sy, 1);
 
-            default: {
-                return OWF_FALSE; /* destination format not supported */
+                for (x = 1; x < srcRect->width; x++) {
+                    dstLinePtr[x] = dstLinePtr[0];
+                }
             }
+            prevSy = sy;
         }
+        dstLinePtr += OWF_ROW_PIXELS(dst);
     }
 
-    return OWF_TRUE;
-}
+    dst->format.opaque = src->format.opaque;
 
-/*----------------------------------------------------------------------------*/
-OWF_API_CALL void OWF_Image_Init(OWF_IMAGE *image) {
-    OWF_ASSERT(NULL != image);
-    memset(image, 0, sizeof(OWF_IMAGE));
+    return OWF_TRUE;
 }
 
 /*----------------------------------------------------------------------------*/
-OWF_PUBLIC OWF_IMAGE *OWF_Image_Create(OWFint width, OWFint height,
-                                       const OWF_IMAGE_FORMAT *format,
-                                       void *buffer, OWFint minimumStride) {
-    OWF_IMAGE *image;
+OWF_API_CALL OWFboolean OWF_Image_ConvertSourceRect(
+    OWF_IMAGE *dst, OWF_RECTANGLE const *dstRect, OWF_IMAGE *src,
+    OWF_RECTANGLE const *srcRect) {
+    OWF_RECTANGLE bounds, rect, drect;
+    OWFint y, sx, sy;
+    OWFpixel *dstLinePtr;
+    OWF_CONVERT_ROW_FUNC convertRow;
+    OWFboolean yuv;
+
+    OWF_ASSERT(dst != 0 && dst->data != NULL);
+    OWF_ASSERT(src != 0 && src->data != NULL);
+    OWF_ASSERT(dstRect != NULL && srcRect != NULL);
+
+    if (dst->format.pixelFormat != OWF_IMAGE_ARGB_INTERNAL) {
+        return OWF_FALSE;
+    }
+
+    /* no scaling, and no edge replication either */
+    if (dstRect->width != srcRect->width ||
+        dstRect->height != srcRect->height || srcRect->x < 0 ||
+        srcRect->y < 0 || srcRect->x + srcRect->width > src->width ||
+        srcRect->y + srcRect->height > src->height) {
+        return OWF_FALSE;
+    }
+
+    yuv = OWF_Image_FormatIsYuv(src->format.pixelFormat);
+    convertRow = OWF_Image_GetConvertRowFunc(
+        yuv ? OWF_IMAGE_XRGB8888 : src->format.pixelFormat);
+    if (!convertRow) {
+        return OWF_FALSE; /* source format not supported */
+    }
+
+    OWF_Rect_Set(&bounds, 0, 0, dst->width, dst->height);
+    OWF_Rect_Set(&rect, dstRect->x, dstRect->y, dstRect->width,
+                 dstRect->height);
+    if (!OWF_Rect_Clip(&drect, &rect, &bounds)) {
+        return OWF_TRUE; /* nothing visible */
+    }
+
+    sx = srcRect->x + (drect.x - rect.x);
+    sy = srcRect->y + (drect.y - rect.y);
+    dstLinePtr =
+        (OWFpixel *)dst->data + drect.y * OWF_ROW_PIXELS(dst) + drect.x;
+
+    for (y = 0; y < drect.height; y++) {
+        OWF_Image_ConvertSpan(dstLinePtr, src, convertRow, yuv, sx, sy + y,
+                              drect.width);
+        dstLinePtr += OWF_ROW_PIXELS(dst);
+    }
+
+    OWF_Image_InheritOpacity(dst, &drect, src->format.opaque);
+
+    return OWF_TRUE;
+}
+
+/*----------------------------------------------------------------------------*/
+OWF_API_CALL OWFboolean
+OWF_Image_IsSupportedSourceFormat(OWF_PIXEL_FORMAT format) {
+    return (OWF_Image_FormatIsYuv(format) ||
+            OWF_Image_GetConvertRowFunc(format) != NULL)
+               ? OWF_TRUE
+               : OWF_FALSE;
+}
+
+/*----------------------------------------------------------------------------*/
+OWF_API_CALL OWFboolean OWF_Image_SourceFormatConversion(OWF_IMAGE *dst,
+                                                         OWF_IMAGE *src) {
+    OWF_RECTANGLE rect;
+
+    OWF_ASSERT(dst != 0 && dst->data != NULL);
+    OWF_ASSERT(src != 0 && src->data != NULL);
+
+    /* dst image must either be the same size as the src image or 2 pixels
+       bigger (enough space to perform edge replication) */
+    if (dst->width == src->width && dst->height == src->height) {
+        OWF_Rect_Set(&rect, 0, 0, src->width, src->height);
+    } else if (dst->width - src->width == 2 && dst->height - src->height == 2) {
+        OWF_Rect_Set(&rect, -1, -1, dst->width, dst->height);
+    } else {
+        return OWF_FALSE;
+    }
+
+    return OWF_Image_CroppedSourceFormatConversion(dst, src, &rect);
+}
+
+/*----------------------------------------------------------------------------*/
+OWF_PUBLIC OWFint OWF_Image_GetStride(OWFint width,
+                                      const OWF_IMAGE_FORMAT *format,
+                                      OWFint minimumStride) {
+    OWFint size;
+    OWFint pixelSize;
+    OWFint padding;
+
+    OWF_ASSERT(format);
+
+    pixelSize = OWF_Image_GetFormatPixelSize(format->pixelFormat);
+
+    if (pixelSize < 0) {
+        /* negative pixelSize means that pixel size is a fraction
+         * (1/-pixelSize) of a byte, e.g. -8 means pixel has size
+         * of one bit. */
+
+        size = (width - pixelSize - 1) / -pixelSize;
+    } else if (OWF_Image_FormatIsYuv(format->pixelFormat)) {
+        /* chroma is shared by pixel pairs, so rows hold whole pairs */
+        size = ((width + 1) & ~1) * pixelSize;
+    } else {
+        size = width * pixelSize;
+    }
+
+    if (size < minimumStride) {
+        size = minimumStride;
+    }
+
+    padding = format->rowPadding;
+    if (format->pixelFormat == OWF_IMAGE_ARGB_INTERNAL) {
+        padding = MAX(padding, OWF_INTERNAL_ROW_PADDING);
+    }
+    if (padding) {
+        size += padding - 1;
+        size -= size % padding;
+    }
+
+    return size;
+}
+
+/*----------------------------------------------------------------------------*/
+/*
+ * Destination format conversion packs one row at a time with a row packer
+ * chosen once per image. Alpha (un)premultiplication is fused into the
+ * packer, so the source image is read once and left unmodified.
+ */
+typedef void (*OWF_PACK_ROW_FUNC)(void *dstLinePtr, const OWFpixel *srcPtr,
+                                  OWFint count);
+
+#define PACK_ALPHA_KEEP 0
+#define PACK_ALPHA_PREMULTIPLY 1
+#define PACK_ALPHA_UNPREMULTIPLY 2
+#define PACK_ALPHA_COUNT 3
+
+#ifdef OWF_IMAGE_INTERNAL_PIXEL_IS_FLOAT
+static OWFuint32 OWF_Image_ClampChannel(OWFfloat value, OWFuint32 bitMax) {
+    if (value <= 0.0f) {
+        return 0;
+    }
+    if (value >= (OWFfloat)bitMax) {
+        return bitMax;
+    }
+    return (OWFuint32)value;
+}
+
+#define PACK_CHANNEL(c, max, bitMax) \
+    OWF_Image_ClampChannel((c) * (OWFfloat)(bitMax) / (max) + 0.5f, bitMax)
+#else
+#define PACK_CHANNEL(c, max, bitMax) \
+    (((OWFuint32)(c) * (bitMax) + (max) / 2) / (max))
+#endif
+
+/* alpha operations on the unpacked subpixels r, g, b and a */
+#define PACK_KEEP_ALPHA() (void)a
+
+#define PACK_PREMULTIPLY_ALPHA()                                          \
+    if (0 == a) {                                                         \
+        r = g = b = 0;                                                    \
+    } else {                                                              \
+        r = (r * a + OWF_PREMUL_ROUNDING_FACTOR) / OWF_ALPHA_MAX_VALUE;   \
+        g = (g * a + OWF_PREMUL_ROUNDING_FACTOR) / OWF_ALPHA_MAX_VALUE;   \
+        b = (b * a + OWF_PREMUL_ROUNDING_FACTOR) / OWF_ALPHA_MAX_VALUE;   \
+    }
+
+#define PACK_UNPREMULTIPLY_ALPHA()                                        \
+    if (a > OWF_ALPHA_MIN_VALUE) {                                        \
+        r = MIN(r * OWF_RED_MAX_VALUE / a, OWF_RED_MAX_VALUE);            \
+        g = MIN(g * OWF_GREEN_MAX_VALUE / a, OWF_GREEN_MAX_VALUE);        \
+        b = MIN(b * OWF_BLUE_MAX_VALUE / a, OWF_BLUE_MAX_VALUE);          \
+    }
+
+/* packing of the subpixels into destination pixel i */
+#define PACK_ARGB8888()                                                   \
+    ((OWFuint32 *)dstLinePtr)[i] =                                        \
+        (PACK_CHANNEL(a, OWF_ALPHA_MAX_VALUE, 255) << ARGB8888_ALPHA_SHIFT) | \
+        (PACK_CHANNEL(r, OWF_RED_MAX_VALUE, 255) << ARGB8888_RED_SHIFT) |  \
+        (PACK_CHANNEL(g, OWF_GREEN_MAX_VALUE, 255) << ARGB8888_GREEN_SHIFT) | \
+        (PACK_CHANNEL(b, OWF_BLUE_MAX_VALUE, 255) << ARGB8888_BLUE_SHIFT)
+
+#define PACK_XRGB8888()                                                   \
+    ((OWFuint32 *)dstLinePtr)[i] =                                        \
+        ARGB8888_ALPHA_MASK |                                             \
+        (PACK_CHANNEL(r, OWF_RED_MAX_VALUE, 255) << ARGB8888_RED_SHIFT) |  \
+        (PACK_CHANNEL(g, OWF_GREEN_MAX_VALUE, 255) << ARGB8888_GREEN_SHIFT) | \
+        (PACK_CHANNEL(b, OWF_BLUE_MAX_VALUE, 255) << ARGB8888_BLUE_SHIFT)
+
+#define PACK_RGB565()                                                     \
+    ((OWFuint16 *)dstLinePtr)[i] = (OWFuint16)(                           \
+        (PACK_CHANNEL(r, OWF_RED_MAX_VALUE, 31) << RGB565_RED_SHIFT) |     \
+        (PACK_CHANNEL(g, OWF_GREEN_MAX_VALUE, 63) << RGB565_GREEN_SHIFT) | \
+        PACK_CHANNEL(b, OWF_BLUE_MAX_VALUE, 31))
+
+#define PACK_ROW_FUNC(name, ALPHA_OP, PACK_OP)                            \
+    static void name(void *dstLinePtr, const OWFpixel *srcPtr,            \
+                     OWFint count) {                                      \
+        OWFint i;                                                         \
+                                                                          \
+        for (i = 0; i < count; i++) {                                     \
+            OWFsubpixel r = srcPtr[i].color.red;                          \
+            OWFsubpixel g = srcPtr[i].color.green;                        \
+            OWFsubpixel b = srcPtr[i].color.blue;                         \
+            OWFsubpixel a = srcPtr[i].color.alpha;                        \
+                                                                          \
+            ALPHA_OP();                                                   \
+            PACK_OP();                                                    \
+        }                                                                 \
+    }
+
+PACK_ROW_FUNC(OWF_PackRow_ARGB8888, PACK_KEEP_ALPHA, PACK_ARGB8888)
+PACK_ROW_FUNC(OWF_PackRow_ARGB8888_Pre, PACK_PREMULTIPLY_ALPHA, PACK_ARGB8888)
+PACK_ROW_FUNC(OWF_PackRow_ARGB8888_Unpre, PACK_UNPREMULTIPLY_ALPHA,
+              PACK_ARGB8888)
+PACK_ROW_FUNC(OWF_PackRow_XRGB8888, PACK_KEEP_ALPHA, PACK_XRGB8888)
+PACK_ROW_FUNC(OWF_PackRow_XRGB8888_Pre, PACK_PREMULTIPLY_ALPHA, PACK_XRGB8888)
+PACK_ROW_FUNC(OWF_PackRow_XRGB8888_Unpre, PACK_UNPREMULTIPLY_ALPHA,
+              PACK_XRGB8888)
+PACK_ROW_FUNC(OWF_PackRow_RGB565, PACK_KEEP_ALPHA, PACK_RGB565)
+PACK_ROW_FUNC(OWF_PackRow_RGB565_Pre, PACK_PREMULTIPLY_ALPHA, PACK_RGB565)
+PACK_ROW_FUNC(OWF_PackRow_RGB565_Unpre, PACK_UNPREMULTIPLY_ALPHA,
+              PACK_RGB565)
+
+static const OWF_PACK_ROW_FUNC packRowARGB8888[PACK_ALPHA_COUNT] = {
+    OWF_PackRow_ARGB8888, OWF_PackRow_ARGB8888_Pre,
+    OWF_PackRow_ARGB8888_Unpre};
+static const OWF_PACK_ROW_FUNC packRowXRGB8888[PACK_ALPHA_COUNT] = {
+    OWF_PackRow_XRGB8888, OWF_PackRow_XRGB8888_Pre,
+    OWF_PackRow_XRGB8888_Unpre};
+static const OWF_PACK_ROW_FUNC packRowRGB565[PACK_ALPHA_COUNT] = {
+    OWF_PackRow_RGB565, OWF_PackRow_RGB565_Pre, OWF_PackRow_RGB565_Unpre};
+
+#ifndef OWF_IMAGE_INTERNAL_PIXEL_IS_FLOAT
+/* packed 8-bit internal pixels already are ARGB8888 on little-endian hosts */
+static void OWF_PackRow_Copy(void *dstLinePtr, const OWFpixel *srcPtr,
+                             OWFint count) {
+    memcpy(dstLinePtr, srcPtr, count * sizeof(OWFpixel));
+}
+
+static void OWF_PackRow_XRGB8888Packed(void *dstLinePtr,
+                                       const OWFpixel *srcPtr, OWFint count) {
+    const OWFuint32 *src32 = (const OWFuint32 *)srcPtr;
+    OWFuint32 *dst32 = (OWFuint32 *)dstLinePtr;
+    OWFint i;
+
+    for (i = 0; i < count; i++) {
+        dst32[i] = src32[i] | ARGB8888_ALPHA_MASK;
+    }
+}
+#endif
+
+#ifdef OWF_SIMD_SSE2
+/*----------------------------------------------------------------------------*/
+/*
+ * SSE2 packers: four pixels per iteration, one pixel per vector of float
+ * lanes in internal (b, g, r, a) order. For packed 8-bit pixels the
+ * integer divisions of the scalar path are done in float, where truncating
+ * the quotient of these small integers gives the exact integer result.
+ * Channels are clamped and saturated to bytes, which come out in ARGB8888
+ * order. A trailing partial group is handed to the scalar packer.
+ */
+#ifdef OWF_IMAGE_INTERNAL_PIXEL_IS_FLOAT
+#define SSE2_PACK_LOAD4(p, srcPtr)                          \
+    p[0] = _mm_loadu_ps((const float *)&(srcPtr)[0]);      \
+    p[1] = _mm_loadu_ps((const float *)&(srcPtr)[1]);      \
+    p[2] = _mm_loadu_ps((const float *)&(srcPtr)[2]);      \
+    p[3] = _mm_loadu_ps((const float *)&(srcPtr)[3])
+#else
+#define SSE2_PACK_LOAD4(p, srcPtr)                                         \
+    {                                                                      \
+        const __m128i zero = _mm_setzero_si128();                          \
+        __m128i s = _mm_loadu_si128((const __m128i *)(srcPtr));            \
+        __m128i lo = _mm_unpacklo_epi8(s, zero);                           \
+        __m128i hi = _mm_unpackhi_epi8(s, zero);                           \
+                                                                           \
+        p[0] = _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero));              \
+        p[1] = _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero));              \
+        p[2] = _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero));              \
+        p[3] = _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero));              \
+    }
+#endif
+
+static __m128 OWF_Sse2_SelectColor(__m128 color, __m128 pixel,
+                                   __m128 select) {
+    return _mm_or_ps(_mm_and_ps(select, color), _mm_andnot_ps(select, pixel));
+}
+
+static __m128 OWF_Sse2_PremultiplyPixel(__m128 v) {
+    const __m128 colorLanes = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+    __m128 a = _mm_shuffle_ps(v, v, 0xFF);
+#ifdef OWF_IMAGE_INTERNAL_PIXEL_IS_FLOAT
+    __m128 color = _mm_mul_ps(v, a);
+#else
+    __m128 color = _mm_div_ps(_mm_add_ps(_mm_mul_ps(v, a), _mm_set1_ps(127.0f)),
+                              _mm_set1_ps(255.0f));
+#endif
+
+    return OWF_Sse2_SelectColor(color, v, colorLanes);
+}
+
+static __m128 OWF_Sse2_UnpremultiplyPixel(__m128 v) {
+    const __m128 colorLanes = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+    const __m128 colorMax = _mm_set1_ps((OWFfloat)OWF_RED_MAX_VALUE);
+    __m128 a = _mm_shuffle_ps(v, v, 0xFF);
+    __m128 select = _mm_and_ps(colorLanes, _mm_cmpgt_ps(a, _mm_setzero_ps()));
+    __m128 color = _mm_min_ps(_mm_div_ps(_mm_mul_ps(v, colorMax), a), colorMax);
+
+    return OWF_Sse2_SelectColor(color, v, select);
+}
+
+static __m128i OWF_Sse2_PackChannels(__m128 v) {
+#ifdef OWF_IMAGE_INTERNAL_PIXEL_IS_FLOAT
+    v = _mm_add_ps(_mm_mul_ps(v, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f));
+#endif
+    v = _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(255.0f));
+    return _mm_cvttps_epi32(v);
+}
+
+#define SSE2_KEEP_ALPHA(v) (v)
+#define SSE2_PREMULTIPLY_ALPHA(v) OWF_Sse2_PremultiplyPixel(v)
+#define SSE2_UNPREMULTIPLY_ALPHA(v) OWF_Sse2_UnpremultiplyPixel(v)
+
+#define SSE2_PACK_ROW_FUNC(name, ALPHA_OP, alphaOr, tailFunc)              \
+    static void name(void *dstLinePtr, const OWFpixel *srcPtr,             \
+                     OWFint count) {                                       \
+        OWFuint32 *dst32 = (OWFuint32 *)dstLinePtr;                        \
+        const __m128i alphaBits = _mm_set1_epi32((OWFint)(alphaOr));       \
+        OWFint i;                                                          \
+                                                                           \
+        for (i = 0; i + 4 <= count; i += 4) {                              \
+            __m128 p[4];                                                   \
+            __m128i lo, hi;                                                \
+                                                                           \
+            SSE2_PACK_LOAD4(p, srcPtr + i);                                \
+            lo = _mm_packs_epi32(OWF_Sse2_PackChannels(ALPHA_OP(p[0])),    \
+                                 OWF_Sse2_PackChannels(ALPHA_OP(p[1])));   \
+            hi = _mm_packs_epi32(OWF_Sse2_PackChannels(ALPHA_OP(p[2])),    \
+                                 OWF_Sse2_PackChannels(ALPHA_OP(p[3])));   \
+            _mm_storeu_si128((__m128i *)&dst32[i],                         \
+                             _mm_or_si128(_mm_packus_epi16(lo, hi),        \
+                                          alphaBits));                     \
+        }                                                                  \
+        if (i < count) {                                                   \
+            tailFunc(dst32 + i, srcPtr + i, count - i);                    \
+        }                                                                  \
+    }
+
+SSE2_PACK_ROW_FUNC(OWF_PackRowSse2_ARGB8888, SSE2_KEEP_ALPHA, 0,
+                   OWF_PackRow_ARGB8888)
+SSE2_PACK_ROW_FUNC(OWF_PackRowSse2_ARGB8888_Pre, SSE2_PREMULTIPLY_ALPHA, 0,
+                   OWF_PackRow_ARGB8888_Pre)
+SSE2_PACK_ROW_FUNC(OWF_PackRowSse2_ARGB8888_Unpre, SSE2_UNPREMULTIPLY_ALPHA, 0,
+                   OWF_PackRow_ARGB8888_Unpre)
+SSE2_PACK_ROW_FUNC(OWF_PackRowSse2_XRGB8888, SSE2_KEEP_ALPHA,
+                   ARGB8888_ALPHA_MASK, OWF_PackRow_XRGB8888)
+SSE2_PACK_ROW_FUNC(OWF_PackRowSse2_XRGB8888_Pre, SSE2_PREMULTIPLY_ALPHA,
+                   ARGB8888_ALPHA_MASK, OWF_PackRow_XRGB8888_Pre)
+SSE2_PACK_ROW_FUNC(OWF_PackRowSse2_XRGB8888_Unpre, SSE2_UNPREMULTIPLY_ALPHA,
+                   ARGB8888_ALPHA_MASK, OWF_PackRow_XRGB8888_Unpre)
+
+static const OWF_PACK_ROW_FUNC packRowSse2ARGB8888[PACK_ALPHA_COUNT] = {
+    OWF_PackRowSse2_ARGB8888, OWF_PackRowSse2_ARGB8888_Pre,
+    OWF_PackRowSse2_ARGB8888_Unpre};
+static const OWF_PACK_ROW_FUNC packRowSse2XRGB8888[PACK_ALPHA_COUNT] = {
+    OWF_PackRowSse2_XRGB8888, OWF_PackRowSse2_XRGB8888_Pre,
+    OWF_PackRowSse2_XRGB8888_Unpre};
+#endif /* OWF_SIMD_SSE2 */
+
+/*----------------------------------------------------------------------------*/
+static OWF_PACK_ROW_FUNC OWF_Image_GetPackRowFunc(OWF_PIXEL_FORMAT format,
+                                                  OWFint alphaOp) {
+#ifndef OWF_IMAGE_INTERNAL_PIXEL_IS_FLOAT
+    const OWFuint32 one = 1;
+    const OWFboolean littleEndian =
+        (*(const OWFuint8 *)&one == 1) ? OWF_TRUE : OWF_FALSE;
+#endif
+#ifdef OWF_SIMD_SSE2
+    const OWFboolean useSse2 =
+        (OWF_Cpu_GetFeatures() & OWF_CPU_FEATURE_SSE2) ? OWF_TRUE : OWF_FALSE;
+#endif
+
+    OWF_ASSERT(alphaOp >= 0 && alphaOp < PACK_ALPHA_COUNT);
+
+    switch (format) {
+        case OWF_IMAGE_ARGB8888: {
+#ifndef OWF_IMAGE_INTERNAL_PIXEL_IS_FLOAT
+            if (littleEndian && PACK_ALPHA_KEEP == alphaOp) {
+                return OWF_PackRow_Copy;
+            }
+#endif
+#ifdef OWF_SIMD_SSE2
+            if (useSse2) {
+                return packRowSse2ARGB8888[alphaOp];
+            }
+#endif
+            return packRowARGB8888[alphaOp];
+        }
+
+        case OWF_IMAGE_XRGB8888: {
+#ifndef OWF_IMAGE_INTERNAL_PIXEL_IS_FLOAT
+            if (littleEndian && PACK_ALPHA_KEEP == alphaOp) {
+                return OWF_PackRow_XRGB8888Packed;
+            }
+#endif
+#ifdef OWF_SIMD_SSE2
+            if (useSse2) {
+                return packRowSse2XRGB8888[alphaOp];
+            }
+#endif
+            return packRowXRGB8888[alphaOp];
+        }
+
+        case OWF_IMAGE_RGB565: {
+            return packRowRGB565[alphaOp];
+        }
+
+        default: {
+            return NULL; /* destination format not supported */
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+OWF_API_CALL OWFboolean OWF_Image_DestinationFormatConversion(OWF_IMAGE *dst,
+                                                              OWF_IMAGE *src) {
+    OWF_RECTANGLE rect;
+
+    OWF_ASSERT(src != 0);
+
+    OWF_Rect_Set(&rect, 0, 0, src->width, src->height);
+    return OWF_Image_DestinationFormatConversionRect(dst, src, &rect);
+}
+
+/*----------------------------------------------------------------------------*/
+OWF_API_CALL OWFboolean OWF_Image_DestinationFormatConversionRect(
+    OWF_IMAGE *dst, OWF_IMAGE *src, OWF_RECTANGLE const *rect) {
+    OWFint countY;
+    OWFuint8 *dstLinePtr;
+    OWFpixel *srcLinePtr;
+    OWFint alphaOp = PACK_ALPHA_KEEP;
+    OWF_PACK_ROW_FUNC packRow;
+    OWF_RECTANGLE bounds, clip, area;
+
+    OWF_ASSERT(dst != 0 && dst->data != NULL);
+    OWF_ASSERT(src != 0 && src->data != NULL);
+    OWF_ASSERT(src->format.pixelFormat == OWF_IMAGE_ARGB_INTERNAL);
+    OWF_ASSERT(rect);
+
+    if (src->format.pixelFormat != OWF_IMAGE_ARGB_INTERNAL) {
+        return OWF_FALSE;
+    }
+
+    /* src and data must have equal amount of pixels */
+    if (dst->width != src->width || dst->height != src->height) {
+        return OWF_FALSE;
+    }
+
+    if (dst->format.premultiplied && !src->format.premultiplied) {
+        alphaOp = PACK_ALPHA_PREMULTIPLY;
+    } else if (!dst->format.premultiplied && src->format.premultiplied) {
+        alphaOp = PACK_ALPHA_UNPREMULTIPLY;
+    }
+
+    packRow = OWF_Image_GetPackRowFunc(dst->format.pixelFormat, alphaOp);
+    if (!packRow) {
+        return OWF_FALSE; /* destination format not supported */
+    }
+
+    OWF_Rect_Set(&bounds, 0, 0, src->width, src->height);
+    OWF_Rect_Set(&clip, rect->x, rect->y, rect->width, rect->height);
+    if (!OWF_Rect_Clip(&area, &clip, &bounds)) {
+        return OWF_TRUE; /* nothing to convert */
+    }
+
+    dstLinePtr = (OWFuint8 *)dst->data + area.y * dst->stride +
+                 area.x * dst->pixelSize;
+    srcLinePtr =
+        (OWFpixel *)src->data + area.y * OWF_ROW_PIXELS(src) + area.x;
+
+    for (countY = 0; countY < area.height; countY++) {
+        packRow(dstLinePtr, srcLinePtr, area.width);
+
+        dstLinePtr += dst->stride;
+        srcLinePtr += OWF_ROW_PIXELS(src);
+    }
+
+    return OWF_TRUE;
+}
+
+/* largest power of two up to OWF_IMAGE_ALIGNMENT dividing both the data
+   address and the stride */
+static void OWF_Image_UpdateAlignment(OWF_IMAGE *image) {
+    OWFint alignment = OWF_IMAGE_ALIGNMENT;
+
+    while (alignment > 1 &&
+           (((size_t)image->data | (size_t)image->stride) & (alignment - 1))) {
+        alignment >>= 1;
+    }
+    image->alignment = alignment;
+}
+
+/*----------------------------------------------------------------------------*/
+OWF_API_CALL void OWF_Image_Init(OWF_IMAGE *image) {
+    OWF_ASSERT(NULL != image);
+    memset(image, 0, sizeof(OWF_IMAGE));
+}
+
+/*----------------------------------------------------------------------------*/
+OWF_PUBLIC OWF_IMAGE *OWF_Image_Create(OWFint width, OWFint height,
+                                       const OWF_IMAGE_FORMAT *format,
+                                       void *buffer, OWFint minimumStride) {
+    OWF_IMAGE *image;
 
     image = CREATE(OWF_IMAGE);
 
@@ -499,6 +1513,12 @@ OWF_PUBLIC OWF_IMAGE *OWF_Image_Create(OWFint width, OWFint height,
         image->format.linear = format->linear;
         image->format.premultiplied = format->premultiplied;
         image->format.rowPadding = format->rowPadding;
+        image->format.opaque = OWF_Image_FormatIsOpaque(format->pixelFormat);
+        /* most callers only set yuvColorSpace for YUV formats */
+        image->format.yuvColorSpace =
+            OWF_Image_FormatIsYuv(format->pixelFormat)
+                ? format->yuvColorSpace
+                : OWF_YUV_BT601_LIMITED;
 
         image->pixelSize = OWF_Image_GetFormatPixelSize(format->pixelFormat);
         image->width = width;
@@ -508,7 +1528,8 @@ OWF_PUBLIC OWF_IMAGE *OWF_Image_Create(OWFint width, OWFint height,
         image->stride =
             OWF_Image_GetStride(width, &image->format, minimumStride);
         image->foreign = (buffer) ? OWF_TRUE : OWF_FALSE;
-        image->dataMax = image->stride * height;
+        image->dataMax = OWF_Image_GetDataSize(image->stride, height,
+                                               format->pixelFormat);
 
         DPRINT(("OWF_Image_Create:"));
         DPRINT(("  Pixel format     = %x", format->pixelFormat));
@@ -522,10 +1543,13 @@ OWF_PUBLIC OWF_IMAGE *OWF_Image_Create(OWFint width, OWFint height,
         DPRINT(("  Foreign data     = %d", image->foreign));
         DPRINT(("  Data size        = %d", image->dataMax));
         if (image->dataMax > 0) {
-            image->data =
-                (image->foreign)
-                    ? (buffer)
-                    : OWF_Image_AllocData(width, height, format->pixelFormat);
+            /* allocated with the image's own stride, which honours both
+               rowPadding and minimumStride */
+            image->data = (image->foreign) ? (buffer)
+                                           : OWF_Image_AllocDataWithStride(
+                                                 image->stride, height,
+                                                 format->pixelFormat);
+            OWF_Image_UpdateAlignment(image);
         } else {
             /* either overflow occured or width/height is zero */
             if (width && height) {
@@ -565,11 +1589,14 @@ OWF_API_CALL OWF_IMAGE *OWF_Image_Copy(const OWF_IMAGE *image) {
     if (newImage) {
         memcpy(newImage, image, sizeof(*newImage));
         if (!image->foreign) {
-            newImage->data = xalloc(1, image->dataMax);
+            newImage->data = xalloc_aligned(1, image->dataMax,
+                                            OWF_IMAGE_ALIGNMENT);
             if (newImage->data) {
                 memcpy(newImage->data, image->data,
-                       image->height * image->stride);
+                       OWF_Image_GetDataSize(image->stride, image->height,
+                                             image->format.pixelFormat));
             }
+            OWF_Image_UpdateAlignment(newImage);
         }
     }
 
@@ -586,13 +1613,14 @@ OWF_API_CALL OWFboolean OWF_Image_SetSize(OWF_IMAGE *image, OWFint width,
 
     /** note that this setsize ignores any specialised stride **/
     stride = OWF_Image_GetStride(width, &image->format, 0);
-    size = height * stride;
+    size = OWF_Image_GetDataSize(stride, height, image->format.pixelFormat);
 
     /* change source size if buffer have enough space */
     if (size > 0 && size <= image->dataMax) {
         image->height = height;
         image->width = width;
         image->stride = stride;
+        OWF_Image_UpdateAlignment(image);
         return OWF_TRUE;
     }
     return OWF_FALSE;
@@ -615,6 +1643,7 @@ OWF_API_CALL void OWF_Image_SetPixelBuffer(OWF_IMAGE *image, void *buffer) {
     OWF_ASSERT(image->foreign);
     if (image->foreign) {
         image->data = buffer;
+        OWF_Image_UpdateAlignment(image);
     }
 }
 /*----------------------------------------------------------------------------*/
@@ -628,7 +1657,7 @@ OWF_API_CALL OWFboolean OWF_Image_SetPixelData(OWF_IMAGE *image, OWFint width,
     OWF_ASSERT(image && format);
 
     stride = OWF_Image_GetStride(width, format, 0);
-    size = height * stride;
+    size = OWF_Image_GetDataSize(stride, height, format->pixelFormat);
 
     if (size <= 0) {
         return OWF_FALSE; /* overflow */
@@ -642,6 +1671,10 @@ OWF_API_CALL OWFboolean OWF_Image_SetPixelData(OWF_IMAGE *image, OWFint width,
     image->format.linear = format->linear;
     image->format.premultiplied = format->premultiplied;
     image->format.rowPadding = format->rowPadding;
+    image->format.opaque = OWF_Image_FormatIsOpaque(format->pixelFormat);
+    image->format.yuvColorSpace = OWF_Image_FormatIsYuv(format->pixelFormat)
+                                      ? format->yuvColorSpace
+                                      : OWF_YUV_BT601_LIMITED;
 
     image->pixelSize = OWF_Image_GetFormatPixelSize(format->pixelFormat);
     image->width = width;
@@ -650,6 +1683,7 @@ OWF_API_CALL OWFboolean OWF_Image_SetPixelData(OWF_IMAGE *image, OWFint width,
     image->foreign = OWF_TRUE;
     image->dataMax = size;
     image->data = buffer;
+    OWF_Image_UpdateAlignment(image);
 
     return OWF_TRUE;
 }
@@ -704,6 +1738,10 @@ OWF_API_CALL OWFboolean OWF_Image_Blit(OWF_IMAGE *dst,
         dstPtr += dst->stride;
     }
 
+    drect.width = srect.width;
+    drect.height = srect.height;
+    OWF_Image_InheritOpacity(dst, &drect, src->format.opaque);
+
     return OWF_TRUE;
 }
 
@@ -718,7 +1756,7 @@ OWF_API_CALL OWFpixel *OWF_Image_GetPixelPtr(OWF_IMAGE *image, OWFint x,
     x = CLAMP(x, 0, image->width - 1);
     y = CLAMP(y, 0, image->height - 1);
 
-    return (OWFpixel *)image->data + y * image->width + x;
+    return (OWFpixel *)image->data + y * OWF_ROW_PIXELS(image) + x;
 }
 
 /*----------------------------------------------------------------------------*/
@@ -742,7 +1780,7 @@ OWF_API_CALL void OWF_Image_GetPixel(OWF_IMAGE *image, OWFint x, OWFint y,
         return;
     }
 
-    temp = (OWFpixel *)image->data + y * image->width + x;
+    temp = (OWFpixel *)image->data + y * OWF_ROW_PIXELS(image) + x;
 
     pixel->color.alpha = temp->color.alpha;
     pixel->color.red = temp->color.red;
@@ -764,21 +1802,29 @@ OWF_API_CALL void OWF_Image_SetPixel(OWF_IMAGE *image, OWFint x, OWFint y,
         return;
     }
 
-    data = (OWFpixel *)image->data + y * image->width + x;
+    data = (OWFpixel *)image->data + y * OWF_ROW_PIXELS(image) + x;
 
     data->color.red = pixel->color.red;
     data->color.green = pixel->color.green;
     data->color.blue = pixel->color.blue;
     data->color.alpha = pixel->color.alpha;
+
+    if (pixel->color.alpha != OWF_FULLY_OPAQUE) {
+        image->format.opaque = OWF_FALSE;
+    }
 }
 
 /*----------------------------------------------------------------------------*/
-OWF_API_CALL OWFboolean OWF_Image_PointSamplingStretchBlit(
-    OWF_IMAGE *dst, OWF_RECTANGLE *dstRect, OWF_IMAGE *src, OWFfloat *srcRect) {
-    OWFint ox = 0, oy = 0;
-    OWFfloat dx = 0.f, dy = 0.f;
-    OWFint x, y;
-
+/*
+ * Common argument validation for the stretch blits: images and rectangles
+ * must be valid and the destination rectangle must lie inside the
+ * destination image. Source coordinates are clamped to the source image by
+ * the blits themselves.
+ */
+static OWFboolean OWF_Image_StretchArgsValid(OWF_IMAGE *dst,
+                                             OWF_RECTANGLE *dstRect,
+                                             OWF_IMAGE *src,
+                                             OWFfloat *srcRect) {
     /* images must be valid */
     if (!((src != NULL) && (src->data != NULL) && (dst != NULL) &&
           (dst->data != NULL))) {
@@ -788,172 +1834,640 @@ OWF_API_CALL OWFboolean OWF_Image_PointSamplingStretchBlit(
     OWF_ASSERT(dst->format.pixelFormat == OWF_IMAGE_ARGB_INTERNAL);
 
     /* ditto with rectangles, too */
-    if (!((dstRect != NULL) && (dstRect->width && dstRect->height) &&
+    if (!((dstRect != NULL) && (dstRect->width > 0 && dstRect->height > 0) &&
           (srcRect != NULL) && (srcRect[2] && srcRect[3]))) {
         return OWF_FALSE;
     }
 
-    /* Note: bounds check missing */
+    if (dstRect->x < 0 || dstRect->y < 0 ||
+        dstRect->x + dstRect->width > dst->width ||
+        dstRect->y + dstRect->height > dst->height) {
+        return OWF_FALSE;
+    }
 
     if (src->pixelSize != dst->pixelSize) {
         return OWF_FALSE;
     }
 
+    return OWF_TRUE;
+}
+
+/*
+ * The resampling kernels read the source through an oriented view: the
+ * source as it would look after OWF_Image_Flip and OWF_Image_Rotate, with
+ * pixel (x, y) of the view at origin + x * stepX + y * stepY. Flipping and
+ * rotating thus cost nothing but a different pair of steps, and the whole
+ * orientation and scaling is done in a single pass.
+ */
+typedef struct {
+    const OWFpixel *origin;
+    OWFint stepX;
+    OWFint stepY;
+    OWFint width;
+    OWFint height;
+} OWF_IMAGE_VIEW;
+
+static void OWF_Image_OrientedView(OWF_IMAGE_VIEW *view, OWF_IMAGE *src,
+                                   OWF_ROTATION rotation,
+                                   OWF_FLIP_DIRECTION flip) {
+    const OWFpixel *origin = (const OWFpixel *)src->data;
+    OWFint w = src->width;
+    OWFint h = src->height;
+    OWFint fx = 1, fy = OWF_ROW_PIXELS(src);
+
+    /* flipped image F(x, y) at origin + x * fx + y * fy */
+    if (flip & OWF_FLIP_HORIZONTALLY) {
+        origin += w - 1;
+        fx = -fx;
+    }
+    if (flip & OWF_FLIP_VERTICALLY) {
+        origin += (h - 1) * fy;
+        fy = -fy;
+    }
+
+    /*
+     * view(u, v) is
+     *   rotation 0:   F(u, v)
+     *   rotation 90:  F(v, h - 1 - u)
+     *   rotation 180: F(w - 1 - u, h - 1 - v)
+     *   rotation 270: F(w - 1 - v, u)
+     */
+    switch (rotation) {
+        case OWF_ROTATION_90: {
+            view->origin = origin + (h - 1) * fy;
+            view->stepX = -fy;
+            view->stepY = fx;
+            break;
+        }
+        case OWF_ROTATION_180: {
+            view->origin = origin + (w - 1) * fx + (h - 1) * fy;
+            view->stepX = -fx;
+            view->stepY = -fy;
+            break;
+        }
+        case OWF_ROTATION_270: {
+            view->origin = origin + (w - 1) * fx;
+            view->stepX = fy;
+            view->stepY = -fx;
+            break;
+        }
+        case OWF_ROTATION_0:
+        default: {
+            OWF_ASSERT(OWF_ROTATION_0 == rotation);
+            view->origin = origin;
+            view->stepX = fx;
+            view->stepY = fy;
+            break;
+        }
+    }
+
+    if (OWF_ROTATION_90 == rotation || OWF_ROTATION_270 == rotation) {
+        view->width = h;
+        view->height = w;
+    } else {
+        view->width = w;
+        view->height = h;
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+static OWFboolean OWF_Image_PointSamplingTransform(OWF_IMAGE *dst,
+                                                   OWF_RECTANGLE *dstRect,
+                                                   const OWF_IMAGE_VIEW *view,
+                                                   OWFfloat *srcRect) {
+    OWFint ox = 0, oy = 0, prevOy = -1;
+    OWFfloat dx = 0.f, dy = 0.f;
+    OWFint x, y;
+    OWFint *xIndex;
+    OWFpixel *dstRow;
+
     /* solve scaling ratios for image */
     dx = (OWFfloat)srcRect[2] / (OWFfloat)dstRect->width;
     dy = (OWFfloat)srcRect[3] / (OWFfloat)dstRect->height;
 
-    for (y = 0; y < dstRect->height; y++) {
-        for (x = 0; x < dstRect->width; x++) {
-            OWFpixel *pixel;
+    xIndex = xalloc(dstRect->width, sizeof(OWFint));
+    if (!xIndex) {
+        return OWF_FALSE;
+    }
+
+    /* NOTE This code uses pixel center points to calculate distances
+            and factors. Results can differ slightly when pixel corner
+            coordinates are used */
 
-            /* NOTE This code uses pixel center points to calculate distances
-                    and factors. Results can differ slightly when pixel corner
-                    coordinates are used */
+    /* source offset of every destination column, clamped to the image */
+    for (x = 0; x < dstRect->width; x++) {
+        ox = (int)floor((((OWFfloat)x + 0.5) * dx) + srcRect[0]);
+        xIndex[x] = CLAMP(ox, 0, view->width - 1) * view->stepX;
+    }
+
+    dstRow =
+        (OWFpixel *)dst->data + dstRect->y * OWF_ROW_PIXELS(dst) + dstRect->x;
 
-            /* coordinates of nearest pixel in original image */
-            ox = (int)floor((((OWFfloat)x + 0.5) * dx) + srcRect[0]);
-            oy = (int)floor((((OWFfloat)y + 0.5) * dy) + srcRect[1]);
+    for (y = 0; y < dstRect->height; y++) {
+        oy = (int)floor((((OWFfloat)y + 0.5) * dy) + srcRect[1]);
+        oy = CLAMP(oy, 0, view->height - 1);
 
-            pixel = OWF_Image_GetPixelPtr(src, ox, oy);
+        if (oy == prevOy) {
+            /* same source row as the previous destination row */
+            memcpy(dstRow, dstRow - OWF_ROW_PIXELS(dst),
+                   dstRect->width * sizeof(OWFpixel));
+        } else {
+            const OWFpixel *srcRow = view->origin + oy * view->stepY;
 
-            OWF_Image_SetPixel(dst, dstRect->x + x, dstRect->y + y, pixel);
+            for (x = 0; x < dstRect->width; x++) {
+                dstRow[x] = srcRow[xIndex[x]];
+            }
+            prevOy = oy;
         }
+        dstRow += OWF_ROW_PIXELS(dst);
     }
+
+    xfree(xIndex);
+
     return OWF_TRUE;
 }
 
 /*----------------------------------------------------------------------------*/
-OWF_API_CALL OWFboolean OWF_Image_BilinearStretchBlit(OWF_IMAGE *dst,
-                                                      OWF_RECTANGLE *dstRect,
-                                                      OWF_IMAGE *src,
-                                                      OWFfloat *srcRect) {
-    OWFint x = 0, y = 0;
-    OWFint ox = 0, oy = 0;
-    OWFfloat dx = 0.f, dy = 0.f, wx = 0.f, wy = 0.f;
-    OWFfloat w[2 * 2];
-    OWFpixel *sample[4];
-    OWFpixel *pixel = NULL;
-
-    /* images must be valid */
-    if (!((src != NULL) && (src->data != NULL) && (dst != NULL) &&
-          (dst->data != NULL))) {
-        return OWF_FALSE;
+/*
+ * Bilinear stretch is separable: source rows are first scaled horizontally
+ * into a two-row cache, and each destination row is then a linear blend of
+ * two cached rows. Source indices and weights are computed once per stretch
+ * and clamped to the source image, so the inner loops need no edge checks.
+ * Packed 8-bit pixels use 8-bit fixed-point weights.
+ */
+#ifdef OWF_IMAGE_INTERNAL_PIXEL_IS_FLOAT
+typedef OWFfloat OWFstretchweight;
+typedef OWFfloat OWFstretchsum;
+
+#define STRETCH_WEIGHT_ONE 1.0f
+#define STRETCH_WEIGHT(f) (f)
+#define STRETCH_RESULT(v) ((OWFsubpixel)((v) + OWF_BILINEAR_ROUNDING_VALUE))
+#else
+typedef OWFuint32 OWFstretchweight;
+typedef OWFuint16 OWFstretchsum;
+
+#define STRETCH_WEIGHT_BITS 8
+#define STRETCH_WEIGHT_ONE (1 << STRETCH_WEIGHT_BITS)
+#define STRETCH_WEIGHT(f) ((OWFstretchweight)((f)*STRETCH_WEIGHT_ONE + 0.5f))
+#define STRETCH_RESULT(v)                                  \
+    ((OWFsubpixel)(((v) + (1 << (2 * STRETCH_WEIGHT_BITS - 1))) >> \
+                   (2 * STRETCH_WEIGHT_BITS)))
+#endif
+
+/* sample positions use pixel centers; indices are multiplied by step */
+static void OWF_Image_BilinearTaps(OWFint count, OWFfloat origin,
+                                   OWFfloat scale, OWFint limit, OWFint step,
+                                   OWFint *index0, OWFint *index1,
+                                   OWFstretchweight *weight) {
+    OWFint i;
+
+    for (i = 0; i < count; i++) {
+        OWFfloat t = ((OWFfloat)i + 0.5f) * scale + origin - 0.5f;
+        OWFfloat f = (OWFfloat)floor(t);
+        OWFint i0 = (OWFint)f;
+
+        index0[i] = CLAMP(i0, 0, limit - 1) * step;
+        index1[i] = CLAMP(i0 + 1, 0, limit - 1) * step;
+        weight[i] = STRETCH_WEIGHT(t - f);
     }
-    OWF_ASSERT(src->format.pixelFormat == OWF_IMAGE_ARGB_INTERNAL);
-    OWF_ASSERT(dst->format.pixelFormat == OWF_IMAGE_ARGB_INTERNAL);
+}
 
-    /* ditto with rectangles, too */
-    if (!((dstRect != NULL) && (dstRect->width && dstRect->height) &&
-          (srcRect != NULL) && (srcRect[2] && srcRect[3]))) {
-        return OWF_FALSE;
+static void OWF_Image_BilinearRow(OWFstretchsum *sumPtr,
+                                  const OWFpixel *srcRow,
+                                  const OWFint *index0, const OWFint *index1,
+                                  const OWFstretchweight *weight,
+                                  OWFint count) {
+    OWFint x, c;
+
+    for (x = 0; x < count; x++) {
+        const OWFpixel *a = srcRow + index0[x];
+        const OWFpixel *b = srcRow + index1[x];
+        OWFstretchweight wb = weight[x];
+        OWFstretchweight wa = STRETCH_WEIGHT_ONE - wb;
+
+        for (c = 0; c < OWF_PIXEL_SIZE; c++) {
+            sumPtr[c] = (OWFstretchsum)(a->subpixel[c] * wa +
+                                        b->subpixel[c] * wb);
+        }
+        sumPtr += OWF_PIXEL_SIZE;
     }
+}
 
-    if (src->pixelSize != dst->pixelSize) {
+static OWFboolean OWF_Image_BilinearTransform(OWF_IMAGE *dst,
+                                              OWF_RECTANGLE *dstRect,
+                                              const OWF_IMAGE_VIEW *view,
+                                              OWFfloat *srcRect) {
+    OWFint x, y, n, dw, dh;
+    OWFint *xIndex, *yIndex;
+    OWFstretchweight *xWeight, *yWeight;
+    OWFstretchsum *rows[2];
+    OWFint rowTag[2] = {-1, -1};
+    OWFpixel *dstData;
+    void *buffer;
+
+    dw = dstRect->width;
+    dh = dstRect->height;
+
+    /* tables and row cache share one allocation */
+    buffer = xalloc(1, 2 * (dw + dh) * sizeof(OWFint) +
+                           (dw + dh) * sizeof(OWFstretchweight) +
+                           2 * OWF_PIXEL_SIZE * dw * sizeof(OWFstretchsum));
+    if (!buffer) {
         return OWF_FALSE;
     }
 
-    /* solve scaling ratios for image */
-    dx = (OWFfloat)srcRect[2] / (OWFfloat)dstRect->width;
-    dy = (OWFfloat)srcRect[3] / (OWFfloat)dstRect->height;
+    xIndex = (OWFint *)buffer;
+    yIndex = xIndex + 2 * dw;
+    xWeight = (OWFstretchweight *)(yIndex + 2 * dh);
+    yWeight = xWeight + dw;
+    rows[0] = (OWFstretchsum *)(yWeight + dh);
+    rows[1] = rows[0] + OWF_PIXEL_SIZE * dw;
+
+    /* solve scaling ratios and sample taps for image */
+    OWF_Image_BilinearTaps(dw, srcRect[0], srcRect[2] / (OWFfloat)dw,
+                           view->width, view->stepX, xIndex, xIndex + dw,
+                           xWeight);
+    OWF_Image_BilinearTaps(dh, srcRect[1], srcRect[3] / (OWFfloat)dh,
+                           view->height, 1, yIndex, yIndex + dh, yWeight);
+
+    dstData =
+        (OWFpixel *)dst->data + dstRect->y * OWF_ROW_PIXELS(dst) + dstRect->x;
+
+    for (y = 0; y < dh; y++) {
+        const OWFstretchsum *rowPtr[2];
+        OWFsubpixel *dstPtr =
+            (OWFsubpixel *)(dstData + y * OWF_ROW_PIXELS(dst));
+        OWFstretchweight wb = yWeight[y];
+        OWFstretchweight wa = STRETCH_WEIGHT_ONE - wb;
+
+        /* fetch both source rows, scaling those not cached yet */
+        for (n = 0; n < 2; n++) {
+            OWFint want = yIndex[y + n * dh];
+            OWFint keep = yIndex[y + (1 - n) * dh];
+            OWFint slot;
+
+            if (rowTag[0] == want) {
+                slot = 0;
+            } else if (rowTag[1] == want) {
+                slot = 1;
+            } else {
+                slot = (rowTag[0] == keep) ? 1 : 0;
+                OWF_Image_BilinearRow(rows[slot],
+                                      view->origin + want * view->stepY,
+                                      xIndex, xIndex + dw, xWeight, dw);
+                rowTag[slot] = want;
+            }
+            rowPtr[n] = rows[slot];
+        }
 
-    for (y = 0; y < dstRect->height; y++) {
-        for (x = 0; x < dstRect->width; x++) {
-            OWFfloat tempOx, tempOy;
+        for (x = 0; x < OWF_PIXEL_SIZE * dw; x++) {
+            dstPtr[x] = STRETCH_RESULT(rowPtr[0][x] * wa + rowPtr[1][x] * wb);
+        }
+    }
+
+    xfree(buffer);
+
+    return OWF_TRUE;
+}
+
+/*----------------------------------------------------------------------------*/
+/*
+ * Area and Lanczos-2 stretch are two-pass separable filters. For both axes
+ * the taps (first source index, tap count and normalized weights) of every
+ * output pixel are computed once per stretch, with source indices clamped
+ * to the image. The horizontal pass filters every source row the vertical
+ * taps reach into a float buffer, and the vertical pass accumulates weighted
+ * buffer rows into one destination row at a time.
+ */
+typedef struct {
+    OWFint *start;    /* first source index of each output pixel */
+    OWFint *count;    /* number of taps of each output pixel */
+    OWFfloat *weight; /* maxTaps weights per output pixel */
+    OWFint maxTaps;
+} OWF_FILTER_TAPS;
+
+#define OWF_LANCZOS_LOBES 2
+#define OWF_PI 3.14159265358979323846
+
+static OWFfloat OWF_Image_Lanczos2(OWFfloat x) {
+    OWFfloat px;
+
+    if (x < 0.0f) {
+        x = -x;
+    }
+    if (x < 1e-6f) {
+        return 1.0f;
+    }
+    if (x >= OWF_LANCZOS_LOBES) {
+        return 0.0f;
+    }
+
+    px = (OWFfloat)OWF_PI * x;
+    return (OWFfloat)(OWF_LANCZOS_LOBES * sin(px) *
+                      sin(px / OWF_LANCZOS_LOBES) / (px * px));
+}
 
-            /* NOTE This code uses pixel center points to calculate distances
-                    and factors. Results can differ slightly when pixel corner
-                    coordinates are used */
+static OWFint OWF_Image_FilterMaxTaps(OWFfloat scale, OWF_FILTERING filter) {
+    if (OWF_FILTER_AREA == filter) {
+        return (OWFint)ceil(scale) + 2;
+    }
+    return (OWFint)ceil(2 * OWF_LANCZOS_LOBES * MAX(scale, 1.0f)) + 3;
+}
+
+static void OWF_Image_BuildFilterTaps(OWF_FILTER_TAPS *taps, OWFint count,
+                                      OWFfloat origin, OWFfloat scale,
+                                      OWFint limit, OWF_FILTERING filter) {
+    /* when minifying, the Lanczos kernel is stretched to the source
+       pixel footprint */
+    OWFfloat kernelScale = MAX(scale, 1.0f);
+    OWFint i, j;
+
+    for (i = 0; i < count; i++) {
+        OWFfloat *weight = taps->weight + i * taps->maxTaps;
+        OWFfloat center = ((OWFfloat)i + 0.5f) * scale + origin;
+        OWFfloat lo, hi, sum = 0.0f;
+        OWFint j0, j1, first;
+
+        if (OWF_FILTER_AREA == filter) {
+            lo = center - 0.5f * scale;
+            hi = center + 0.5f * scale;
+            j0 = (OWFint)floor(lo);
+            j1 = (OWFint)ceil(hi) - 1;
+        } else {
+            lo = center - 0.5f - OWF_LANCZOS_LOBES * kernelScale;
+            hi = center - 0.5f + OWF_LANCZOS_LOBES * kernelScale;
+            j0 = (OWFint)floor(lo);
+            j1 = (OWFint)ceil(hi);
+        }
+        OWF_ASSERT(j1 - j0 < taps->maxTaps);
 
-            /* coordinates of nearest pixel in original image */
-            tempOx = (((OWFfloat)x + 0.5) * dx) + srcRect[0];
-            tempOy = (((OWFfloat)y + 0.5) * dy) + srcRect[1];
+        first = CLAMP(j0, 0, limit - 1);
+        taps->start[i] = first;
+        taps->count[i] = CLAMP(j1, 0, limit - 1) - first + 1;
 
-            ox = (int)floor((((OWFfloat)x + 0.5) * dx) + srcRect[0]);
-            oy = (int)floor((((OWFfloat)y + 0.5) * dy) + srcRect[1]);
+        for (j = 0; j < taps->maxTaps; j++) {
+            weight[j] = 0.0f;
+        }
 
-            /* Distances to nearest pixel, eg. fractional part of coordinate */
-            wx = (OWFfloat)ox + 0.5 - tempOx;
-            wy = (OWFfloat)oy + 0.5 - tempOy;
+        /* taps outside the image fold onto the edge pixels */
+        for (j = j0; j <= j1; j++) {
+            OWFfloat w;
 
-            /* If distance is positive, we should use left or upper pixel for
-             * second nearest pixel. */
-            if (wx > 0.0) {
-                ox--;
-                wx = 1.0 - wx;
+            if (OWF_FILTER_AREA == filter) {
+                w = MIN(hi, (OWFfloat)(j + 1)) - MAX(lo, (OWFfloat)j);
+                w = MAX(w, 0.0f);
             } else {
-                wx = -wx; /* abs */
+                w = OWF_Image_Lanczos2(((OWFfloat)j + 0.5f - center) /
+                                       kernelScale);
             }
+            weight[CLAMP(j, 0, limit - 1) - first] += w;
+            sum += w;
+        }
 
-            if (wy > 0.0) {
-                oy--;
-                wy = 1.0 - wy;
-            } else {
-                wy = -wy;
+        if (sum != 0.0f) {
+            for (j = 0; j < taps->count[i]; j++) {
+                weight[j] /= sum;
             }
+        } else {
+            weight[0] = 1.0f;
+        }
+    }
+}
+
+/* horizontal pass: one source row into sumPtr, OWF_PIXEL_SIZE floats per
+   output pixel; neighbouring source pixels are step pixels apart */
+static void OWF_Image_FilterRow(OWFfloat *sumPtr, const OWFpixel *srcRow,
+                                OWFint step, const OWF_FILTER_TAPS *taps,
+                                OWFint count) {
+    OWFint x, k;
 
-            /* Calculate weights for samples */
-            w[0] = (1.0 - wx) * (1.0 - wy);
-            w[1] = wx * (1.0 - wy);
-            w[2] = (1.0 - wx) * wy;
-            w[3] = wx * wy;
+    for (x = 0; x < count; x++) {
+        const OWFpixel *p = srcRow + taps->start[x] * step;
+        const OWFfloat *weight = taps->weight + x * taps->maxTaps;
+        OWFint n = taps->count[x];
 
-            /* get sample */
-            sample[0] = OWF_Image_GetPixelPtr(src, ox + 0, oy + 0);
-            sample[1] = OWF_Image_GetPixelPtr(src, ox + 1, oy + 0);
-            sample[2] = OWF_Image_GetPixelPtr(src, ox + 0, oy + 1);
-            sample[3] = OWF_Image_GetPixelPtr(src, ox + 1, oy + 1);
+#ifdef OWF_SIMD_V4F
+        OWFv4f acc = OWF_V4F_SPLAT(0.0f);
 
-            /* get result pixel */
-            pixel = OWF_Image_GetPixelPtr(dst, x, y);
+        for (k = 0; k < n; k++) {
+#ifdef OWF_IMAGE_INTERNAL_PIXEL_IS_FLOAT
+            OWFv4f v = OWF_V4F_LOAD(&p[k * step]);
+#else
+            OWFv4f v = OWF_V4F_LOAD_U8(&p[k * step]);
+#endif
+            acc = OWF_V4F_ADD(acc, OWF_V4F_MUL(v, OWF_V4F_SPLAT(weight[k])));
+        }
+        OWF_V4F_STORE(sumPtr, acc);
+#else
+        OWFint c;
+
+        for (c = 0; c < OWF_PIXEL_SIZE; c++) {
+            sumPtr[c] = 0.0f;
+        }
+        for (k = 0; k < n; k++) {
+            for (c = 0; c < OWF_PIXEL_SIZE; c++) {
+                sumPtr[c] += weight[k] * p[k * step].subpixel[c];
+            }
+        }
+#endif
+        sumPtr += OWF_PIXEL_SIZE;
+    }
+}
+
+/* vertical pass accumulation: accPtr += weight * sumPtr */
+static void OWF_Image_FilterAccumulate(OWFfloat *accPtr,
+                                       const OWFfloat *sumPtr,
+                                       OWFfloat weight, OWFint count) {
+    OWFint i;
+
+#ifdef OWF_SIMD_V4F
+    OWFv4f w = OWF_V4F_SPLAT(weight);
+
+    for (i = 0; i < count; i++) {
+        OWFv4f v = OWF_V4F_MUL(OWF_V4F_LOAD(sumPtr), w);
+
+        OWF_V4F_STORE(accPtr, OWF_V4F_ADD(OWF_V4F_LOAD(accPtr), v));
+        accPtr += OWF_PIXEL_SIZE;
+        sumPtr += OWF_PIXEL_SIZE;
+    }
+#else
+    for (i = 0; i < OWF_PIXEL_SIZE * count; i++) {
+        accPtr[i] += weight * sumPtr[i];
+    }
+#endif
+}
+
+/* clamp filtered values (Lanczos over- and undershoots) into a pixel */
+static void OWF_Image_FilterStore(OWFpixel *dstPtr, const OWFfloat *accPtr,
+                                  OWFboolean premultiplied, OWFint count) {
+    OWFint x, c;
+
+    for (x = 0; x < count; x++) {
+        OWFfloat alpha = CLAMP(accPtr[3], 0.0f, (OWFfloat)OWF_ALPHA_MAX_VALUE);
+        OWFfloat colorMax = premultiplied ? alpha : OWF_ALPHA_MAX_VALUE;
+
+        for (c = 0; c < 3; c++) {
+            dstPtr->subpixel[c] = (OWFsubpixel)(
+                CLAMP(accPtr[c], 0.0f, colorMax) +
+                OWF_CONVERSION_ROUNDING_VALUE);
+        }
+        dstPtr->color.alpha =
+            (OWFsubpixel)(alpha + OWF_CONVERSION_ROUNDING_VALUE);
+
+        dstPtr++;
+        accPtr += OWF_PIXEL_SIZE;
+    }
+}
+
+static OWFboolean OWF_Image_FilterTransform(OWF_IMAGE *dst,
+                                            OWF_RECTANGLE *dstRect,
+                                            const OWF_IMAGE_VIEW *view,
+                                            OWFfloat *srcRect,
+                                            OWFboolean premultiplied,
+                                            OWF_FILTERING filter) {
+    OWF_FILTER_TAPS xTaps, yTaps;
+    OWFfloat xScale, yScale;
+    OWFfloat *sums, *acc;
+    OWFint x, y, k, dw, dh, rowBase, rowCount;
+    OWFpixel *dstData;
+    OWFint *tapInts;
+    void *buffer;
+
+    dw = dstRect->width;
+    dh = dstRect->height;
+    xScale = srcRect[2] / (OWFfloat)dw;
+    yScale = srcRect[3] / (OWFfloat)dh;
+    xTaps.maxTaps = OWF_Image_FilterMaxTaps(xScale, filter);
+    yTaps.maxTaps = OWF_Image_FilterMaxTaps(yScale, filter);
+
+    /* tap tables come from one allocation */
+    tapInts = xalloc(1, 2 * (dw + dh) * sizeof(OWFint) +
+                            (dw * xTaps.maxTaps + dh * yTaps.maxTaps) *
+                                sizeof(OWFfloat));
+    if (!tapInts) {
+        return OWF_FALSE;
+    }
+    xTaps.start = tapInts;
+    xTaps.count = xTaps.start + dw;
+    yTaps.start = xTaps.count + dw;
+    yTaps.count = yTaps.start + dh;
+    xTaps.weight = (OWFfloat *)(yTaps.count + dh);
+    yTaps.weight = xTaps.weight + dw * xTaps.maxTaps;
+
+    OWF_Image_BuildFilterTaps(&xTaps, dw, srcRect[0], xScale, view->width,
+                              filter);
+    OWF_Image_BuildFilterTaps(&yTaps, dh, srcRect[1], yScale, view->height,
+                              filter);
+
+    /* vertical taps are monotonic, so this is the source row range used */
+    rowBase = yTaps.start[0];
+    rowCount = yTaps.start[dh - 1] + yTaps.count[dh - 1] - rowBase;
+
+    buffer = xalloc(1, (rowCount + 1) * OWF_PIXEL_SIZE * dw * sizeof(OWFfloat));
+    if (!buffer) {
+        xfree(tapInts);
+        return OWF_FALSE;
+    }
+    sums = (OWFfloat *)buffer;
+    acc = sums + rowCount * OWF_PIXEL_SIZE * dw;
 
-            /* calculate final color */
-            pixel->color.red =
-                sample[0]->color.red * w[0] + sample[1]->color.red * w[1] +
-                sample[2]->color.red * w[2] + sample[3]->color.red * w[3] +
-                OWF_BILINEAR_ROUNDING_VALUE;
+    dstData =
+        (OWFpixel *)dst->data + dstRect->y * OWF_ROW_PIXELS(dst) + dstRect->x;
 
-            pixel->color.green =
-                sample[0]->color.green * w[0] + sample[1]->color.green * w[1] +
-                sample[2]->color.green * w[2] + sample[3]->color.green * w[3] +
-                OWF_BILINEAR_ROUNDING_VALUE;
+    for (y = 0; y < rowCount; y++) {
+        OWF_Image_FilterRow(sums + y * OWF_PIXEL_SIZE * dw,
+                            view->origin + (rowBase + y) * view->stepY,
+                            view->stepX, &xTaps, dw);
+    }
 
-            pixel->color.blue =
-                sample[0]->color.blue * w[0] + sample[1]->color.blue * w[1] +
-                sample[2]->color.blue * w[2] + sample[3]->color.blue * w[3] +
-                OWF_BILINEAR_ROUNDING_VALUE;
+    for (y = 0; y < dh; y++) {
+        const OWFfloat *weight = yTaps.weight + y * yTaps.maxTaps;
+        const OWFfloat *sumRow =
+            sums + (yTaps.start[y] - rowBase) * OWF_PIXEL_SIZE * dw;
 
-            pixel->color.alpha =
-                sample[0]->color.alpha * w[0] + sample[1]->color.alpha * w[1] +
-                sample[2]->color.alpha * w[2] + sample[3]->color.alpha * w[3] +
-                OWF_BILINEAR_ROUNDING_VALUE;
+        for (x = 0; x < OWF_PIXEL_SIZE * dw; x++) {
+            acc[x] = 0.0f;
+        }
+        for (k = 0; k < yTaps.count[y]; k++) {
+            OWF_Image_FilterAccumulate(acc, sumRow, weight[k], dw);
+            sumRow += OWF_PIXEL_SIZE * dw;
         }
+
+        OWF_Image_FilterStore(dstData + y * OWF_ROW_PIXELS(dst), acc,
+                              premultiplied, dw);
     }
+
+    xfree(buffer);
+    xfree(tapInts);
+
     return OWF_TRUE;
 }
 
 /*----------------------------------------------------------------------------*/
-OWF_API_CALL OWFboolean OWF_Image_Stretch(OWF_IMAGE *dst,
-                                          OWF_RECTANGLE *dstRect,
-                                          OWF_IMAGE *src, OWFfloat *srcRect,
-                                          OWF_FILTERING filter) {
+OWF_API_CALL OWF_FILTERING OWF_Image_SelectQualityFilter(OWFfloat xRatio,
+                                                         OWFfloat yRatio) {
+    OWFfloat ratio = MAX(xRatio, yRatio);
+
+    if (ratio > 4.0f) {
+        return OWF_FILTER_AREA;
+    }
+    if (ratio > 2.0f) {
+        return OWF_FILTER_LANCZOS2;
+    }
+    return OWF_FILTER_BILINEAR;
+}
+
+/*----------------------------------------------------------------------------*/
+OWF_API_CALL OWFboolean OWF_Image_Transform(OWF_IMAGE *dst,
+                                            OWF_RECTANGLE *dstRect,
+                                            OWF_IMAGE *src, OWFfloat *srcRect,
+                                            OWF_ROTATION rotation,
+                                            OWF_FLIP_DIRECTION flip,
+                                            OWF_FILTERING filter) {
+    OWF_IMAGE_VIEW view;
     OWFboolean result = OWF_FALSE;
 
+    if (!OWF_Image_StretchArgsValid(dst, dstRect, src, srcRect)) {
+        return OWF_FALSE;
+    }
+
+    OWF_Image_OrientedView(&view, src, rotation, flip);
+
     switch (filter) {
         case OWF_FILTER_POINT_SAMPLING: {
             result =
-                OWF_Image_PointSamplingStretchBlit(dst, dstRect, src, srcRect);
+                OWF_Image_PointSamplingTransform(dst, dstRect, &view, srcRect);
             break;
         }
         case OWF_FILTER_BILINEAR: {
-            result = OWF_Image_BilinearStretchBlit(dst, dstRect, src, srcRect);
+            result = OWF_Image_BilinearTransform(dst, dstRect, &view, srcRect);
             break;
         }
+        case OWF_FILTER_AREA:
+        case OWF_FILTER_LANCZOS2: {
+            result = OWF_Image_FilterTransform(dst, dstRect, &view, srcRect,
+                                               src->format.premultiplied,
+                                               filter);
+            break;
+        }
+    }
+
+    if (result) {
+        OWF_Image_InheritOpacity(dst, dstRect, src->format.opaque);
     }
 
     return result;
 }
 
+/*----------------------------------------------------------------------------*/
+OWF_API_CALL OWFboolean OWF_Image_Stretch(OWF_IMAGE *dst,
+                                          OWF_RECTANGLE *dstRect,
+                                          OWF_IMAGE *src, OWFfloat *srcRect,
+                                          OWF_FILTERING filter) {
+    return OWF_Image_Transform(dst, dstRect, src, srcRect, OWF_ROTATION_0,
+                               OWF_FLIP_NONE, filter);
+}
+
 /*----------------------------------------------------------------------------*/
 OWF_API_CALL void OWF_Image_Clear(OWF_IMAGE *image, OWFsubpixel red,
                                   OWFsubpixel green, OWFsubpixel blue,
@@ -965,7 +2479,8 @@ OWF_API_CALL void OWF_Image_Clear(OWF_IMAGE *image, OWFsubpixel red,
     OWF_ASSERT(image->data != 0);
     OWF_ASSERT(image->format.pixelFormat == OWF_IMAGE_ARGB_INTERNAL);
 
-    numPixels = image->width * image->height;
+    /* row padding is cleared too, so the image is one run of pixels */
+    numPixels = OWF_ROW_PIXELS(image) * image->height;
     pixels = (OWFpixel *)image->data;
 
     for (i = 0; i < numPixels; i++) {
@@ -974,6 +2489,44 @@ OWF_API_CALL void OWF_Image_Clear(OWF_IMAGE *image, OWFsubpixel red,
         pixels[i].color.blue = (OWFsubpixel)blue;
         pixels[i].color.alpha = (OWFsubpixel)alpha;
     }
+
+    image->format.opaque = (alpha == OWF_FULLY_OPAQUE) ? OWF_TRUE : OWF_FALSE;
+}
+
+/*----------------------------------------------------------------------------*/
+OWF_API_CALL void OWF_Image_ClearRect(OWF_IMAGE *image,
+                                      OWF_RECTANGLE const *rect,
+                                      OWFsubpixel red, OWFsubpixel green,
+                                      OWFsubpixel blue, OWFsubpixel alpha) {
+    OWF_RECTANGLE bounds, clip, area;
+    OWFint x, y;
+
+    OWF_ASSERT(image != 0);
+    OWF_ASSERT(image->data != 0);
+    OWF_ASSERT(image->format.pixelFormat == OWF_IMAGE_ARGB_INTERNAL);
+    OWF_ASSERT(rect);
+
+    OWF_Rect_Set(&bounds, 0, 0, image->width, image->height);
+    OWF_Rect_Set(&clip, rect->x, rect->y, rect->width, rect->height);
+    if (!OWF_Rect_Clip(&area, &clip, &bounds)) {
+        return;
+    }
+
+    for (y = area.y; y < area.y + area.height; y++) {
+        OWFpixel *pixels =
+            (OWFpixel *)image->data + y * OWF_ROW_PIXELS(image);
+
+        for (x = area.x; x < area.x + area.width; x++) {
+            pixels[x].color.red = red;
+            pixels[x].color.green = green;
+            pixels[x].color.blue = blue;
+            pixels[x].color.alpha = alpha;
+        }
+    }
+
+    OWF_Image_InheritOpacity(image, &area,
+                             (alpha == OWF_FULLY_OPAQUE) ? OWF_TRUE
+                                                         : OWF_FALSE);
 }
 
 /*----------------------------------------------------------------------------*/
@@ -991,6 +2544,12 @@ OWF_API_CALL void OWF_Image_PremultiplyAlpha(OWF_IMAGE *image) {
         return;
     }
 
+    /* multiplying by a fully opaque alpha changes nothing */
+    if (image->format.opaque) {
+        image->format.premultiplied = OWF_TRUE;
+        return;
+    }
+
     for (y = 0; y < image->height; y++) {
         for (x = 0; x < image->width; x++) {
             OWFpixel *pixel;
@@ -1021,8 +2580,7 @@ OWF_API_CALL void OWF_Image_PremultiplyAlpha(OWF_IMAGE *image) {
 
 /*----------------------------------------------------------------------------*/
 OWF_API_CALL void OWF_Image_UnpremultiplyAlpha(OWF_IMAGE *image) {
-    OWFint count;
-    OWFpixel *pixelPtr;
+    OWFint x, y;
 
     OWF_ASSERT(image != 0);
 
@@ -1035,203 +2593,993 @@ OWF_API_CALL void OWF_Image_UnpremultiplyAlpha(OWF_IMAGE *image) {
         return;
     }
 
-    count = image->width * image->height;
-    pixelPtr = (OWFpixel *)image->data;
+    if (image->format.opaque) {
+        image->format.premultiplied = OWF_FALSE;
+        return;
+    }
+
+    for (y = 0; y < image->height; y++) {
+        OWFpixel *pixelPtr =
+            (OWFpixel *)image->data + y * OWF_ROW_PIXELS(image);
+
+        for (x = 0; x < image->width; x++, pixelPtr++) {
+            OWFsubpixel a = pixelPtr->color.alpha;
+
+#ifdef OWF_IMAGE_INTERNAL_PIXEL_IS_FLOAT
+            OWF_ASSERT(a <= OWF_ALPHA_MAX_VALUE && a >= OWF_ALPHA_MIN_VALUE);
+#endif
+
+            if (a > OWF_ALPHA_MIN_VALUE) {
+                /* clamp so that packed subpixels can't wrap around */
+                OWFsubpixel r =
+                    MIN(pixelPtr->color.red * OWF_RED_MAX_VALUE / a,
+                        OWF_RED_MAX_VALUE);
+                OWFsubpixel g =
+                    MIN(pixelPtr->color.green * OWF_GREEN_MAX_VALUE / a,
+                        OWF_GREEN_MAX_VALUE);
+                OWFsubpixel b =
+                    MIN(pixelPtr->color.blue * OWF_BLUE_MAX_VALUE / a,
+                        OWF_BLUE_MAX_VALUE);
+
+                pixelPtr->color.red = r;
+                pixelPtr->color.green = g;
+                pixelPtr->color.blue = b;
+            }
+        }
+    }
+
+    image->format.premultiplied = OWF_FALSE;
+}
+
+/*----------------------------------------------------------------------------*/
+/*
+ * 90 and 270 degree rotations are transposes, which walk the destination
+ * (or the source) column-wise. They are done in square tiles small enough
+ * for the touched source and destination rows to stay cached.
+ */
+#define OWF_ROTATE_TILE_SIZE 16
+
+OWF_API_CALL void OWF_Image_Rotate(OWF_IMAGE *dst, OWF_IMAGE *src,
+                                   OWF_ROTATION rotation) {
+    OWFint w, h, x, y, tx, ty, xEnd, yEnd;
+    OWFint dstWidth, dstHeight, srcPitch, dstPitch;
+    OWFpixel *srcData, *dstData;
+
+    OWF_ASSERT(src && src->data);
+    OWF_ASSERT(dst && dst->data);
+    OWF_ASSERT(src->format.pixelFormat == OWF_IMAGE_ARGB_INTERNAL);
+    OWF_ASSERT(dst->format.pixelFormat == OWF_IMAGE_ARGB_INTERNAL);
+
+    w = src->width;
+    h = src->height;
+
+    if (OWF_ROTATION_90 == rotation || OWF_ROTATION_270 == rotation) {
+        dstWidth = h;
+        dstHeight = w;
+    } else {
+        dstWidth = w;
+        dstHeight = h;
+    }
+
+    OWF_ASSERT(dst->width >= dstWidth && dst->height >= dstHeight);
+    if (dst->width < dstWidth || dst->height < dstHeight) {
+        return;
+    }
+
+    srcData = (OWFpixel *)src->data;
+    dstData = (OWFpixel *)dst->data;
+    srcPitch = OWF_ROW_PIXELS(src);
+    dstPitch = OWF_ROW_PIXELS(dst);
+
+    if (dst->width == dstWidth && dst->height == dstHeight) {
+        dst->format.opaque = src->format.opaque;
+    } else {
+        dst->format.opaque = dst->format.opaque && src->format.opaque;
+    }
+
+    /*
+     * p_dst(x_src, y_src) is
+     *   rotation 0:   (x, y)
+     *   rotation 90:  (h - 1 - y, x)
+     *   rotation 180: (w - 1 - x, h - 1 - y)
+     *   rotation 270: (y, w - 1 - x)
+     */
+    switch (rotation) {
+        case OWF_ROTATION_0: {
+            for (y = 0; y < h; y++) {
+                memcpy(dstData + y * dstPitch, srcData + y * srcPitch,
+                       w * sizeof(OWFpixel));
+            }
+            break;
+        }
+
+        case OWF_ROTATION_180: {
+            for (y = 0; y < h; y++) {
+                const OWFpixel *srcRow = srcData + y * srcPitch;
+                OWFpixel *dstRow = dstData + (h - 1 - y) * dstPitch + w - 1;
+
+                for (x = 0; x < w; x++) {
+                    dstRow[-x] = srcRow[x];
+                }
+            }
+            break;
+        }
+
+        case OWF_ROTATION_90:
+        case OWF_ROTATION_270: {
+            for (ty = 0; ty < h; ty += OWF_ROTATE_TILE_SIZE) {
+                yEnd = MIN(ty + OWF_ROTATE_TILE_SIZE, h);
+
+                for (tx = 0; tx < w; tx += OWF_ROTATE_TILE_SIZE) {
+                    xEnd = MIN(tx + OWF_ROTATE_TILE_SIZE, w);
+
+                    /* each source column of the tile becomes a
+                       destination row */
+                    for (x = tx; x < xEnd; x++) {
+                        const OWFpixel *srcCol = srcData + x;
+                        OWFpixel *dstRow;
+
+                        if (OWF_ROTATION_90 == rotation) {
+                            dstRow = dstData + x * dstPitch + h - 1;
+                            for (y = ty; y < yEnd; y++) {
+                                dstRow[-y] = srcCol[y * srcPitch];
+                            }
+                        } else {
+                            dstRow = dstData + (w - 1 - x) * dstPitch;
+                            for (y = ty; y < yEnd; y++) {
+                                dstRow[y] = srcCol[y * srcPitch];
+                            }
+                        }
+                    }
+                }
+            }
+            break;
+        }
+
+        default: {
+            OWF_ASSERT(0);
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+/* pixels per chunk when swapping rows through a stack buffer */
+#define OWF_FLIP_CHUNK_SIZE 64
+
+static void OWF_Image_SwapRows(OWFpixel *rowA, OWFpixel *rowB, OWFint count) {
+    OWFpixel tmp[OWF_FLIP_CHUNK_SIZE];
+
+    while (count > 0) {
+        OWFint n = MIN(count, OWF_FLIP_CHUNK_SIZE);
+        size_t bytes = n * sizeof(OWFpixel);
+
+        memcpy(tmp, rowA, bytes);
+        memcpy(rowA, rowB, bytes);
+        memcpy(rowB, tmp, bytes);
+
+        rowA += n;
+        rowB += n;
+        count -= n;
+    }
+}
+
+static void OWF_Image_ReverseRow(OWFpixel *row, OWFint count) {
+    OWFpixel *left = row;
+    OWFpixel *right = row + count - 1;
+
+#if !defined(OWF_IMAGE_INTERNAL_PIXEL_IS_FLOAT) && defined(OWF_SIMD_SSE2)
+    /* packed pixels: reverse four at a time from both ends */
+    if (OWF_Cpu_GetFeatures() & OWF_CPU_FEATURE_SSE2) {
+        while (right - left >= 7) {
+            __m128i l = _mm_loadu_si128((const __m128i *)left);
+            __m128i r = _mm_loadu_si128((const __m128i *)(right - 3));
+
+            _mm_storeu_si128((__m128i *)left, _mm_shuffle_epi32(r, 0x1B));
+            _mm_storeu_si128((__m128i *)(right - 3),
+                             _mm_shuffle_epi32(l, 0x1B));
+            left += 4;
+            right -= 4;
+        }
+    }
+#endif
+
+    while (left < right) {
+        OWFpixel tmp = *left;
+
+        *left++ = *right;
+        *right-- = tmp;
+    }
+}
+
+OWF_API_CALL void OWF_Image_Flip(OWF_IMAGE *image, OWF_FLIP_DIRECTION dir) {
+    OWFint y;
+    OWFpixel *data;
+
+    if (!image) {
+        return;
+    }
+    OWF_ASSERT(image->format.pixelFormat == OWF_IMAGE_ARGB_INTERNAL);
+
+    data = (OWFpixel *)image->data;
+
+    if (dir & OWF_FLIP_VERTICALLY) {
+        OWFint h = image->height / 2;
+
+        for (y = 0; y < h; y++) {
+            OWF_Image_SwapRows(
+                data + y * OWF_ROW_PIXELS(image),
+                data + (image->height - 1 - y) * OWF_ROW_PIXELS(image),
+                image->width);
+        }
+    }
+
+    if (dir & OWF_FLIP_HORIZONTALLY) {
+        for (y = 0; y < image->height; y++) {
+            OWF_Image_ReverseRow(data + y * OWF_ROW_PIXELS(image),
+                                 image->width);
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+/*
+ * Blending is done one row at a time by row kernels specialized per blend
+ * mode. The scalar kernels are the reference implementation; vectorized
+ * kernels must produce identical results. The destinationFullyOpaque flag
+ * is resolved once per row. With a transparent source color, a coverage
+ * mask of each row is computed first with integer compares, and the
+ * unkeyed kernels are run over the runs of covered pixels.
+ */
+typedef void (*OWF_BLEND_ROW_FUNC)(const OWF_BLEND_INFO *blend,
+                                   OWFpixel *dstPtr, const OWFpixel *srcPtr,
+                                   const OWFsubpixel *maskPtr, OWFint count);
+
+/* indices to blend row kernel tables */
+#define BLEND_MODE_NONE 0
+#define BLEND_MODE_GA 1
+#define BLEND_MODE_SA 2
+#define BLEND_MODE_MASK 3
+#define BLEND_MODE_GA_SA 4
+#define BLEND_MODE_GA_MASK 5
+#define BLEND_MODE_COUNT 6
+
+#define SA srcPtr[i].color.alpha
+#define SR srcPtr[i].color.red
+#define SG srcPtr[i].color.green
+#define SB srcPtr[i].color.blue
+
+#define DA dstPtr[i].color.alpha
+#define DR dstPtr[i].color.red
+#define DG dstPtr[i].color.green
+#define DB dstPtr[i].color.blue
+
+#define MA maskPtr[i]
+#define GA blend->globalAlpha
+
+/*
+rgb     = src.rgb
+alpha    = 1
+*/
+#define BLEND_PIXEL_NONE \
+    DR = SR;             \
+    DG = SG;             \
+    DB = SB;             \
+    DA = OWF_FULLY_OPAQUE;
+
+/*
+rgb        = src.rgb * elem.alpha + dst.rgb * (1 - elem.alpha)
+alpha   = elem.alpha + dst.alpha * (1 - elem.alpha)
+*/
+#define BLEND_PIXEL_GA                                                      \
+    DR = (SR * GA + DR * (OWF_FULLY_OPAQUE - GA) + OWF_BLEND_ROUNDING_VALUE) / \
+         OWF_ALPHA_MAX_VALUE;                                               \
+    DG = (SG * GA + DG * (OWF_FULLY_OPAQUE - GA) + OWF_BLEND_ROUNDING_VALUE) / \
+         OWF_ALPHA_MAX_VALUE;                                               \
+    DB = (SB * GA + DB * (OWF_FULLY_OPAQUE - GA) + OWF_BLEND_ROUNDING_VALUE) / \
+         OWF_ALPHA_MAX_VALUE;                                               \
+    DA = GA + (DA * (OWF_FULLY_OPAQUE - GA) + OWF_BLEND_ROUNDING_VALUE) /      \
+                  OWF_ALPHA_MAX_VALUE;
+
+/*
+rgb     = src.rgb + dst.rgb * (1 - src.alpha)
+alpha    = src.alpha + dst.alpha * (1 - src.alpha)
+*/
+#define BLEND_PIXEL_SA                                                  \
+    DR = SR + (DR * (OWF_FULLY_OPAQUE - SA) + OWF_BLEND_ROUNDING_VALUE) / \
+                  OWF_ALPHA_MAX_VALUE;                                  \
+    DG = SG + (DG * (OWF_FULLY_OPAQUE - SA) + OWF_BLEND_ROUNDING_VALUE) / \
+                  OWF_ALPHA_MAX_VALUE;                                  \
+    DB = SB + (DB * (OWF_FULLY_OPAQUE - SA) + OWF_BLEND_ROUNDING_VALUE) / \
+                  OWF_ALPHA_MAX_VALUE;                                  \
+    DA = SA + (DA * (OWF_FULLY_OPAQUE - SA) + OWF_BLEND_ROUNDING_VALUE) / \
+                  OWF_ALPHA_MAX_VALUE;
+
+/*
+rgb     = src.rgb * mask.alpha + dst.rgb * (1 - mask.alpha)
+alpha    = mask.alpha + dst.alpha * (1 - mask.alpha)
+*/
+#define BLEND_PIXEL_MASK                                                    \
+    DR = (SR * MA + DR * (OWF_FULLY_OPAQUE - MA) + OWF_BLEND_ROUNDING_VALUE) / \
+         OWF_ALPHA_MAX_VALUE;                                               \
+    DG = (SG * MA + DG * (OWF_FULLY_OPAQUE - MA) + OWF_BLEND_ROUNDING_VALUE) / \
+         OWF_ALPHA_MAX_VALUE;                                               \
+    DB = (SB * MA + DB * (OWF_FULLY_OPAQUE - MA) + OWF_BLEND_ROUNDING_VALUE) / \
+         OWF_ALPHA_MAX_VALUE;                                               \
+    DA = MA + (DA * (OWF_FULLY_OPAQUE - MA) + OWF_BLEND_ROUNDING_VALUE) /      \
+                  OWF_ALPHA_MAX_VALUE;
+
+/*
+rgb = src.rgb * elem.a + dst.rgb * (1 - src.a * elem.a)
+a = src.a * elem.a + dst.a * (1 - src.a * elem.a)
+*/
+#define BLEND_PIXEL_GA_SA                                                     \
+    {                                                                         \
+        OWFsubpixel SAEA;                                                     \
+                                                                              \
+        SAEA = (SA * GA + OWF_BLEND_ROUNDING_VALUE) / OWF_ALPHA_MAX_VALUE;    \
+        DR = (SR * GA + DR * (OWF_FULLY_OPAQUE - SAEA) +                      \
+              OWF_BLEND_ROUNDING_VALUE) /                                     \
+             OWF_ALPHA_MAX_VALUE;                                             \
+        DG = (SG * GA + DG * (OWF_FULLY_OPAQUE - SAEA) +                      \
+              OWF_BLEND_ROUNDING_VALUE) /                                     \
+             OWF_ALPHA_MAX_VALUE;                                             \
+        DB = (SB * GA + DB * (OWF_FULLY_OPAQUE - SAEA) +                      \
+              OWF_BLEND_ROUNDING_VALUE) /                                     \
+             OWF_ALPHA_MAX_VALUE;                                             \
+        DA = SAEA + (DA * (OWF_FULLY_OPAQUE - SAEA) +                         \
+                     OWF_BLEND_ROUNDING_VALUE) /                              \
+                        OWF_ALPHA_MAX_VALUE;                                  \
+    }
+
+/*
+rgb    = src.rgb * mask.a * elem.a + dst.rgb * (1 - mask.a * elem.a)
+a     = mask.a * elem.a + dest.a * (1 - mask.a * elem.a)
+*/
+#define BLEND_PIXEL_GA_MASK                                                   \
+    {                                                                         \
+        OWFsubpixel MAEA;                                                     \
+                                                                              \
+        MAEA = MA * GA / OWF_ALPHA_MAX_VALUE;                                 \
+        DR = (SR * MAEA + DR * (OWF_FULLY_OPAQUE - MAEA) +                    \
+              OWF_BLEND_ROUNDING_VALUE) /                                     \
+             OWF_ALPHA_MAX_VALUE;                                             \
+        DG = (SG * MAEA + DG * (OWF_FULLY_OPAQUE - MAEA) +                    \
+              OWF_BLEND_ROUNDING_VALUE) /                                     \
+             OWF_ALPHA_MAX_VALUE;                                             \
+        DB = (SB * MAEA + DB * (OWF_FULLY_OPAQUE - MAEA) +                    \
+              OWF_BLEND_ROUNDING_VALUE) /                                     \
+             OWF_ALPHA_MAX_VALUE;                                             \
+        DA = MAEA + (DA * (OWF_FULLY_OPAQUE - MAEA) +                         \
+                     OWF_BLEND_ROUNDING_VALUE) /                              \
+                        OWF_ALPHA_MAX_VALUE;                                  \
+    }
+
+#define BLENDER_ROW_FUNC(name, BLEND_PIXEL)                                   \
+    static void name(const OWF_BLEND_INFO *blend, OWFpixel *dstPtr,           \
+                     const OWFpixel *srcPtr, const OWFsubpixel *maskPtr,      \
+                     OWFint count) {                                          \
+        OWFint i;                                                             \
+                                                                              \
+        if (blend->destinationFullyOpaque) {                                  \
+            for (i = 0; i < count; i++) {                                     \
+                BLEND_PIXEL                                                   \
+                DA = OWF_FULLY_OPAQUE;                                        \
+            }                                                                 \
+        } else {                                                              \
+            for (i = 0; i < count; i++) {                                     \
+                BLEND_PIXEL                                                   \
+            }                                                                 \
+        }                                                                     \
+        (void)maskPtr;                                                        \
+    }
+
+BLENDER_ROW_FUNC(OWF_BlendRow_None, BLEND_PIXEL_NONE)
+BLENDER_ROW_FUNC(OWF_BlendRow_GA, BLEND_PIXEL_GA)
+BLENDER_ROW_FUNC(OWF_BlendRow_SA, BLEND_PIXEL_SA)
+BLENDER_ROW_FUNC(OWF_BlendRow_Mask, BLEND_PIXEL_MASK)
+BLENDER_ROW_FUNC(OWF_BlendRow_GA_SA, BLEND_PIXEL_GA_SA)
+BLENDER_ROW_FUNC(OWF_BlendRow_GA_Mask, BLEND_PIXEL_GA_MASK)
+
+static const OWF_BLEND_ROW_FUNC blendRowScalar[BLEND_MODE_COUNT] = {
+    OWF_BlendRow_None, OWF_BlendRow_GA,    OWF_BlendRow_SA,
+    OWF_BlendRow_Mask, OWF_BlendRow_GA_SA, OWF_BlendRow_GA_Mask};
+
+#if defined(OWF_IMAGE_INTERNAL_PIXEL_IS_FLOAT) && defined(OWF_SIMD_V4F)
+/*----------------------------------------------------------------------------*/
+/*
+ * Float pixel kernels: one OWFv4f holds one pixel (b, g, r, a). The blend
+ * equations are evaluated in the same order as in the scalar kernels (the
+ * rounding value is zero and OWF_ALPHA_MAX_VALUE is one for float pixels),
+ * so results are bit-exact. For the modes whose alpha equation differs from
+ * the color equation, the source alpha lane is replaced with 1.0 first.
+ */
+typedef union {
+    OWFuint32 bits[4];
+    OWFfloat values[4];
+} OWF_V4F_CONST;
+
+static const OWF_V4F_CONST v4fColorMask = {{0xFFFFFFFF, 0xFFFFFFFF,
+                                            0xFFFFFFFF, 0x00000000}};
+static const OWF_V4F_CONST v4fAllMask = {{0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+                                          0xFFFFFFFF}};
+static const OWF_V4F_CONST v4fAlphaOne = {{0x00000000, 0x00000000,
+                                           0x00000000, 0x3F800000}};
+static const OWF_V4F_CONST v4fZero = {{0x00000000, 0x00000000, 0x00000000,
+                                       0x00000000}};
+
+/* destination alpha fix-up: (v & keep) | force */
+#define V4F_ALPHA_FIXUP_SETUP                                               \
+    OWFv4f colorMask = OWF_V4F_LOAD(v4fColorMask.values);                   \
+    OWFv4f alphaOne = OWF_V4F_LOAD(v4fAlphaOne.values);                     \
+    OWFv4f keep = blend->destinationFullyOpaque                             \
+                      ? colorMask                                           \
+                      : OWF_V4F_LOAD(v4fAllMask.values);                    \
+    OWFv4f force = blend->destinationFullyOpaque                            \
+                       ? alphaOne                                           \
+                       : OWF_V4F_LOAD(v4fZero.values);                      \
+    OWFv4f one = OWF_V4F_SPLAT(OWF_FULLY_OPAQUE);
+
+#define V4F_ALPHA_FIXUP(v) OWF_V4F_OR(OWF_V4F_AND(v, keep), force)
+#define V4F_ALPHA_TO_ONE(v) OWF_V4F_OR(OWF_V4F_AND(v, colorMask), alphaOne)
+
+/* d = s * a + d * (1 - b) */
+#define V4F_LERP(s, d, a, b) \
+    OWF_V4F_ADD(OWF_V4F_MUL(s, a), OWF_V4F_MUL(d, OWF_V4F_SUB(one, b)))
+
+static void OWF_BlendRowV4_None(const OWF_BLEND_INFO *blend, OWFpixel *dstPtr,
+                                const OWFpixel *srcPtr,
+                                const OWFsubpixel *maskPtr, OWFint count) {
+    OWFv4f colorMask = OWF_V4F_LOAD(v4fColorMask.values);
+    OWFv4f alphaOne = OWF_V4F_LOAD(v4fAlphaOne.values);
+    OWFint i;
+
+    for (i = 0; i < count; i++) {
+        OWF_V4F_STORE(&dstPtr[i], V4F_ALPHA_TO_ONE(OWF_V4F_LOAD(&srcPtr[i])));
+    }
+    (void)blend;
+    (void)maskPtr;
+}
+
+static void OWF_BlendRowV4_GA(const OWF_BLEND_INFO *blend, OWFpixel *dstPtr,
+                              const OWFpixel *srcPtr,
+                              const OWFsubpixel *maskPtr, OWFint count) {
+    V4F_ALPHA_FIXUP_SETUP
+    OWFv4f ga = OWF_V4F_SPLAT(GA);
+    OWFint i;
+
+    for (i = 0; i < count; i++) {
+        OWFv4f s = V4F_ALPHA_TO_ONE(OWF_V4F_LOAD(&srcPtr[i]));
+        OWFv4f d = OWF_V4F_LOAD(&dstPtr[i]);
+
+        OWF_V4F_STORE(&dstPtr[i], V4F_ALPHA_FIXUP(V4F_LERP(s, d, ga, ga)));
+    }
+    (void)maskPtr;
+}
+
+static void OWF_BlendRowV4_SA(const OWF_BLEND_INFO *blend, OWFpixel *dstPtr,
+                              const OWFpixel *srcPtr,
+                              const OWFsubpixel *maskPtr, OWFint count) {
+    V4F_ALPHA_FIXUP_SETUP
+    OWFint i;
+
+    for (i = 0; i < count; i++) {
+        OWFv4f s = OWF_V4F_LOAD(&srcPtr[i]);
+        OWFv4f d = OWF_V4F_LOAD(&dstPtr[i]);
+        OWFv4f sa = OWF_V4F_SPLAT3(s);
+
+        d = OWF_V4F_ADD(s, OWF_V4F_MUL(d, OWF_V4F_SUB(one, sa)));
+        OWF_V4F_STORE(&dstPtr[i], V4F_ALPHA_FIXUP(d));
+    }
+    (void)maskPtr;
+}
+
+static void OWF_BlendRowV4_Mask(const OWF_BLEND_INFO *blend, OWFpixel *dstPtr,
+                                const OWFpixel *srcPtr,
+                                const OWFsubpixel *maskPtr, OWFint count) {
+    V4F_ALPHA_FIXUP_SETUP
+    OWFint i;
+
+    for (i = 0; i < count; i++) {
+        OWFv4f s = V4F_ALPHA_TO_ONE(OWF_V4F_LOAD(&srcPtr[i]));
+        OWFv4f d = OWF_V4F_LOAD(&dstPtr[i]);
+        OWFv4f ma = OWF_V4F_SPLAT(MA);
+
+        OWF_V4F_STORE(&dstPtr[i], V4F_ALPHA_FIXUP(V4F_LERP(s, d, ma, ma)));
+    }
+}
+
+static void OWF_BlendRowV4_GA_SA(const OWF_BLEND_INFO *blend,
+                                 OWFpixel *dstPtr, const OWFpixel *srcPtr,
+                                 const OWFsubpixel *maskPtr, OWFint count) {
+    V4F_ALPHA_FIXUP_SETUP
+    OWFv4f ga = OWF_V4F_SPLAT(GA);
+    OWFint i;
+
+    for (i = 0; i < count; i++) {
+        OWFv4f s = OWF_V4F_LOAD(&srcPtr[i]);
+        OWFv4f d = OWF_V4F_LOAD(&dstPtr[i]);
+        OWFv4f saea = OWF_V4F_MUL(OWF_V4F_SPLAT3(s), ga);
+
+        OWF_V4F_STORE(&dstPtr[i], V4F_ALPHA_FIXUP(V4F_LERP(s, d, ga, saea)));
+    }
+    (void)maskPtr;
+}
+
+static void OWF_BlendRowV4_GA_Mask(const OWF_BLEND_INFO *blend,
+                                   OWFpixel *dstPtr, const OWFpixel *srcPtr,
+                                   const OWFsubpixel *maskPtr, OWFint count) {
+    V4F_ALPHA_FIXUP_SETUP
+    OWFint i;
+
+    for (i = 0; i < count; i++) {
+        OWFv4f s = V4F_ALPHA_TO_ONE(OWF_V4F_LOAD(&srcPtr[i]));
+        OWFv4f d = OWF_V4F_LOAD(&dstPtr[i]);
+        OWFv4f maea = OWF_V4F_SPLAT(MA * GA);
+
+        OWF_V4F_STORE(&dstPtr[i], V4F_ALPHA_FIXUP(V4F_LERP(s, d, maea, maea)));
+    }
+}
+
+static const OWF_BLEND_ROW_FUNC blendRowV4[BLEND_MODE_COUNT] = {
+    OWF_BlendRowV4_None, OWF_BlendRowV4_GA,    OWF_BlendRowV4_SA,
+    OWF_BlendRowV4_Mask, OWF_BlendRowV4_GA_SA, OWF_BlendRowV4_GA_Mask};
+
+#if defined(OWF_SIMD_AVX2)
+/*----------------------------------------------------------------------------*/
+/*
+ * 256-bit variants of the float kernels above, two pixels per vector. An odd
+ * trailing pixel is handed to the 128-bit kernel of the same mode.
+ */
+#define V8F_ALPHA_FIXUP_SETUP                                               \
+    __m256 colorMask =                                                      \
+        _mm256_castsi256_ps(_mm256_setr_epi32(-1, -1, -1, 0, -1, -1, -1, 0)); \
+    __m256 alphaOne = _mm256_setr_ps(0, 0, 0, 1, 0, 0, 0, 1);               \
+    __m256 keep = blend->destinationFullyOpaque                             \
+                      ? colorMask                                           \
+                      : _mm256_castsi256_ps(_mm256_set1_epi32(-1));         \
+    __m256 force =                                                          \
+        blend->destinationFullyOpaque ? alphaOne : _mm256_setzero_ps();     \
+    __m256 one = _mm256_set1_ps(OWF_FULLY_OPAQUE);
+
+#define V8F_ALPHA_FIXUP(v) _mm256_or_ps(_mm256_and_ps(v, keep), force)
+#define V8F_ALPHA_TO_ONE(v) \
+    _mm256_or_ps(_mm256_and_ps(v, colorMask), alphaOne)
+#define V8F_LERP(s, d, a, b)                     \
+    _mm256_add_ps(_mm256_mul_ps(s, a),           \
+                  _mm256_mul_ps(d, _mm256_sub_ps(one, b)))
+#define V8F_SPLAT3(v) _mm256_permute_ps(v, 0xFF)
+#define V8F_SPLAT2(f0, f1) _mm256_setr_ps(f0, f0, f0, f0, f1, f1, f1, f1)
+
+#define V8F_TAIL(mode)                                                    \
+    if (i < count) {                                                      \
+        blendRowV4[mode](blend, dstPtr + i, srcPtr + i,                   \
+                         maskPtr ? maskPtr + i : NULL, count - i);        \
+    }
+
+OWF_SIMD_TARGET_AVX2
+static void OWF_BlendRowV8_None(const OWF_BLEND_INFO *blend, OWFpixel *dstPtr,
+                                const OWFpixel *srcPtr,
+                                const OWFsubpixel *maskPtr, OWFint count) {
+    V8F_ALPHA_FIXUP_SETUP
+    OWFint i;
+
+    for (i = 0; i + 2 <= count; i += 2) {
+        __m256 s = _mm256_loadu_ps((const float *)&srcPtr[i]);
+
+        _mm256_storeu_ps((float *)&dstPtr[i], V8F_ALPHA_TO_ONE(s));
+    }
+    V8F_TAIL(BLEND_MODE_NONE)
+    (void)keep;
+    (void)force;
+    (void)one;
+}
+
+OWF_SIMD_TARGET_AVX2
+static void OWF_BlendRowV8_GA(const OWF_BLEND_INFO *blend, OWFpixel *dstPtr,
+                              const OWFpixel *srcPtr,
+                              const OWFsubpixel *maskPtr, OWFint count) {
+    V8F_ALPHA_FIXUP_SETUP
+    __m256 ga = _mm256_set1_ps(GA);
+    OWFint i;
+
+    for (i = 0; i + 2 <= count; i += 2) {
+        __m256 s = V8F_ALPHA_TO_ONE(_mm256_loadu_ps((const float *)&srcPtr[i]));
+        __m256 d = _mm256_loadu_ps((const float *)&dstPtr[i]);
+
+        _mm256_storeu_ps((float *)&dstPtr[i],
+                         V8F_ALPHA_FIXUP(V8F_LERP(s, d, ga, ga)));
+    }
+    V8F_TAIL(BLEND_MODE_GA)
+}
+
+OWF_SIMD_TARGET_AVX2
+static void OWF_BlendRowV8_SA(const OWF_BLEND_INFO *blend, OWFpixel *dstPtr,
+                              const OWFpixel *srcPtr,
+                              const OWFsubpixel *maskPtr, OWFint count) {
+    V8F_ALPHA_FIXUP_SETUP
+    OWFint i;
+
+    for (i = 0; i + 2 <= count; i += 2) {
+        __m256 s = _mm256_loadu_ps((const float *)&srcPtr[i]);
+        __m256 d = _mm256_loadu_ps((const float *)&dstPtr[i]);
+
+        d = _mm256_add_ps(
+            s, _mm256_mul_ps(d, _mm256_sub_ps(one, V8F_SPLAT3(s))));
+        _mm256_storeu_ps((float *)&dstPtr[i], V8F_ALPHA_FIXUP(d));
+    }
+    V8F_TAIL(BLEND_MODE_SA)
+}
+
+OWF_SIMD_TARGET_AVX2
+static void OWF_BlendRowV8_Mask(const OWF_BLEND_INFO *blend, OWFpixel *dstPtr,
+                                const OWFpixel *srcPtr,
+                                const OWFsubpixel *maskPtr, OWFint count) {
+    V8F_ALPHA_FIXUP_SETUP
+    OWFint i;
+
+    for (i = 0; i + 2 <= count; i += 2) {
+        __m256 s = V8F_ALPHA_TO_ONE(_mm256_loadu_ps((const float *)&srcPtr[i]));
+        __m256 d = _mm256_loadu_ps((const float *)&dstPtr[i]);
+        __m256 ma = V8F_SPLAT2(maskPtr[i], maskPtr[i + 1]);
+
+        _mm256_storeu_ps((float *)&dstPtr[i],
+                         V8F_ALPHA_FIXUP(V8F_LERP(s, d, ma, ma)));
+    }
+    V8F_TAIL(BLEND_MODE_MASK)
+}
+
+OWF_SIMD_TARGET_AVX2
+static void OWF_BlendRowV8_GA_SA(const OWF_BLEND_INFO *blend,
+                                 OWFpixel *dstPtr, const OWFpixel *srcPtr,
+                                 const OWFsubpixel *maskPtr, OWFint count) {
+    V8F_ALPHA_FIXUP_SETUP
+    __m256 ga = _mm256_set1_ps(GA);
+    OWFint i;
+
+    for (i = 0; i + 2 <= count; i += 2) {
+        __m256 s = _mm256_loadu_ps((const float *)&srcPtr[i]);
+        __m256 d = _mm256_loadu_ps((const float *)&dstPtr[i]);
+        __m256 saea = _mm256_mul_ps(V8F_SPLAT3(s), ga);
+
+        _mm256_storeu_ps((float *)&dstPtr[i],
+                         V8F_ALPHA_FIXUP(V8F_LERP(s, d, ga, saea)));
+    }
+    V8F_TAIL(BLEND_MODE_GA_SA)
+}
+
+OWF_SIMD_TARGET_AVX2
+static void OWF_BlendRowV8_GA_Mask(const OWF_BLEND_INFO *blend,
+                                   OWFpixel *dstPtr, const OWFpixel *srcPtr,
+                                   const OWFsubpixel *maskPtr, OWFint count) {
+    V8F_ALPHA_FIXUP_SETUP
+    OWFint i;
+
+    for (i = 0; i + 2 <= count; i += 2) {
+        __m256 s = V8F_ALPHA_TO_ONE(_mm256_loadu_ps((const float *)&srcPtr[i]));
+        __m256 d = _mm256_loadu_ps((const float *)&dstPtr[i]);
+        __m256 maea = V8F_SPLAT2(maskPtr[i] * GA, maskPtr[i + 1] * GA);
+
+        _mm256_storeu_ps((float *)&dstPtr[i],
+                         V8F_ALPHA_FIXUP(V8F_LERP(s, d, maea, maea)));
+    }
+    V8F_TAIL(BLEND_MODE_GA_MASK)
+}
+
+static const OWF_BLEND_ROW_FUNC blendRowV8[BLEND_MODE_COUNT] = {
+    OWF_BlendRowV8_None, OWF_BlendRowV8_GA,    OWF_BlendRowV8_SA,
+    OWF_BlendRowV8_Mask, OWF_BlendRowV8_GA_SA, OWF_BlendRowV8_GA_Mask};
+#endif /* OWF_SIMD_AVX2 */
+#endif /* OWF_IMAGE_INTERNAL_PIXEL_IS_FLOAT && OWF_SIMD_V4F */
+
+#if !defined(OWF_IMAGE_INTERNAL_PIXEL_IS_FLOAT) && defined(OWF_SIMD_SSE2)
+/*----------------------------------------------------------------------------*/
+/*
+ * Packed 8-bit pixel kernels: four pixels per iteration, widened to two
+ * vectors of 16-bit lanes holding two pixels each. Divisions by 255 use the
+ * exact identity (x + 127) / 255 == (t + (t >> 8)) >> 8, t = x + 128, valid
+ * for all sums the blend equations can produce, so results match the scalar
+ * kernels. A trailing partial group is handed to the scalar kernel.
+ */
+static __m128i OWF_Sse2_Div255(__m128i x) {
+    __m128i t = _mm_add_epi16(x, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+/* x / 255 truncated */
+static __m128i OWF_Sse2_Div255Trunc(__m128i x) {
+    __m128i t = _mm_add_epi16(x, _mm_set1_epi16(1));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+/* broadcast alpha lanes of two 16-bit widened pixels */
+static __m128i OWF_Sse2_SplatAlpha(__m128i v) {
+    return _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xFF), 0xFF);
+}
+
+/*
+ * color = (s * a + d * (255 - b) + 127) / 255
+ * alpha = b + (d * (255 - b) + 127) / 255
+ */
+static __m128i OWF_Sse2_Lerp(__m128i s, __m128i d, __m128i a, __m128i b) {
+    __m128i alphaLanes = _mm_setr_epi16(0, 0, 0, -1, 0, 0, 0, -1);
+    __m128i t = _mm_mullo_epi16(d, _mm_sub_epi16(_mm_set1_epi16(255), b));
+    __m128i color = OWF_Sse2_Div255(_mm_add_epi16(_mm_mullo_epi16(s, a), t));
+    __m128i alpha = _mm_add_epi16(b, OWF_Sse2_Div255(t));
+
+    return _mm_or_si128(_mm_and_si128(alphaLanes, alpha),
+                        _mm_andnot_si128(alphaLanes, color));
+}
+
+/* mask values of pixels i and i + 1 broadcast to 16-bit lanes */
+#define SSE2_SPLAT_MASK2(m, i)                                              \
+    _mm_setr_epi16(m[i], m[i], m[i], m[i], m[(i) + 1], m[(i) + 1], m[(i) + 1], \
+                   m[(i) + 1])
+
+#define SSE2_ROW_BEGIN(mode)                                                \
+    const __m128i zero = _mm_setzero_si128();                               \
+    const __m128i keep = blend->destinationFullyOpaque                      \
+                             ? _mm_set1_epi32(0x00FFFFFF)                   \
+                             : _mm_set1_epi32(-1);                          \
+    const __m128i force = blend->destinationFullyOpaque                     \
+                              ? _mm_set1_epi32((OWFint)0xFF000000)          \
+                              : zero;                                       \
+    const OWFint tailMode = (mode);                                         \
+    OWFint i;                                                               \
+                                                                            \
+    for (i = 0; i + 4 <= count; i += 4) {                                   \
+        __m128i s = _mm_loadu_si128((const __m128i *)&srcPtr[i]);           \
+        __m128i d = _mm_loadu_si128((const __m128i *)&dstPtr[i]);           \
+        __m128i sLo = _mm_unpacklo_epi8(s, zero);                           \
+        __m128i sHi = _mm_unpackhi_epi8(s, zero);                           \
+        __m128i dLo = _mm_unpacklo_epi8(d, zero);                           \
+        __m128i dHi = _mm_unpackhi_epi8(d, zero);
+
+#define SSE2_ROW_END                                                        \
+        d = _mm_packus_epi16(dLo, dHi);                                     \
+        d = _mm_or_si128(_mm_and_si128(d, keep), force);                    \
+        _mm_storeu_si128((__m128i *)&dstPtr[i], d);                         \
+    }                                                                       \
+    if (i < count) {                                                        \
+        blendRowScalar[tailMode](blend, dstPtr + i, srcPtr + i,             \
+                                 maskPtr ? maskPtr + i : NULL, count - i);  \
+    }
+
+static void OWF_BlendRowSse2_None(const OWF_BLEND_INFO *blend,
+                                  OWFpixel *dstPtr, const OWFpixel *srcPtr,
+                                  const OWFsubpixel *maskPtr, OWFint count) {
+    const __m128i alpha = _mm_set1_epi32((OWFint)0xFF000000);
+    OWFint i;
+
+    for (i = 0; i + 4 <= count; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i *)&srcPtr[i]);
+
+        _mm_storeu_si128((__m128i *)&dstPtr[i], _mm_or_si128(s, alpha));
+    }
+    if (i < count) {
+        OWF_BlendRow_None(blend, dstPtr + i, srcPtr + i, NULL, count - i);
+    }
+    (void)maskPtr;
+}
+
+static void OWF_BlendRowSse2_GA(const OWF_BLEND_INFO *blend, OWFpixel *dstPtr,
+                                const OWFpixel *srcPtr,
+                                const OWFsubpixel *maskPtr, OWFint count) {
+    const __m128i ga = _mm_set1_epi16(GA);
+
+    SSE2_ROW_BEGIN(BLEND_MODE_GA)
+    dLo = OWF_Sse2_Lerp(sLo, dLo, ga, ga);
+    dHi = OWF_Sse2_Lerp(sHi, dHi, ga, ga);
+    SSE2_ROW_END
+}
+
+static void OWF_BlendRowSse2_SA(const OWF_BLEND_INFO *blend, OWFpixel *dstPtr,
+                                const OWFpixel *srcPtr,
+                                const OWFsubpixel *maskPtr, OWFint count) {
+    const __m128i c255 = _mm_set1_epi16(255);
+
+    SSE2_ROW_BEGIN(BLEND_MODE_SA)
+    __m128i invSaLo = _mm_sub_epi16(c255, OWF_Sse2_SplatAlpha(sLo));
+    __m128i invSaHi = _mm_sub_epi16(c255, OWF_Sse2_SplatAlpha(sHi));
+
+    dLo = _mm_add_epi16(sLo, OWF_Sse2_Div255(_mm_mullo_epi16(dLo, invSaLo)));
+    dHi = _mm_add_epi16(sHi, OWF_Sse2_Div255(_mm_mullo_epi16(dHi, invSaHi)));
+    SSE2_ROW_END
+}
 
-    while (count > 0) {
-        OWFsubpixel a = pixelPtr->color.alpha;
+static void OWF_BlendRowSse2_Mask(const OWF_BLEND_INFO *blend,
+                                  OWFpixel *dstPtr, const OWFpixel *srcPtr,
+                                  const OWFsubpixel *maskPtr, OWFint count) {
+    SSE2_ROW_BEGIN(BLEND_MODE_MASK)
+    __m128i maLo = SSE2_SPLAT_MASK2(maskPtr, i);
+    __m128i maHi = SSE2_SPLAT_MASK2(maskPtr, i + 2);
 
-#ifdef OWF_IMAGE_INTERNAL_PIXEL_IS_FLOAT
-        OWF_ASSERT(a <= OWF_ALPHA_MAX_VALUE && a >= OWF_ALPHA_MIN_VALUE);
-#endif
+    dLo = OWF_Sse2_Lerp(sLo, dLo, maLo, maLo);
+    dHi = OWF_Sse2_Lerp(sHi, dHi, maHi, maHi);
+    SSE2_ROW_END
+}
 
-        if (a > OWF_ALPHA_MIN_VALUE) {
-            OWFsubpixel r = pixelPtr->color.red * OWF_RED_MAX_VALUE / a;
-            OWFsubpixel g = pixelPtr->color.green * OWF_GREEN_MAX_VALUE / a;
-            OWFsubpixel b = pixelPtr->color.blue * OWF_BLUE_MAX_VALUE / a;
+static void OWF_BlendRowSse2_GA_SA(const OWF_BLEND_INFO *blend,
+                                   OWFpixel *dstPtr, const OWFpixel *srcPtr,
+                                   const OWFsubpixel *maskPtr, OWFint count) {
+    const __m128i ga = _mm_set1_epi16(GA);
 
-            pixelPtr->color.red = r;
-            pixelPtr->color.green = g;
-            pixelPtr->color.blue = b;
+    SSE2_ROW_BEGIN(BLEND_MODE_GA_SA)
+    __m128i saeaLo =
+        OWF_Sse2_Div255(_mm_mullo_epi16(OWF_Sse2_SplatAlpha(sLo), ga));
+    __m128i saeaHi =
+        OWF_Sse2_Div255(_mm_mullo_epi16(OWF_Sse2_SplatAlpha(sHi), ga));
 
-            --count;
-            pixelPtr++;
-        }
-    }
+    dLo = OWF_Sse2_Lerp(sLo, dLo, ga, saeaLo);
+    dHi = OWF_Sse2_Lerp(sHi, dHi, ga, saeaHi);
+    SSE2_ROW_END
+}
 
-    image->format.premultiplied = OWF_TRUE;
+static void OWF_BlendRowSse2_GA_Mask(const OWF_BLEND_INFO *blend,
+                                     OWFpixel *dstPtr, const OWFpixel *srcPtr,
+                                     const OWFsubpixel *maskPtr,
+                                     OWFint count) {
+    const __m128i ga = _mm_set1_epi16(GA);
+
+    SSE2_ROW_BEGIN(BLEND_MODE_GA_MASK)
+    __m128i maeaLo =
+        OWF_Sse2_Div255Trunc(_mm_mullo_epi16(SSE2_SPLAT_MASK2(maskPtr, i), ga));
+    __m128i maeaHi = OWF_Sse2_Div255Trunc(
+        _mm_mullo_epi16(SSE2_SPLAT_MASK2(maskPtr, i + 2), ga));
+
+    dLo = OWF_Sse2_Lerp(sLo, dLo, maeaLo, maeaLo);
+    dHi = OWF_Sse2_Lerp(sHi, dHi, maeaHi, maeaHi);
+    SSE2_ROW_END
 }
 
-/*----------------------------------------------------------------------------*/
-OWF_API_CALL void OWF_Image_Rotate(OWF_IMAGE *dst, OWF_IMAGE *src,
-                                   OWF_ROTATION rotation) {
-    OWFint ox = 0, oy = 0, w = 0, h = 0, x = 0, y = 0;
-    OWFint xx = 0, xy = 0, yx = 0, yy = 0;
+static const OWF_BLEND_ROW_FUNC blendRowSse2[BLEND_MODE_COUNT] = {
+    OWF_BlendRowSse2_None, OWF_BlendRowSse2_GA,    OWF_BlendRowSse2_SA,
+    OWF_BlendRowSse2_Mask, OWF_BlendRowSse2_GA_SA, OWF_BlendRowSse2_GA_Mask};
+#endif /* !OWF_IMAGE_INTERNAL_PIXEL_IS_FLOAT && OWF_SIMD_SSE2 */
 
-    OWF_ASSERT(src && src->data);
-    OWF_ASSERT(dst && dst->data);
-    OWF_ASSERT(src->format.pixelFormat == OWF_IMAGE_ARGB_INTERNAL);
-    OWF_ASSERT(dst->format.pixelFormat == OWF_IMAGE_ARGB_INTERNAL);
+/*----------------------------------------------------------------------------*/
+static OWF_BLEND_ROW_FUNC OWF_Image_GetBlendRowFunc(OWFint mode) {
+    OWFuint32 features;
 
-    w = src->width;
-    h = src->height;
+    features = OWF_Cpu_GetFeatures();
+    (void)features;
 
-    switch (rotation) {
-        case OWF_ROTATION_0: {
-            /*
-             * origin: (0, 0)
-             * x-axis: (1, 0)
-             * y-axis: (0, 1)
-             */
-            ox = 0;
-            oy = 0;
-            xx = 1;
-            xy = 0;
-            yx = 0;
-            yy = 1;
-            break;
-        }
-        case OWF_ROTATION_90: {
-            /*
-             * origin: (height-1, 0)
-             * x-axis: (0, 1)
-             * y-axis: (-1, 0)
-             */
-            ox = h - 1;
-            oy = 0;
-            xx = 0;
-            xy = 1;
-            yx = -1;
-            yy = 0;
-            break;
-        }
-        case OWF_ROTATION_180: {
-            /*
-             * origin: (width-1, height-1)
-             * x-axis: (-1, 0)
-             * y-axis: (0, -1)
-             */
-            ox = w - 1;
-            oy = h - 1;
-            xx = -1;
-            xy = 0;
-            yx = 0;
-            yy = -1;
-            break;
-        }
-        case OWF_ROTATION_270: {
-            /*
-             * origin: (0, height-1)
-             * x-axis: (0, -1)
-             * y-axis: (1, 0)
-             */
-            ox = 0;
-            oy = w - 1;
-            xx = 0;
-            xy = -1;
-            yx = 1;
-            yy = 0;
-            break;
-        }
+#if defined(OWF_IMAGE_INTERNAL_PIXEL_IS_FLOAT) && defined(OWF_SIMD_V4F)
+#if defined(OWF_SIMD_AVX2)
+    if (features & OWF_CPU_FEATURE_AVX2) {
+        return blendRowV8[mode];
     }
-
-    for (y = 0; y < h; y++) {
-        for (x = 0; x < w; x++) {
-            /*
-             * O = [ox oy]' X = [xx xy]' Y = [yx yy]'
-             *
-             * p_dst(x_src,y_src) = O + x_src*X + y_src*Y
-             */
-            OWF_Image_SetPixel(dst, ox + x * xx + y * yx, oy + x * xy + y * yy,
-                               OWF_Image_GetPixelPtr(src, x, y));
-        }
+#endif
+    if (features & (OWF_CPU_FEATURE_SSE2 | OWF_CPU_FEATURE_NEON)) {
+        return blendRowV4[mode];
     }
+#elif defined(OWF_SIMD_SSE2)
+    if (features & OWF_CPU_FEATURE_SSE2) {
+        return blendRowSse2[mode];
+    }
+#endif
+
+    return blendRowScalar[mode];
 }
 
 /*----------------------------------------------------------------------------*/
-OWF_API_CALL void OWF_Image_Flip(OWF_IMAGE *image, OWF_FLIP_DIRECTION dir) {
-    OWFint x, y;
-
-    if (!image) {
-        return;
+/*
+ * Transparent source color keying. The color channels of a pixel are
+ * compared with the key as raw 32-bit words, one word per pixel for packed
+ * pixels and four for float pixels, so no float compares are done. Key and
+ * mask words are replicated to fill 16 bytes for the vector compare.
+ */
+#define OWF_KEY_WORDS ((OWFint)(OWF_BYTES_PER_PIXEL / 4))
+#define OWF_KEY_VECTOR_PIXELS ((OWFint)(16 / OWF_BYTES_PER_PIXEL))
+
+/* pixels per coverage chunk kept on the stack */
+#define OWF_KEY_CHUNK_SIZE 256
+
+typedef struct {
+    OWFuint32 key[4];
+    OWFuint32 mask[4];
+} OWF_COLOR_KEY;
+
+static void OWF_Image_InitColorKey(OWF_COLOR_KEY *colorKey,
+                                   const OWFpixel *color) {
+    OWFpixel key, mask;
+    OWFuint32 keyWords[4], maskWords[4];
+    OWFint i;
+
+    /* alpha is not part of the key */
+    key = *color;
+    key.color.alpha = 0;
+    memset(&mask, 0xFF, sizeof(mask));
+    mask.color.alpha = 0;
+
+    /* copied, not cast: the float channels must not be read through an
+       integer pointer */
+    memcpy(keyWords, &key, sizeof(key));
+    memcpy(maskWords, &mask, sizeof(mask));
+
+    for (i = 0; i < 4; i++) {
+        colorKey->key[i] =
+            keyWords[i % OWF_KEY_WORDS] & maskWords[i % OWF_KEY_WORDS];
+        colorKey->mask[i] = maskWords[i % OWF_KEY_WORDS];
     }
-    OWF_ASSERT(image->format.pixelFormat == OWF_IMAGE_ARGB_INTERNAL);
-
-    if (dir & OWF_FLIP_VERTICALLY) {
-        OWFint h = image->height / 2;
+}
 
-        for (y = 0; y < h; y++) {
-            for (x = 0; x < image->width; x++) {
-                OWFpixel pix;
-
-                OWF_Image_GetPixel(image, x, y, &pix);
-                OWF_Image_SetPixel(
-                    image, x, y,
-                    OWF_Image_GetPixelPtr(image, x, image->height - 1 - y));
-                OWF_Image_SetPixel(image, x, image->height - 1 - y, &pix);
+/* coverage[i] is 0 for pixels matching the key, 1 for the others */
+static void OWF_Image_ColorKeyRow(OWFuint8 *coverage, const OWFpixel *srcPtr,
+                                  const OWF_COLOR_KEY *colorKey,
+                                  OWFint count) {
+    OWFint i = 0, k;
+
+#if defined(OWF_SIMD_SSE2)
+    if (OWF_Cpu_GetFeatures() & OWF_CPU_FEATURE_SSE2) {
+        const OWFint pixelBytes = OWF_BYTES_PER_PIXEL;
+        const OWFint pixelBits = (1 << pixelBytes) - 1;
+        __m128i key = _mm_loadu_si128((const __m128i *)colorKey->key);
+        __m128i mask = _mm_loadu_si128((const __m128i *)colorKey->mask);
+
+        for (; i + OWF_KEY_VECTOR_PIXELS <= count;
+             i += OWF_KEY_VECTOR_PIXELS) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(srcPtr + i));
+            OWFint bits = _mm_movemask_epi8(
+                _mm_cmpeq_epi32(_mm_and_si128(v, mask), key));
+
+            for (k = 0; k < OWF_KEY_VECTOR_PIXELS; k++) {
+                coverage[i + k] =
+                    ((bits >> (k * pixelBytes)) & pixelBits) != pixelBits;
             }
         }
     }
+#endif
 
-    if (dir & OWF_FLIP_HORIZONTALLY) {
-        OWFint w = image->width / 2;
+    for (; i < count; i++) {
+        OWFuint32 words[4];
+        OWFuint32 diff = 0;
 
-        for (y = 0; y < image->height; y++) {
-            for (x = 0; x < w; x++) {
-                OWFpixel pix;
-
-                OWF_Image_GetPixel(image, x, y, &pix);
-                OWF_Image_SetPixel(
-                    image, x, y,
-                    OWF_Image_GetPixelPtr(image, image->width - 1 - x, y));
-                OWF_Image_SetPixel(image, image->width - 1 - x, y, &pix);
-            }
+        memcpy(words, srcPtr + i, sizeof(OWFpixel));
+        for (k = 0; k < OWF_KEY_WORDS; k++) {
+            diff |= (words[k] & colorKey->mask[k]) ^ colorKey->key[k];
         }
+        coverage[i] = (diff != 0);
     }
 }
 
-/*----------------------------------------------------------------------------*/
-#define BLENDER_INNER_LOOP_BEGIN       \
-    OWFint rowCount = drect.height;    \
-    while (rowCount > 0) {             \
-        OWFint colCount = drect.width; \
-        while (colCount > 0) {         \
-            if (!(blend->tsColor && COLOR_MATCH(SC, TSC))) {
-#define BLENDER_INNER_LOOP_END                                  \
-    DA = blend->destinationFullyOpaque ? OWF_FULLY_OPAQUE : DA; \
-    } /* end tsColor check */                                   \
-    srcPtr++;                                                   \
-    dstPtr++;                                                   \
-    maskPtr++;                                                  \
-    --colCount;                                                 \
-    }                                                           \
-    srcPtr += srcLineDelta;                                     \
-    dstPtr += dstLineDelta;                                     \
-    maskPtr += maskLineDelta;                                   \
-    --rowCount;                                                 \
-    }
+/* blends the pixels not matching the key; the others are left untouched */
+static void OWF_Image_BlendKeyedRow(const OWF_BLEND_INFO *blend,
+                                    OWF_BLEND_ROW_FUNC blendRow,
+                                    const OWF_COLOR_KEY *colorKey,
+                                    OWFpixel *dstPtr, const OWFpixel *srcPtr,
+                                    const OWFsubpixel *maskPtr, OWFint count) {
+    OWFuint8 coverage[OWF_KEY_CHUNK_SIZE];
 
-#define TSC blend->tsColor->color
-#define SC srcPtr->color
+    while (count > 0) {
+        OWFint n = MIN(count, OWF_KEY_CHUNK_SIZE);
+        OWFint i = 0;
 
-/* Note: actually would be better to compare integer values
- * for TSC match -> eliminate float arithmetic pitfalls
- */
-#define COLOR_MATCH(x, y) \
-    (x.red == y.red && x.green == y.green && x.blue == y.blue)
+        OWF_Image_ColorKeyRow(coverage, srcPtr, colorKey, n);
 
-#define SA srcPtr->color.alpha
-#define SR srcPtr->color.red
-#define SG srcPtr->color.green
-#define SB srcPtr->color.blue
+        while (i < n) {
+            OWFint start;
 
-#define DA dstPtr->color.alpha
-#define DR dstPtr->color.red
-#define DG dstPtr->color.green
-#define DB dstPtr->color.blue
+            while (i < n && !coverage[i]) {
+                i++;
+            }
+            start = i;
+            while (i < n && coverage[i]) {
+                i++;
+            }
+            if (i > start) {
+                blendRow(blend, dstPtr + start, srcPtr + start,
+                         maskPtr ? maskPtr + start : NULL, i - start);
+            }
+        }
 
-#define MA *maskPtr
-#define GA blend->globalAlpha
+        dstPtr += n;
+        srcPtr += n;
+        if (maskPtr) {
+            maskPtr += n;
+        }
+        count -= n;
+    }
+}
 
 OWF_API_CALL void OWF_Image_Blend(OWF_BLEND_INFO *blend,
                                   OWF_TRANSPARENCY transparency) {
@@ -1241,10 +3589,12 @@ OWF_API_CALL void OWF_Image_Blend(OWF_BLEND_INFO *blend,
     OWF_RECTANGLE *srcRect;
     OWF_RECTANGLE *dstRect;
     OWF_RECTANGLE bounds, srect, drect, rect;
-    OWFint srcLineDelta, dstLineDelta, maskLineDelta;
     OWFpixel *srcPtr;
     OWFpixel *dstPtr;
     OWFsubpixel *maskPtr;
+    OWFint mode, rowCount;
+    OWF_BLEND_ROW_FUNC blendRow;
+    OWF_COLOR_KEY colorKey;
 
     /* preparation */
     OWF_ASSERT(blend);
@@ -1274,6 +3624,46 @@ OWF_API_CALL void OWF_Image_Blend(OWF_BLEND_INFO *blend,
         return;
     }
 
+    /* source alpha of an opaque source is 1 everywhere: blending with it
+       gives the same result as copying */
+    if (src->format.opaque) {
+        transparency = (OWF_TRANSPARENCY)(transparency &
+                                          ~OWF_TRANSPARENCY_SOURCE_ALPHA);
+    }
+
+    switch (transparency) {
+        case OWF_TRANSPARENCY_NONE: {
+            mode = BLEND_MODE_NONE;
+            break;
+        }
+        case OWF_TRANSPARENCY_GLOBAL_ALPHA: {
+            mode = BLEND_MODE_GA;
+            break;
+        }
+        case OWF_TRANSPARENCY_SOURCE_ALPHA: {
+            mode = BLEND_MODE_SA;
+            break;
+        }
+        case OWF_TRANSPARENCY_MASK: {
+            mode = BLEND_MODE_MASK;
+            break;
+        }
+        case OWF_TRANSPARENCY_GLOBAL_ALPHA | OWF_TRANSPARENCY_SOURCE_ALPHA: {
+            mode = BLEND_MODE_GA_SA;
+            break;
+        }
+        case OWF_TRANSPARENCY_GLOBAL_ALPHA | OWF_TRANSPARENCY_MASK: {
+            mode = BLEND_MODE_GA_MASK;
+            OWF_ASSERT(GA >= OWF_ALPHA_MIN_VALUE && GA <= OWF_ALPHA_MAX_VALUE);
+            break;
+        }
+        default: {
+            DPRINT(("OWF_Image_Blend: whooops. invalid blending mode\n"));
+            abort();
+            return;
+        }
+    }
+
     OWF_Rect_Set(&bounds, 0, 0, dst->width, dst->height);
     /* NOTE: src and dst rects should be of same size!!! */
     OWF_Rect_Set(&rect, dstRect->x, dstRect->y, dstRect->width,
@@ -1308,157 +3698,35 @@ OWF_API_CALL void OWF_Image_Blend(OWF_BLEND_INFO *blend,
     }
 
     srcPtr = (OWFpixel *)src->data;
-    srcPtr += srect.y * src->width + srect.x;
+    srcPtr += srect.y * OWF_ROW_PIXELS(src) + srect.x;
     dstPtr = (OWFpixel *)dst->data;
-    dstPtr += drect.y * dst->width + drect.x;
+    dstPtr += drect.y * OWF_ROW_PIXELS(dst) + drect.x;
 
+    /* converted masks are packed rows of subpixels */
     if (mask) {
         maskPtr = (OWFsubpixel *)mask->data + srect.y * mask->width + srect.x;
-        maskLineDelta = mask->width - drect.width;
     } else {
-        maskPtr = 0;
-        maskLineDelta = 0;
+        maskPtr = NULL;
     }
-    srcLineDelta = src->width - srect.width;
-    dstLineDelta = dst->width - drect.width;
-
-    /* inner loops */
-    switch (transparency) {
-        case OWF_TRANSPARENCY_NONE: {
-            /*
-            rgb     = src.rgb
-            alpha    = 1
-            */
-            BLENDER_INNER_LOOP_BEGIN;
-            DR = SR;
-            DG = SG;
-            DB = SB;
-            DA = OWF_FULLY_OPAQUE;
-            BLENDER_INNER_LOOP_END;
-            break;
-        }
-
-        case OWF_TRANSPARENCY_GLOBAL_ALPHA: {
-            /*
-            rgb        = src.rgb * elem.alpha + dst.rgb * (1 - elem.alpha)
-            alpha   = elem.alpha + dst.alpha * (1 - elem.alpha)
-            */
-            BLENDER_INNER_LOOP_BEGIN;
-            DR = (SR * GA + DR * (OWF_FULLY_OPAQUE - GA) +
-                  OWF_BLEND_ROUNDING_VALUE) /
-                 OWF_ALPHA_MAX_VALUE;
-            DG = (SG * GA + DG * (OWF_FULLY_OPAQUE - GA) +
-                  OWF_BLEND_ROUNDING_VALUE) /
-                 OWF_ALPHA_MAX_VALUE;
-            DB = (SB * GA + DB * (OWF_FULLY_OPAQUE - GA) +
-                  OWF_BLEND_ROUNDING_VALUE) /
-                 OWF_ALPHA_MAX_VALUE;
-            DA =
-                GA + (DA * (OWF_FULLY_OPAQUE - GA) + OWF_BLEND_ROUNDING_VALUE) /
-                         OWF_ALPHA_MAX_VALUE;
-            BLENDER_INNER_LOOP_END;
-            break;
-        }
 
-        case OWF_TRANSPARENCY_SOURCE_ALPHA: {
-            /*
-            rgb     = src.rgb + dst.rgb * (1 - src.alpha)
-            alpha    = src.alpha + dst.alpha * (1 - src.alpha)
-            */
-            BLENDER_INNER_LOOP_BEGIN;
-            DR =
-                SR + (DR * (OWF_FULLY_OPAQUE - SA) + OWF_BLEND_ROUNDING_VALUE) /
-                         OWF_ALPHA_MAX_VALUE;
-            DG =
-                SG + (DG * (OWF_FULLY_OPAQUE - SA) + OWF_BLEND_ROUNDING_VALUE) /
-                         OWF_ALPHA_MAX_VALUE;
-            DB =
-                SB + (DB * (OWF_FULLY_OPAQUE - SA) + OWF_BLEND_ROUNDING_VALUE) /
-                         OWF_ALPHA_MAX_VALUE;
-            DA =
-                SA + (DA * (OWF_FULLY_OPAQUE - SA) + OWF_BLEND_ROUNDING_VALUE) /
-                         OWF_ALPHA_MAX_VALUE;
-            BLENDER_INNER_LOOP_END;
-            break;
-        }
-
-        case OWF_TRANSPARENCY_MASK: {
-            /*
-            rgb     = src.rgb * mask.alpha + dst.rgb * (1 - mask.alpha)
-            alpha    = mask.alpha + dst.alpha * (1 - mask.alpha)
-            */
-            BLENDER_INNER_LOOP_BEGIN;
-            DR = (SR * MA + DR * (OWF_FULLY_OPAQUE - MA) +
-                  OWF_BLEND_ROUNDING_VALUE) /
-                 OWF_ALPHA_MAX_VALUE;
-            DG = (SG * MA + DG * (OWF_FULLY_OPAQUE - MA) +
-                  OWF_BLEND_ROUNDING_VALUE) /
-                 OWF_ALPHA_MAX_VALUE;
-            DB = (SB * MA + DB * (OWF_FULLY_OPAQUE - MA) +
-                  OWF_BLEND_ROUNDING_VALUE) /
-                 OWF_ALPHA_MAX_VALUE;
-            DA =
-                MA + (DA * (OWF_FULLY_OPAQUE - MA) + OWF_BLEND_ROUNDING_VALUE) /
-                         OWF_ALPHA_MAX_VALUE;
-            BLENDER_INNER_LOOP_END;
-            break;
-        }
+    blendRow = OWF_Image_GetBlendRowFunc(mode);
 
-        case OWF_TRANSPARENCY_GLOBAL_ALPHA | OWF_TRANSPARENCY_SOURCE_ALPHA: {
-            /*
-            rgb = src.rgb * elem.a + dst.rgb * (1 - src.a * elem.a)
-            a = src.a * elem.a + dst.a * (1 - src.a * elem.a)
-            */
-            OWFsubpixel SAEA;
-
-            BLENDER_INNER_LOOP_BEGIN;
-            SAEA = (SA * GA + OWF_BLEND_ROUNDING_VALUE) / OWF_ALPHA_MAX_VALUE;
-            DR = (SR * GA + DR * (OWF_FULLY_OPAQUE - SAEA) +
-                  OWF_BLEND_ROUNDING_VALUE) /
-                 OWF_ALPHA_MAX_VALUE;
-            DG = (SG * GA + DG * (OWF_FULLY_OPAQUE - SAEA) +
-                  OWF_BLEND_ROUNDING_VALUE) /
-                 OWF_ALPHA_MAX_VALUE;
-            DB = (SB * GA + DB * (OWF_FULLY_OPAQUE - SAEA) +
-                  OWF_BLEND_ROUNDING_VALUE) /
-                 OWF_ALPHA_MAX_VALUE;
-            DA = SAEA +
-                 (DA * (OWF_FULLY_OPAQUE - SAEA) + OWF_BLEND_ROUNDING_VALUE) /
-                     OWF_ALPHA_MAX_VALUE;
-            BLENDER_INNER_LOOP_END;
-            break;
-        }
+    if (blend->tsColor) {
+        OWF_Image_InitColorKey(&colorKey, blend->tsColor);
+    }
 
-        case OWF_TRANSPARENCY_GLOBAL_ALPHA | OWF_TRANSPARENCY_MASK: {
-            /*
-            rgb    = src.rgb * mask.a * elem.a + dst.rgb * (1 - mask.a * elem.a)
-            a     = mask.a * elem.a + dest.a * (1 - mask.a * elem.a)
-            */
-            OWFsubpixel MAEA;
-
-            BLENDER_INNER_LOOP_BEGIN;
-            MAEA = MA * GA / OWF_ALPHA_MAX_VALUE;
-            DR = (SR * MAEA + DR * (OWF_FULLY_OPAQUE - MAEA) +
-                  OWF_BLEND_ROUNDING_VALUE) /
-                 OWF_ALPHA_MAX_VALUE;
-            DG = (SG * MAEA + DG * (OWF_FULLY_OPAQUE - MAEA) +
-                  OWF_BLEND_ROUNDING_VALUE) /
-                 OWF_ALPHA_MAX_VALUE;
-            DB = (SB * MAEA + DB * (OWF_FULLY_OPAQUE - MAEA) +
-                  OWF_BLEND_ROUNDING_VALUE) /
-                 OWF_ALPHA_MAX_VALUE;
-            DA = MAEA +
-                 (DA * (OWF_FULLY_OPAQUE - MAEA) + OWF_BLEND_ROUNDING_VALUE) /
-                     OWF_ALPHA_MAX_VALUE;
-            OWF_ASSERT(GA >= OWF_ALPHA_MIN_VALUE && GA <= OWF_ALPHA_MAX_VALUE);
-            BLENDER_INNER_LOOP_END;
-            break;
+    for (rowCount = drect.height; rowCount > 0; rowCount--) {
+        if (blend->tsColor) {
+            OWF_Image_BlendKeyedRow(blend, blendRow, &colorKey, dstPtr, srcPtr,
+                                    maskPtr, drect.width);
+        } else {
+            blendRow(blend, dstPtr, srcPtr, maskPtr, drect.width);
         }
 
-        default: {
-            DPRINT(("OWF_Image_Blend: whooops. invalid blending mode\n"));
-            abort();
-            break;
+        srcPtr += OWF_ROW_PIXELS(src);
+        dstPtr += OWF_ROW_PIXELS(dst);
+        if (maskPtr) {
+            maskPtr += mask->width;
         }
     }
 }
@@ -1476,17 +3744,26 @@ OWF_API_CALL void *OWF_Image_AllocData(OWFint width, OWFint height,
 
     OWF_ASSERT(width > 0 && height > 0);
 
-    if (stride == 0) {
+    return OWF_Image_AllocDataWithStride(stride, height, pixelFormat);
+}
+
+/*----------------------------------------------------------------------------*/
+OWF_API_CALL void *OWF_Image_AllocDataWithStride(
+    OWFint stride, OWFint height, OWF_PIXEL_FORMAT pixelFormat) {
+    OWFint size;
+
+    size = OWF_Image_GetDataSize(stride, height, pixelFormat);
+    if (stride <= 0 || size <= 0) {
         return NULL;
     }
 
-    return xalloc(1, height * stride);
+    return xalloc_aligned(1, size, OWF_IMAGE_ALIGNMENT);
 }
 
 /*----------------------------------------------------------------------------*/
 OWF_API_CALL void OWF_Image_FreeData(void **data) {
     if (*data) {
-        xfree(*data);
+        xfree_aligned(*data);
     }
     *data = NULL;
 }
@@ -1509,11 +3786,15 @@ OWF_API_CALL OWFint OWF_Image_GetFormatPixelSize(OWF_PIXEL_FORMAT format) {
         }
 
         case OWF_IMAGE_RGB565:
-        case OWF_IMAGE_L16: {
+        case OWF_IMAGE_L16:
+        case OWF_IMAGE_YUYV: {
             return 2;
         }
 
-        case OWF_IMAGE_L8: {
+        case OWF_IMAGE_L8:
+        case OWF_IMAGE_NV12:
+        case OWF_IMAGE_I420: {
+            /* size of a luma plane pixel */
             return 1;
         }
 
@@ -1537,7 +3818,7 @@ OWF_API_CALL OWFint OWF_Image_GetFormatPadding(OWF_PIXEL_FORMAT format) {
 
     switch (format) {
         case OWF_IMAGE_ARGB_INTERNAL: {
-            padding = sizeof(OWFpixel);
+            padding = OWF_INTERNAL_ROW_PADDING;
             break;
         }
 
@@ -1556,11 +3837,18 @@ OWF_API_CALL OWFint OWF_Image_GetFormatPadding(OWF_PIXEL_FORMAT format) {
             */
 
         case OWF_IMAGE_RGB565:
-        case OWF_IMAGE_L16: {
+        case OWF_IMAGE_L16:
+        case OWF_IMAGE_NV12:
+        case OWF_IMAGE_I420: {
             padding = 2;
             break;
         }
 
+        case OWF_IMAGE_YUYV: {
+            padding = 4;
+            break;
+        }
+
         case OWF_IMAGE_L8: {
             padding = 1;
             break;
@@ -1591,13 +3879,239 @@ OWF_API_CALL void OWF_Image_SwapWidthAndHeight(OWF_IMAGE *image) {
     image->width ^= image->height;
 
     image->stride = OWF_Image_GetStride(image->width, &image->format, 0);
+    /* padded rows of the swapped image may need more room than the
+       buffer has; the buffer must be created big enough for both */
+    OWF_ASSERT(OWF_Image_GetDataSize(image->stride, image->height,
+                                     image->format.pixelFormat) <=
+               image->dataMax);
+    OWF_Image_UpdateAlignment(image);
+}
+
+/*----------------------------------------------------------------------------*/
+/*
+ * Masks are expanded one row at a time, like source images. The vector
+ * versions produce exactly the values of the scalar ones.
+ */
+typedef void (*OWF_CONVERT_MASK_ROW_FUNC)(OWFsubpixel *dstPtr,
+                                          const void *srcLinePtr,
+                                          OWFint count);
+
+/*
+ * alpha pixel ordering is LSB -> MSB
+ *
+ * byte# |----- byte 0 ----|----- byte 1-----|--
+ * bit#  | 7 6 5 4 3 2 1 0 | 7 6 5 4 3 2 1 0 |
+ * pix#  | 7 6 5 4 3 2 1 0 | f e d c b a 9 8 | ...
+ */
+static void OWF_ConvertMaskRow_L1(OWFsubpixel *dstPtr, const void *srcLinePtr,
+                                  OWFint count) {
+    const OWFuint8 *srcPtr = (const OWFuint8 *)srcLinePtr;
+    OWFint i;
+
+    for (i = 0; i < count; i++) {
+        dstPtr[i] = (srcPtr[i >> 3] & (1 << (i & 7))) ? OWF_FULLY_OPAQUE
+                                                       : OWF_FULLY_TRANSPARENT;
+    }
+}
+
+static void OWF_ConvertMaskRow_L8(OWFsubpixel *dstPtr, const void *srcLinePtr,
+                                  OWFint count) {
+#ifdef OWF_IMAGE_INTERNAL_PIXEL_IS_FLOAT
+    const OWFuint8 *srcPtr = (const OWFuint8 *)srcLinePtr;
+    OWFint i;
+
+    for (i = 0; i < count; i++) {
+        dstPtr[i] = byteToSubpixel[srcPtr[i]];
+    }
+#else
+    /* 8-bit subpixels are the mask bytes themselves */
+    memcpy(dstPtr, srcLinePtr, count);
+#endif
+}
+
+static void OWF_ConvertMaskRow_ARGB8888(OWFsubpixel *dstPtr,
+                                        const void *srcLinePtr, OWFint count) {
+    const OWFuint32 *srcPtr = (const OWFuint32 *)srcLinePtr;
+    OWFint i;
+
+    /* take the alpha channel and discard everything else */
+    for (i = 0; i < count; i++) {
+        dstPtr[i] = byteToSubpixel[srcPtr[i] >> ARGB8888_ALPHA_SHIFT];
+    }
+}
+
+#ifdef OWF_SIMD_SSE2
+#ifdef OWF_IMAGE_INTERNAL_PIXEL_IS_FLOAT
+/* eight mask bits of one source byte to eight 0.0 / 1.0 lanes */
+static void OWF_ConvertMaskRowSse2_L1(OWFsubpixel *dstPtr,
+                                      const void *srcLinePtr, OWFint count) {
+    const OWFuint8 *srcPtr = (const OWFuint8 *)srcLinePtr;
+    const __m128i bitsLo = _mm_setr_epi32(1, 2, 4, 8);
+    const __m128i bitsHi = _mm_setr_epi32(16, 32, 64, 128);
+    const __m128 opaque = _mm_set1_ps(OWF_FULLY_OPAQUE);
+    OWFint i;
+
+    for (i = 0; i + 8 <= count; i += 8) {
+        __m128i b = _mm_set1_epi32(srcPtr[i >> 3]);
+        __m128i lo = _mm_cmpeq_epi32(_mm_and_si128(b, bitsLo), bitsLo);
+        __m128i hi = _mm_cmpeq_epi32(_mm_and_si128(b, bitsHi), bitsHi);
+
+        _mm_storeu_ps(&dstPtr[i], _mm_and_ps(_mm_castsi128_ps(lo), opaque));
+        _mm_storeu_ps(&dstPtr[i + 4],
+                      _mm_and_ps(_mm_castsi128_ps(hi), opaque));
+    }
+    for (; i < count; i++) {
+        dstPtr[i] = (srcPtr[i >> 3] & (1 << (i & 7))) ? OWF_FULLY_OPAQUE
+                                                       : OWF_FULLY_TRANSPARENT;
+    }
+}
+
+/* sixteen bytes widened to 32-bit lanes, converted and divided by 255 */
+static void OWF_ConvertMaskRowSse2_L8(OWFsubpixel *dstPtr,
+                                      const void *srcLinePtr, OWFint count) {
+    const OWFuint8 *srcPtr = (const OWFuint8 *)srcLinePtr;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 scale = _mm_set1_ps(OWF_BYTE_MAX_VALUE);
+    OWFint i;
+
+    for (i = 0; i + 16 <= count; i += 16) {
+        __m128i s = _mm_loadu_si128((const __m128i *)&srcPtr[i]);
+        __m128i lo = _mm_unpacklo_epi8(s, zero);
+        __m128i hi = _mm_unpackhi_epi8(s, zero);
+
+        _mm_storeu_ps(&dstPtr[i], _mm_div_ps(_mm_cvtepi32_ps(
+                                      _mm_unpacklo_epi16(lo, zero)), scale));
+        _mm_storeu_ps(&dstPtr[i + 4], _mm_div_ps(_mm_cvtepi32_ps(
+                                          _mm_unpackhi_epi16(lo, zero)),
+                                      scale));
+        _mm_storeu_ps(&dstPtr[i + 8], _mm_div_ps(_mm_cvtepi32_ps(
+                                          _mm_unpacklo_epi16(hi, zero)),
+                                      scale));
+        _mm_storeu_ps(&dstPtr[i + 12], _mm_div_ps(_mm_cvtepi32_ps(
+                                           _mm_unpackhi_epi16(hi, zero)),
+                                       scale));
+    }
+    if (i < count) {
+        OWF_ConvertMaskRow_L8(dstPtr + i, srcPtr + i, count - i);
+    }
+}
+
+static void OWF_ConvertMaskRowSse2_ARGB8888(OWFsubpixel *dstPtr,
+                                            const void *srcLinePtr,
+                                            OWFint count) {
+    const OWFuint32 *srcPtr = (const OWFuint32 *)srcLinePtr;
+    const __m128 scale = _mm_set1_ps(OWF_BYTE_MAX_VALUE);
+    OWFint i;
+
+    for (i = 0; i + 4 <= count; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i *)&srcPtr[i]);
+
+        _mm_storeu_ps(&dstPtr[i],
+                      _mm_div_ps(_mm_cvtepi32_ps(_mm_srli_epi32(
+                                     s, ARGB8888_ALPHA_SHIFT)),
+                                 scale));
+    }
+    if (i < count) {
+        OWF_ConvertMaskRow_ARGB8888(dstPtr + i, srcPtr + i, count - i);
+    }
+}
+#else
+/* mask bits of two source bytes to sixteen 0x00 / 0xFF bytes */
+static void OWF_ConvertMaskRowSse2_L1(OWFsubpixel *dstPtr,
+                                      const void *srcLinePtr, OWFint count) {
+    const OWFuint8 *srcPtr = (const OWFuint8 *)srcLinePtr;
+    const __m128i bits =
+        _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, (char)128, 1, 2, 4, 8, 16, 32,
+                      64, (char)128);
+    OWFint i;
+
+    for (i = 0; i + 16 <= count; i += 16) {
+        __m128i b = _mm_unpacklo_epi64(_mm_set1_epi8((char)srcPtr[i >> 3]),
+                                       _mm_set1_epi8(
+                                           (char)srcPtr[(i >> 3) + 1]));
+
+        _mm_storeu_si128((__m128i *)&dstPtr[i],
+                         _mm_cmpeq_epi8(_mm_and_si128(b, bits), bits));
+    }
+    if (i < count) {
+        OWF_ConvertMaskRow_L1(dstPtr + i, srcPtr + (i >> 3), count - i);
+    }
+}
+
+/* alpha bytes of eight pixels narrowed with saturating packs */
+static void OWF_ConvertMaskRowSse2_ARGB8888(OWFsubpixel *dstPtr,
+                                            const void *srcLinePtr,
+                                            OWFint count) {
+    const OWFuint32 *srcPtr = (const OWFuint32 *)srcLinePtr;
+    OWFint i;
+
+    for (i = 0; i + 8 <= count; i += 8) {
+        __m128i lo = _mm_srli_epi32(
+            _mm_loadu_si128((const __m128i *)&srcPtr[i]), ARGB8888_ALPHA_SHIFT);
+        __m128i hi =
+            _mm_srli_epi32(_mm_loadu_si128((const __m128i *)&srcPtr[i + 4]),
+                           ARGB8888_ALPHA_SHIFT);
+        __m128i words = _mm_packs_epi32(lo, hi);
+
+        _mm_storel_epi64((__m128i *)&dstPtr[i],
+                         _mm_packus_epi16(words, words));
+    }
+    if (i < count) {
+        OWF_ConvertMaskRow_ARGB8888(dstPtr + i, srcPtr + i, count - i);
+    }
+}
+#endif
+#endif
+
+/*----------------------------------------------------------------------------*/
+static OWF_CONVERT_MASK_ROW_FUNC OWF_Image_GetConvertMaskRowFunc(
+    OWF_PIXEL_FORMAT format) {
+#ifdef OWF_SIMD_SSE2
+    const OWFboolean useSse2 =
+        (OWF_Cpu_GetFeatures() & OWF_CPU_FEATURE_SSE2) ? OWF_TRUE : OWF_FALSE;
+#endif
+
+    OWF_Once(&conversionTablesOnce, OWF_Image_InitConversionTables);
+
+    switch (format) {
+        case OWF_IMAGE_L1: {
+#ifdef OWF_SIMD_SSE2
+            if (useSse2) {
+                return OWF_ConvertMaskRowSse2_L1;
+            }
+#endif
+            return OWF_ConvertMaskRow_L1;
+        }
+
+        case OWF_IMAGE_L8: {
+#if defined(OWF_SIMD_SSE2) && defined(OWF_IMAGE_INTERNAL_PIXEL_IS_FLOAT)
+            if (useSse2) {
+                return OWF_ConvertMaskRowSse2_L8;
+            }
+#endif
+            return OWF_ConvertMaskRow_L8;
+        }
+
+        case OWF_IMAGE_ARGB8888: {
+#ifdef OWF_SIMD_SSE2
+            if (useSse2) {
+                return OWF_ConvertMaskRowSse2_ARGB8888;
+            }
+#endif
+            return OWF_ConvertMaskRow_ARGB8888;
+        }
+
+        default: {
+            return NULL;
+        }
+    }
 }
 
 /*----------------------------------------------------------------------------*/
 OWF_API_CALL OWFboolean OWF_Image_ConvertMask(OWF_IMAGE *output,
                                               OWF_IMAGE *input) {
-    OWFboolean result = OWF_TRUE;
-    void *srcLinePtr;
+    OWF_CONVERT_MASK_ROW_FUNC convertRow;
+    const OWFuint8 *srcLinePtr;
     OWFsubpixel *dstLinePtr;
     OWFint countY;
 
@@ -1607,79 +4121,87 @@ OWF_API_CALL OWFboolean OWF_Image_ConvertMask(OWF_IMAGE *output,
     OWF_ASSERT(input);
     OWF_ASSERT(output);
 
-    srcLinePtr = input->data;
+    convertRow = OWF_Image_GetConvertMaskRowFunc(input->format.pixelFormat);
+    if (!convertRow) {
+        DPRINT(("Unsupported alpha format, ignoring mask"));
+        return OWF_FALSE;
+    }
+
+    DPRINT(("  format = %x, width = %d, height = %d",
+            input->format.pixelFormat, input->width, input->height));
+
+    srcLinePtr = (const OWFuint8 *)input->data;
     dstLinePtr = (OWFsubpixel *)output->data;
 
     for (countY = input->height; countY; countY--) {
-        OWFsubpixel *dstData = dstLinePtr;
-
-        switch (input->format.pixelFormat) {
-            case OWF_IMAGE_L1: {
-                OWFint countX;
-                OWFuint8 *srcData = (OWFuint8 *)srcLinePtr;
-
-                DPRINT(("1-bit alpha, width = %d, height = %d", input->width,
-                        input->height));
-
-                for (countX = 0; countX < input->width; countX++) {
-                    /*
-                     * alpha pixel ordering is LSB -> MSB
-                     *
-                     * byte# |----- byte 0 ----|----- byte 1-----|--
-                     * bit#  | 7 6 5 4 3 2 1 0 | 7 6 5 4 3 2 1 0 |
-                     * pix#  | 7 6 5 4 3 2 1 0 | f e d c b a 9 8 | ...
-                     */
-                    if (srcData[countX >> 3] & (1 << (countX & 7))) {
-                        dstData[countX] = OWF_FULLY_OPAQUE;
-                    } else {
-                        dstData[countX] = OWF_FULLY_TRANSPARENT;
-                    }
-                }
-                break;
-            }
-            case OWF_IMAGE_L8: {
-                OWFint countX;
-                OWFuint8 *srcData = (OWFuint8 *)srcLinePtr;
+        convertRow(dstLinePtr, srcLinePtr, input->width);
 
-                DPRINT(("8-bit alpha, width = %d, height = %d", input->width,
-                        input->height));
+        dstLinePtr += output->width;
+        /* Presumes that the stride is always whole bytes - eg. a 2x2-pixel mono
+         * image takes at least 2 bytes */
+        srcLinePtr += input->stride;
+    }
+    return OWF_TRUE;
+}
 
-                for (countX = 0; countX < input->width; countX++) {
-                    dstData[countX] = srcData[countX] * OWF_FULLY_OPAQUE /
-                                      (OWFfloat)OWF_BYTE_MAX_VALUE;
-                }
-                break;
-            }
-            case OWF_IMAGE_ARGB8888: {
-                /* ARGB image - take the alpha channel and discard
-                 * everything else */
-                OWFint countX;
-                OWFuint32 *srcData = (OWFuint32 *)srcLinePtr;
-
-                DPRINT(("32-bit ARGB, width = %d, height = %d", input->width,
-                        input->height));
-
-                for (countX = 0; countX < input->width; countX++) {
-                    dstData[countX] = (srcData[countX] >> 24) *
-                                      OWF_FULLY_OPAQUE /
-                                      (OWFfloat)OWF_BYTE_MAX_VALUE;
-                }
-                break;
-            }
-            default: {
-                DPRINT(("Unsupported alpha format, ignoring mask"));
+/*----------------------------------------------------------------------------*/
+OWF_API_CALL OWF_IMAGE *OWF_Image_GetCachedMask(OWF_MASK_CACHE *cache,
+                                                OWF_IMAGE *input,
+                                                OWFuint32 serial) {
+    OWF_IMAGE_FORMAT imgf;
 
-                result = OWF_FALSE;
-                break;
-            }
+    OWF_ASSERT(cache);
+    OWF_ASSERT(input);
+
+    if (cache->image && serial != OWF_MASK_SERIAL_NONE &&
+        cache->serial == serial && cache->pixels == input->data &&
+        cache->image->width == input->width &&
+        cache->image->height == input->height) {
+        DPRINT(("OWF_Image_GetCachedMask: reusing converted mask %p",
+                cache->image));
+        return cache->image;
+    }
+
+    cache->pixels = NULL;
+    cache->serial = OWF_MASK_SERIAL_NONE;
+
+    if (!cache->image ||
+        !OWF_Image_SetSize(cache->image, input->width, input->height)) {
+        OWF_Image_Destroy(cache->image);
+
+        imgf.pixelFormat = OWF_IMAGE_L32;
+        imgf.linear = input->format.linear;
+        imgf.premultiplied = input->format.premultiplied;
+        imgf.rowPadding = 1;
+        imgf.opaque = OWF_FALSE;
+
+        cache->image =
+            OWF_Image_Create(input->width, input->height, &imgf, NULL, 0);
+        if (!cache->image) {
+            return NULL;
         }
+    }
 
-        dstLinePtr += output->width;
-        /* Presumes that the stride is always whole bytes - eg. a 2x2-pixel mono
-         * image takes at least 2 bytes */
-        srcLinePtr = (OWFuint8 *)srcLinePtr + input->stride;
+    cache->image->format.linear = input->format.linear;
+    cache->image->format.premultiplied = input->format.premultiplied;
+
+    if (!OWF_Image_ConvertMask(cache->image, input)) {
+        return NULL;
     }
-    return result;
+
+    cache->pixels = input->data;
+    cache->serial = serial;
+    return cache->image;
+}
+
+/*----------------------------------------------------------------------------*/
+OWF_API_CALL void OWF_Image_DestroyMaskCache(OWF_MASK_CACHE *cache) {
+    OWF_ASSERT(cache);
+
+    OWF_Image_Destroy(cache->image);
+    cache->image = NULL;
+    cache->pixels = NULL;
+    cache->serial = OWF_MASK_SERIAL_NONE;
 }
 
 #ifdef __cplusplus
@@ -158,7 +158,7 @@ OWF_API_CALL void OWF_Memory_Free(void *ptr) {
     }
 
     /* POINTER ARITHMETIC HAZARD */
-    block = (BLOCK *)((OWFuint32)ptr - (OWFuint32)OFFSET(BLOCK, memory[1]));
+    block = (BLOCK *)((OWFuint8 *)ptr - OFFSET(BLOCK, memory[1]));
 
     if (!block) {
         DPRINT(("Sanity check failed. Ptr was zero....\n"));
@@ -210,6 +210,56 @@ OWF_API_CALL void OWF_Memory_Free(void *ptr) {
     OWF_Memory_UnlockManagedBlocks();
 }
 
+/* the block start is stored just below the aligned address */
+OWF_API_CALL void *OWF_Memory_AllocAligned(const char *file, OWFint line,
+                                           OWFuint32 size,
+                                           OWFuint32 alignment) {
+    OWFuint8 *block = NULL;
+    OWFuint8 *aligned = NULL;
+    OWFuint32 realSize;
+
+    OWF_ASSERT((alignment & (alignment - 1)) == 0);
+
+    if (alignment < sizeof(void *)) {
+        alignment = sizeof(void *);
+    }
+
+    realSize = size + alignment - 1 + sizeof(void *);
+    if (realSize < size) /* int overflow */
+    {
+        return NULL;
+    }
+
+#ifdef DEBUG
+    block = (OWFuint8 *)OWF_Memory_Alloc(file, line, realSize);
+#else
+    file = file; /* suppress the compiler warning */
+    line = line;
+    block = (OWFuint8 *)calloc(1, realSize);
+#endif
+    if (!block) {
+        return NULL;
+    }
+
+    aligned = block + sizeof(void *);
+    aligned += (alignment - (size_t)aligned % alignment) % alignment;
+    ((void **)aligned)[-1] = block;
+
+    return aligned;
+}
+
+OWF_API_CALL void OWF_Memory_FreeAligned(void *ptr) {
+    if (!ptr) {
+        return;
+    }
+
+#ifdef DEBUG
+    OWF_Memory_Free(((void **)ptr)[-1]);
+#else
+    free(((void **)ptr)[-1]);
+#endif
+}
+
 OWF_API_CALL void OWF_Memory_BlockDump() {
     BLOCK *block = NULL;
 
@@ -0,0 +1,621 @@
+/* Copyright (c) 2009 The Khronos Group Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and/or associated documentation files (the
+ * "Materials"), to deal in the Materials without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Materials, and to
+ * permit persons to whom the Materials are furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Materials.
+ *
+ * THE MATERIALS ARE PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * MATERIALS OR THE USE OR OTHER DEALINGS IN THE MATERIALS.
+ */
+
+/*!
+ * \file wfc_bench.c
+ * \brief Headless composition benchmark.
+ *
+ * Composes synthetic scenes of 1..256 elements into an off-screen context
+ * at several target resolutions, up to MAX_SOURCE_WIDTH x
+ * MAX_SOURCE_HEIGHT. Elements draw from a shared set of native streams and
+ * cycle through rotations, flips, scale filters and transparency types,
+ * masks included. Every frame updates all sources and then does a
+ * wfcCompose followed by a fence wait, so the measured latency is the full
+ * composition of one frame. Reported are frames/s, latency percentiles
+ * and the mean time per frame spent in each composition stage.
+ */
+
+#define _POSIX_C_SOURCE 200112L /* setenv */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "WF/wfc.h"
+#include "EGL/eglext.h"
+#include "owfnativestream.h"
+#include "owfthread.h"
+#include "wfccontext.h"
+#include "wfcdevice.h"
+
+#define BENCH_MAX_FRAMES 10000
+#define BENCH_MAX_ELEMENTS 256
+#define BENCH_MAX_STREAMS 64
+
+typedef struct {
+    const char* name;
+    WFCint width;
+    WFCint height;
+} BENCH_RESOLUTION;
+
+static const BENCH_RESOLUTION benchResolutions[] = {
+    {"qvga", 320, 240},
+    {"vga", 640, 480},
+    {"wvga", 800, 480},
+    {"720p", MAX_SOURCE_WIDTH, MAX_SOURCE_HEIGHT}};
+
+#define BENCH_RESOLUTION_COUNT \
+    (sizeof(benchResolutions) / sizeof(benchResolutions[0]))
+
+static const WFCint benchElementCounts[] = {1, 2, 4, 8, 16, 32, 64, 128, 256};
+
+#define BENCH_ELEMENT_COUNT_COUNT \
+    (sizeof(benchElementCounts) / sizeof(benchElementCounts[0]))
+
+/* source stream sizes, cycled through when creating streams */
+static const WFCint benchStreamSizes[][2] = {
+    {64, 64}, {256, 256}, {320, 240}, {640, 360}, {MAX_SOURCE_WIDTH, 720}};
+
+#define BENCH_STREAM_SIZE_COUNT \
+    (sizeof(benchStreamSizes) / sizeof(benchStreamSizes[0]))
+
+static const WFCRotation benchRotations[] = {WFC_ROTATION_0, WFC_ROTATION_90,
+                                             WFC_ROTATION_180,
+                                             WFC_ROTATION_270};
+
+static const WFCScaleFilter benchFilters[] = {
+    WFC_SCALE_FILTER_NONE, WFC_SCALE_FILTER_FASTER, WFC_SCALE_FILTER_BETTER};
+
+static const WFCbitfield benchTransparencies[] = {
+    WFC_TRANSPARENCY_NONE,
+    WFC_TRANSPARENCY_ELEMENT_GLOBAL_ALPHA,
+    WFC_TRANSPARENCY_SOURCE,
+    WFC_TRANSPARENCY_MASK,
+    WFC_TRANSPARENCY_ELEMENT_GLOBAL_ALPHA | WFC_TRANSPARENCY_SOURCE,
+    WFC_TRANSPARENCY_ELEMENT_GLOBAL_ALPHA | WFC_TRANSPARENCY_MASK};
+
+#define BENCH_COUNT(a) ((WFCint)(sizeof(a) / sizeof((a)[0])))
+
+typedef struct {
+    WFCint frames;
+    WFCint warmup;
+    WFCint streams;
+    const char* resolutions;
+    const char* elementCounts;
+    const char* outputFile;
+} BENCH_OPTIONS;
+
+typedef struct {
+    WFCDevice dev;
+    WFCContext ctx;
+    WFC_CONTEXT* context;
+    WFCNativeStreamType target;
+    WFCNativeStreamType mask;
+    WFCint maskWidth;
+    WFCint maskHeight;
+    WFCSource sources[BENCH_MAX_STREAMS];
+    WFCMask maskHandle;
+    WFCElement elements[BENCH_MAX_ELEMENTS];
+    WFCint elementCount;
+    WFCNativeStreamType* streams;
+    WFCint streamCount;
+    EGLSyncKHR sync;
+} BENCH_SCENE;
+
+/*----------------------------------------------------------------------------*/
+static double Bench_Now(void) { return (double)OWF_Thread_GetNanoTime(); }
+
+static int Bench_CompareDouble(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+
+    return (x > y) - (x < y);
+}
+
+static double Bench_Percentile(const double* sorted, WFCint count,
+                               WFCint percent) {
+    WFCint index = (count * percent + 99) / 100 - 1;
+
+    if (index < 0) {
+        index = 0;
+    }
+    return sorted[index];
+}
+
+/* deterministic scene layout, independent of the C library */
+static WFCint Bench_Random(OWFuint32* seed, WFCint range) {
+    *seed = *seed * 1103515245u + 12345u;
+    return (WFCint)((*seed >> 16) % (OWFuint32)range);
+}
+
+/*----------------------------------------------------------------------------*/
+static WFCNativeStreamType Bench_CreateStream(WFCint width, WFCint height,
+                                              OWF_PIXEL_FORMAT pixelFormat) {
+    OWF_IMAGE_FORMAT format;
+
+    format.pixelFormat = pixelFormat;
+    format.linear = OWF_FALSE;
+    format.premultiplied = (pixelFormat == OWF_IMAGE_ARGB8888);
+    format.rowPadding = OWF_Image_GetFormatPadding(pixelFormat);
+
+    return owfNativeStreamCreateImageStream(width, height, &format, 1);
+}
+
+/* translucent premultiplied gradient, so source alpha does real work */
+static void Bench_FillStream(WFCNativeStreamType stream, WFCint seed) {
+    OWFNativeStreamBuffer buffer;
+    OWFuint8* pixels;
+    WFCint width, height, stride, x, y;
+
+    owfNativeStreamGetHeader(stream, &width, &height, &stride, NULL, NULL);
+    buffer = owfNativeStreamAcquireWriteBuffer(stream);
+    pixels = (OWFuint8*)owfNativeStreamGetBufferPtr(stream, buffer);
+
+    for (y = 0; y < height; y++) {
+        OWFuint32* row = (OWFuint32*)(pixels + y * stride);
+
+        for (x = 0; x < width; x++) {
+            OWFuint32 a = 128 + (OWFuint32)((x + seed) & 127);
+            OWFuint32 r = (OWFuint32)((x * 255) / width) * a / 255;
+            OWFuint32 g = (OWFuint32)((y * 255) / height) * a / 255;
+            OWFuint32 b = (OWFuint32)((seed * 37) & 255) * a / 255;
+
+            row[x] = (a << 24) | (r << 16) | (g << 8) | b;
+        }
+    }
+
+    owfNativeStreamReleaseWriteBuffer(stream, buffer, EGL_DEFAULT_DISPLAY,
+                                      EGL_NO_SYNC_KHR);
+}
+
+static void Bench_FillMask(WFCNativeStreamType stream) {
+    OWFNativeStreamBuffer buffer;
+    OWFuint8* pixels;
+    WFCint width, height, stride, x, y;
+
+    owfNativeStreamGetHeader(stream, &width, &height, &stride, NULL, NULL);
+    buffer = owfNativeStreamAcquireWriteBuffer(stream);
+    pixels = (OWFuint8*)owfNativeStreamGetBufferPtr(stream, buffer);
+
+    for (y = 0; y < height; y++) {
+        for (x = 0; x < width; x++) {
+            pixels[y * stride + x] = (OWFuint8)((x ^ y) & 255);
+        }
+    }
+
+    owfNativeStreamReleaseWriteBuffer(stream, buffer, EGL_DEFAULT_DISPLAY,
+                                      EGL_NO_SYNC_KHR);
+}
+
+/*----------------------------------------------------------------------------*/
+static void Bench_DestroyScene(BENCH_SCENE* scene, WFCint sourceCount) {
+    WFCint i;
+
+    for (i = 0; i < scene->elementCount; i++) {
+        wfcDestroyElement(scene->dev, scene->elements[i]);
+    }
+    scene->elementCount = 0;
+    if (scene->ctx != WFC_INVALID_HANDLE) {
+        wfcCommit(scene->dev, scene->ctx, WFC_TRUE);
+    }
+
+    for (i = 0; i < sourceCount; i++) {
+        if (scene->sources[i] != WFC_INVALID_HANDLE) {
+            wfcDestroySource(scene->dev, scene->sources[i]);
+        }
+    }
+    if (scene->maskHandle != WFC_INVALID_HANDLE) {
+        wfcDestroyMask(scene->dev, scene->maskHandle);
+    }
+    if (scene->ctx != WFC_INVALID_HANDLE) {
+        wfcDestroyContext(scene->dev, scene->ctx);
+    }
+    if (scene->mask != WFC_INVALID_HANDLE) {
+        owfNativeStreamDestroy(scene->mask);
+    }
+    if (scene->target != WFC_INVALID_HANDLE) {
+        owfNativeStreamDestroy(scene->target);
+    }
+    if (scene->sync != EGL_NO_SYNC_KHR) {
+        eglDestroySyncKHR(EGL_DEFAULT_DISPLAY, scene->sync);
+    }
+}
+
+static WFCboolean Bench_CreateContext(BENCH_SCENE* scene, WFCDevice dev,
+                                      const BENCH_RESOLUTION* res,
+                                      WFCNativeStreamType* streams,
+                                      WFCint streamCount) {
+    WFCint i;
+
+    memset(scene, 0, sizeof(*scene));
+    scene->dev = dev;
+    scene->streams = streams;
+    scene->streamCount = streamCount;
+    scene->sync = EGL_NO_SYNC_KHR;
+
+    scene->target = Bench_CreateStream(res->width, res->height,
+                                       OWF_IMAGE_ARGB8888);
+    /* masked elements are placed at the mask's size */
+    scene->maskWidth = res->width / 2;
+    scene->maskHeight = res->height / 2;
+    scene->mask = Bench_CreateStream(scene->maskWidth, scene->maskHeight,
+                                     OWF_IMAGE_L8);
+    if (scene->target == WFC_INVALID_HANDLE ||
+        scene->mask == WFC_INVALID_HANDLE) {
+        return WFC_FALSE;
+    }
+    Bench_FillMask(scene->mask);
+
+    scene->ctx = wfcCreateOffScreenContext(dev, scene->target, NULL);
+    if (scene->ctx == WFC_INVALID_HANDLE) {
+        return WFC_FALSE;
+    }
+    scene->context =
+        WFC_Device_FindContext(WFC_Device_FindByHandle(dev), scene->ctx);
+
+    for (i = 0; i < streamCount; i++) {
+        scene->sources[i] =
+            wfcCreateSourceFromStream(dev, scene->ctx, streams[i], NULL);
+        if (scene->sources[i] == WFC_INVALID_HANDLE) {
+            return WFC_FALSE;
+        }
+    }
+    scene->maskHandle = wfcCreateMaskFromStream(dev, scene->ctx, scene->mask,
+                                                NULL);
+
+    scene->sync =
+        eglCreateSyncKHR(EGL_DEFAULT_DISPLAY, EGL_SYNC_REUSABLE_KHR, NULL);
+
+    return (scene->context && scene->maskHandle != WFC_INVALID_HANDLE &&
+            scene->sync != EGL_NO_SYNC_KHR)
+               ? WFC_TRUE
+               : WFC_FALSE;
+}
+
+/* Grow the scene to count elements. Element i always gets the same
+ * attributes, so larger scenes extend smaller ones. */
+static WFCboolean Bench_AddElements(BENCH_SCENE* scene,
+                                    const BENCH_RESOLUTION* res,
+                                    WFCNativeStreamType* streams,
+                                    WFCint streamCount, WFCint count) {
+    WFCint i;
+
+    for (i = scene->elementCount; i < count; i++) {
+        OWFuint32 seed = (OWFuint32)i * 7919u + 1u;
+        WFCint stream = i % streamCount;
+        WFCbitfield transparency =
+            benchTransparencies[i % BENCH_COUNT(benchTransparencies)];
+        WFCint srcRect[4];
+        WFCint dstRect[4];
+        WFCElement element;
+
+        element = wfcCreateElement(scene->dev, scene->ctx, NULL);
+        if (element == WFC_INVALID_HANDLE) {
+            return WFC_FALSE;
+        }
+        scene->elements[scene->elementCount++] = element;
+
+        srcRect[0] = 0;
+        srcRect[1] = 0;
+        owfNativeStreamGetHeader(streams[stream], &srcRect[2], &srcRect[3],
+                                 NULL, NULL, NULL);
+
+        if (transparency & WFC_TRANSPARENCY_MASK) {
+            dstRect[2] = scene->maskWidth;
+            dstRect[3] = scene->maskHeight;
+            wfcSetElementAttribi(scene->dev, element, WFC_ELEMENT_MASK,
+                                 scene->maskHandle);
+        } else {
+            /* a quarter to the whole of the target in each direction */
+            dstRect[2] = res->width / 4 + Bench_Random(&seed, res->width * 3 / 4);
+            dstRect[3] =
+                res->height / 4 + Bench_Random(&seed, res->height * 3 / 4);
+        }
+        dstRect[0] = Bench_Random(&seed, res->width - dstRect[2] + 1);
+        dstRect[1] = Bench_Random(&seed, res->height - dstRect[3] + 1);
+
+        wfcSetElementAttribi(scene->dev, element, WFC_ELEMENT_SOURCE,
+                             scene->sources[stream]);
+        wfcSetElementAttribiv(scene->dev, element, WFC_ELEMENT_SOURCE_RECTANGLE,
+                              4, srcRect);
+        wfcSetElementAttribiv(scene->dev, element,
+                              WFC_ELEMENT_DESTINATION_RECTANGLE, 4, dstRect);
+        wfcSetElementAttribi(scene->dev, element, WFC_ELEMENT_SOURCE_ROTATION,
+                             benchRotations[i % BENCH_COUNT(benchRotations)]);
+        wfcSetElementAttribi(scene->dev, element, WFC_ELEMENT_SOURCE_FLIP,
+                             (i / BENCH_COUNT(benchRotations)) & 1);
+        wfcSetElementAttribi(scene->dev, element,
+                             WFC_ELEMENT_SOURCE_SCALE_FILTER,
+                             benchFilters[i % BENCH_COUNT(benchFilters)]);
+        wfcSetElementAttribi(scene->dev, element,
+                             WFC_ELEMENT_TRANSPARENCY_TYPES, transparency);
+        wfcSetElementAttribf(scene->dev, element, WFC_ELEMENT_GLOBAL_ALPHA,
+                             0.75f);
+
+        wfcInsertElement(scene->dev, element, WFC_INVALID_HANDLE);
+        if (wfcGetError(scene->dev) != WFC_ERROR_NONE) {
+            return WFC_FALSE;
+        }
+    }
+
+    wfcCommit(scene->dev, scene->ctx, WFC_TRUE);
+    return (wfcGetError(scene->dev) == WFC_ERROR_NONE) ? WFC_TRUE : WFC_FALSE;
+}
+
+/* republish a stream's buffer unchanged; the composer takes it as new
+ * content */
+static void Bench_TouchStream(WFCNativeStreamType stream) {
+    OWFNativeStreamBuffer buffer;
+
+    buffer = owfNativeStreamAcquireWriteBuffer(stream);
+    owfNativeStreamReleaseWriteBuffer(stream, buffer, EGL_DEFAULT_DISPLAY,
+                                      EGL_NO_SYNC_KHR);
+}
+
+/* compose one frame and wait until it has been written to the target.
+ * All sources are updated first, outside the timing, so that damage
+ * tracking cannot skip any element. */
+static double Bench_ComposeFrame(BENCH_SCENE* scene) {
+    double start;
+    WFCint i;
+
+    for (i = 0; i < scene->streamCount; i++) {
+        Bench_TouchStream(scene->streams[i]);
+    }
+    Bench_TouchStream(scene->mask);
+
+    start = Bench_Now();
+
+    wfcCompose(scene->dev, scene->ctx, WFC_TRUE);
+    wfcFence(scene->dev, scene->ctx, EGL_DEFAULT_DISPLAY, scene->sync);
+    eglClientWaitSyncKHR(EGL_DEFAULT_DISPLAY, scene->sync, 0,
+                         EGL_FOREVER_KHR);
+
+    return Bench_Now() - start;
+}
+
+/*----------------------------------------------------------------------------*/
+static void Bench_Usage(const char* program) {
+    printf(
+        "usage: %s [options]\n"
+        "  -f N        timed frames per scene (default 100, max %d)\n"
+        "  -w N        untimed warmup frames per scene (default 5)\n"
+        "  -n N        number of source streams (default 8, max %d)\n"
+        "  -e LIST     comma separated element counts\n"
+        "              (default 1,2,4,8,16,32,64,128,256)\n"
+        "  -s LIST     comma separated target resolutions (default all):\n"
+        "              qvga, vga, wvga, 720p\n"
+        "  -o FILE     write results to FILE as CSV\n",
+        program, BENCH_MAX_FRAMES, BENCH_MAX_STREAMS);
+}
+
+static WFCboolean Bench_ParseOptions(BENCH_OPTIONS* options, int argc,
+                                     char** argv) {
+    int i;
+
+    options->frames = 100;
+    options->warmup = 5;
+    options->streams = 8;
+    options->resolutions = NULL;
+    options->elementCounts = NULL;
+    options->outputFile = NULL;
+
+    for (i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (value && !strcmp(arg, "-f")) {
+            options->frames = atoi(value);
+            i++;
+        } else if (value && !strcmp(arg, "-w")) {
+            options->warmup = atoi(value);
+            i++;
+        } else if (value && !strcmp(arg, "-n")) {
+            options->streams = atoi(value);
+            i++;
+        } else if (value && !strcmp(arg, "-e")) {
+            options->elementCounts = value;
+            i++;
+        } else if (value && !strcmp(arg, "-s")) {
+            options->resolutions = value;
+            i++;
+        } else if (value && !strcmp(arg, "-o")) {
+            options->outputFile = value;
+            i++;
+        } else {
+            return WFC_FALSE;
+        }
+    }
+
+    return (options->frames >= 1 && options->frames <= BENCH_MAX_FRAMES &&
+            options->warmup >= 0 && options->streams >= 1 &&
+            options->streams <= BENCH_MAX_STREAMS)
+               ? WFC_TRUE
+               : WFC_FALSE;
+}
+
+/* whole-word match in a comma separated list */
+static WFCboolean Bench_ListContains(const char* list, const char* name) {
+    size_t length = strlen(name);
+
+    while (list && *list) {
+        if (!strncmp(list, name, length) &&
+            (list[length] == ',' || list[length] == '\0')) {
+            return WFC_TRUE;
+        }
+        list = strchr(list, ',');
+        if (list) {
+            list++;
+        }
+    }
+    return WFC_FALSE;
+}
+
+/*----------------------------------------------------------------------------*/
+int main(int argc, char** argv) {
+    static double latency[BENCH_MAX_FRAMES];
+    WFCNativeStreamType streams[BENCH_MAX_STREAMS];
+    BENCH_OPTIONS options;
+    FILE* output = NULL;
+    WFCDevice dev;
+    size_t r, e;
+    WFCint i;
+
+    if (!Bench_ParseOptions(&options, argc, argv)) {
+        Bench_Usage(argv[0]);
+        return 1;
+    }
+
+    /* nothing is shown, so keep the SDL adaptation from opening a window
+     * unless the caller asked for a particular video driver */
+    setenv("SDL_VIDEODRIVER", "dummy", 0);
+
+    dev = wfcCreateDevice(WFC_DEFAULT_DEVICE_ID, NULL);
+    if (dev == WFC_INVALID_HANDLE) {
+        printf("cannot create device\n");
+        return 1;
+    }
+
+    for (i = 0; i < options.streams; i++) {
+        const WFCint* size = benchStreamSizes[i % BENCH_STREAM_SIZE_COUNT];
+
+        streams[i] = Bench_CreateStream(size[0], size[1], OWF_IMAGE_ARGB8888);
+        if (streams[i] == WFC_INVALID_HANDLE) {
+            printf("cannot create source stream %d\n", i);
+            return 1;
+        }
+        Bench_FillStream(streams[i], i);
+    }
+
+    if (options.outputFile) {
+        output = fopen(options.outputFile, "w");
+        if (!output) {
+            printf("cannot open %s\n", options.outputFile);
+            return 1;
+        }
+        fprintf(output,
+                "resolution,width,height,elements,frames,fps,p50_ms,p90_ms,"
+                "p99_ms,max_ms,prepare_ms,begin_ms,source_ms,transform_ms,"
+                "blending_ms,finish_ms\n");
+    }
+
+    printf("%-5s %8s %9s %8s %8s %8s %8s %8s %8s %8s %8s %8s %8s\n", "res",
+           "elements", "frames/s", "p50 ms", "p90 ms", "p99 ms", "max ms",
+           "prep", "begin", "source", "xform", "blend", "finish");
+
+    for (r = 0; r < BENCH_RESOLUTION_COUNT; r++) {
+        const BENCH_RESOLUTION* res = &benchResolutions[r];
+        BENCH_SCENE scene;
+
+        if (options.resolutions &&
+            !Bench_ListContains(options.resolutions, res->name)) {
+            continue;
+        }
+
+        if (!Bench_CreateContext(&scene, dev, res, streams, options.streams)) {
+            printf("%s: cannot create context, skipped\n", res->name);
+            Bench_DestroyScene(&scene, options.streams);
+            continue;
+        }
+
+        for (e = 0; e < BENCH_ELEMENT_COUNT_COUNT; e++) {
+            WFCint count = benchElementCounts[e];
+            WFC_PIPELINE_STATS stats;
+            double total = 0.0, stage[WFC_STAGE_COUNT];
+            char countName[16];
+            WFCint s;
+
+            sprintf(countName, "%d", count);
+            if (options.elementCounts &&
+                !Bench_ListContains(options.elementCounts, countName)) {
+                continue;
+            }
+
+            if (!Bench_AddElements(&scene, res, streams, options.streams,
+                                   count)) {
+                printf("%s: cannot create %d elements\n", res->name, count);
+                break;
+            }
+
+            for (i = 0; i < options.warmup; i++) {
+                Bench_ComposeFrame(&scene);
+            }
+
+            WFC_Context_ResetPipelineStats(scene.context);
+            for (i = 0; i < options.frames; i++) {
+                latency[i] = Bench_ComposeFrame(&scene);
+                total += latency[i];
+            }
+            WFC_Context_GetPipelineStats(scene.context, &stats);
+
+            for (s = 0; s < WFC_STAGE_COUNT; s++) {
+                stage[s] = stats.frames
+                               ? (double)stats.stageTime[s] / stats.frames / 1e6
+                               : 0.0;
+            }
+
+            qsort(latency, options.frames, sizeof(latency[0]),
+                  Bench_CompareDouble);
+
+            printf(
+                "%-5s %8d %9.1f %8.3f %8.3f %8.3f %8.3f %8.3f %8.3f %8.3f "
+                "%8.3f %8.3f %8.3f\n",
+                res->name, count, options.frames * 1e9 / total,
+                Bench_Percentile(latency, options.frames, 50) / 1e6,
+                Bench_Percentile(latency, options.frames, 90) / 1e6,
+                Bench_Percentile(latency, options.frames, 99) / 1e6,
+                latency[options.frames - 1] / 1e6,
+                stage[WFC_STAGE_PREPARE], stage[WFC_STAGE_BEGIN],
+                stage[WFC_STAGE_SOURCE_CONVERSION], stage[WFC_STAGE_TRANSFORM],
+                stage[WFC_STAGE_BLENDING], stage[WFC_STAGE_FINISH]);
+
+            if (output) {
+                fprintf(output,
+                        "%s,%d,%d,%d,%d,%.2f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,"
+                        "%.4f,%.4f,%.4f,%.4f\n",
+                        res->name, res->width, res->height, count,
+                        options.frames, options.frames * 1e9 / total,
+                        Bench_Percentile(latency, options.frames, 50) / 1e6,
+                        Bench_Percentile(latency, options.frames, 90) / 1e6,
+                        Bench_Percentile(latency, options.frames, 99) / 1e6,
+                        latency[options.frames - 1] / 1e6,
+                        stage[WFC_STAGE_PREPARE], stage[WFC_STAGE_BEGIN],
+                        stage[WFC_STAGE_SOURCE_CONVERSION],
+                        stage[WFC_STAGE_TRANSFORM], stage[WFC_STAGE_BLENDING],
+                        stage[WFC_STAGE_FINISH]);
+            }
+        }
+
+        Bench_DestroyScene(&scene, options.streams);
+    }
+
+    if (output) {
+        fclose(output);
+    }
+
+    for (i = 0; i < options.streams; i++) {
+        owfNativeStreamDestroy(streams[i]);
+    }
+    wfcDestroyDevice(dev);
+
+    return 0;
+}
@@ -282,6 +282,25 @@ OWF_API_CALL void WFC_Context_SourceStreamUpdated(OWFNativeStreamType stream,
 
 OWF_API_CALL WFCboolean WFC_Context_Active(WFC_CONTEXT* context);
 
+/*!
+ *  \brief Read the context's accumulated per-stage composition timings
+ *
+ *  Timings are summed over all frames composed since the context was
+ *  created or the statistics were last reset.
+ *
+ *  \param context
+ *  \param stats Where to copy the statistics
+ */
+OWF_API_CALL void WFC_Context_GetPipelineStats(WFC_CONTEXT* context,
+                                               WFC_PIPELINE_STATS* stats);
+
+/*!
+ *  \brief Reset the context's per-stage composition timings
+ *
+ *  \param context
+ */
+OWF_API_CALL void WFC_Context_ResetPipelineStats(WFC_CONTEXT* context);
+
 #ifdef __cplusplus
 }
 #endif
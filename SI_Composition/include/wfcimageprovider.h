@@ -51,6 +51,12 @@ OWF_API_CALL void WFC_ImageProvider_LockForReading(
 
 OWF_API_CALL void WFC_ImageProvider_Unlock(WFC_IMAGE_PROVIDER* provider);
 
+OWF_API_CALL OWF_IMAGE* WFC_ImageProvider_GetMask(
+    WFC_IMAGE_PROVIDER* provider);
+
+OWF_API_CALL OWFuint32 WFC_ImageProvider_GetSerial(
+    WFC_IMAGE_PROVIDER* provider);
+
 #ifdef __cplusplus
 }
 #endif
@@ -50,11 +50,13 @@
  *
  *  \param context          Context
  *  \param element          Element
+ *  \param elementState     One of the context's element states
  *
- *  \return Boolean value indicating whether preparation succeeded
+ *  \return The element state, or NULL if the element is not composed
  *//*-------------------------------------------------------------------------*/
 OWF_API_CALL WFC_ELEMENT_STATE* WFC_Pipeline_BeginComposition(
-    WFC_CONTEXT* context, WFC_ELEMENT* element);
+    WFC_CONTEXT* context, WFC_ELEMENT* element,
+    WFC_ELEMENT_STATE* elementState);
 
 /*------------------------------------------------------------------------ *//*!
  *  Composition pipeline cleanup
@@ -67,7 +69,7 @@ OWF_API_CALL void WFC_Pipeline_EndComposition(WFC_CONTEXT* context,
                                               WFC_ELEMENT_STATE* elementState);
 
 /*------------------------------------------------------------------------ *//*!
- *  \brief Source conversion stage
+ *  \brief Source conversion stage, fused with cropping to the viewport
  *
  *  \param context          Context
  *  \param element          Element
@@ -76,49 +78,24 @@ OWF_API_CALL void WFC_Pipeline_ExecuteSourceConversionStage(
     WFC_CONTEXT* context, WFC_ELEMENT_STATE* elementState);
 
 /*------------------------------------------------------------------------ *//*!
- *  \brief Crop stage
- *
- *  \param context          Context
- *  \param element          Element
- *//*-------------------------------------------------------------------------*/
-OWF_API_CALL void WFC_Pipeline_ExecuteCropStage(
-    WFC_CONTEXT* context, WFC_ELEMENT_STATE* elementState);
-
-/*------------------------------------------------------------------------ *//*!
- *  \brief Flip stage
+ *  \brief Transform stage: flip, rotation and scaling in one pass
  *
  *  \param context          Context
  *  \param element          Element
  *//*-------------------------------------------------------------------------*/
-OWF_API_CALL void WFC_Pipeline_ExecuteFlipStage(
+OWF_API_CALL void WFC_Pipeline_ExecuteTransformStage(
     WFC_CONTEXT* context, WFC_ELEMENT_STATE* elementState);
 
 /*------------------------------------------------------------------------ *//*!
- *  \brief Rotation stage
- *
- *  \param context          Context
- *  \param element          Element
- *//*-------------------------------------------------------------------------*/
-OWF_API_CALL void WFC_Pipeline_ExecuteRotationStage(
-    WFC_CONTEXT* context, WFC_ELEMENT_STATE* elementState);
-
-/*------------------------------------------------------------------------ *//*!
- *  \brief Scaling stage
- *
- *  \param context          Context
- *  \param element          Element
- *//*-------------------------------------------------------------------------*/
-OWF_API_CALL void WFC_Pipeline_ExecuteScalingStage(
-    WFC_CONTEXT* context, WFC_ELEMENT_STATE* elementState);
-
-/*------------------------------------------------------------------------ *//*!
- *  \brief Blending stage
+ *  \brief Blending stage, restricted to a region of the internal target
  *
  *  \param context          Context
  *  \param element          Element
+ *  \param region           Part of the internal target to compose
  *//*-------------------------------------------------------------------------*/
 OWF_API_CALL void WFC_Pipeline_ExecuteBlendingStage(
-    WFC_CONTEXT* context, WFC_ELEMENT_STATE* elementState);
+    WFC_CONTEXT* context, WFC_ELEMENT_STATE* elementState,
+    OWF_RECTANGLE* region);
 
 /*------------------------------------------------------------------------ *//*!
  *  \brief Composition pipeline preparation per context creation
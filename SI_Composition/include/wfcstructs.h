@@ -42,6 +42,7 @@
 #include "owfstream.h"
 #include "owfthread.h"
 #include "owftypes.h"
+#include "owfworkerpool.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -95,9 +96,18 @@ Scratch buffers needed:
 1 for cropped source image
 1 for cropped mask image
 1 for scaled element image
-1 for mask
+Masks are converted into their image provider's mask cache instead.
 */
-#define SCRATCH_BUFFER_COUNT 5
+#define SCRATCH_BUFFER_COUNT 4
+
+/*!
+Most elements preprocessed concurrently, one per worker. The first
+element state uses the scratch buffers; the others allocate intermediate
+images of the same size when first used.
+*/
+#ifndef WFC_MAX_WORKERS
+#define WFC_MAX_WORKERS 8
+#endif
 
 typedef struct {
     /*! elements, ordered by depth; starting from bottom */
@@ -113,30 +123,17 @@ typedef struct {
     OWF_IMAGE* originalSourceImage;
     OWF_IMAGE* originalMaskImage;
 
-    /*! converted source image -
-       results of the first stage in the
-       composition */
-    OWF_IMAGE_INST convertedSourceImage;
-
-    /*! cropped source image - result of cropping stage */
+    /*! cropped source image - result of the source conversion stage,
+       which converts only the source viewport */
     OWF_IMAGE_INST croppedSourceImage;
 
-    /*! mirrored source intermediate image - temp buffer used in mirroring stage
-     */
-    OWF_IMAGE_INST rotatedSourceIntermediateImage;
-
-    /*! mirrored source image - result of mirroring stage */
-    OWF_IMAGE_INST flippedSourceImage;
-
-    /*! rotated source image - result of rotation stage */
-    OWF_IMAGE_INST rotatedSourceImage;
-
-    /*! these are the "final size" (i.e. destination
-       size) versions of the previous. used in
-       the blending stage */
+    /*! flipped, rotated and scaled (i.e. destination size) version of
+       the previous - result of the transform stage, used in the
+       blending stage */
     OWF_IMAGE_INST scaledSourceImage;
     OWF_RECTANGLE scaledSrcRect;
-    OWF_IMAGE_INST maskImage;
+    /*! converted mask, owned by the mask's image provider */
+    OWF_IMAGE* maskImage;
 
     /*! support for blending operation */
     OWF_BLEND_INFO blendInfo;
@@ -161,8 +158,55 @@ typedef struct {
     /*! flipping */
     WFCboolean sourceFlip;
 
+    /*! source viewport is converted straight into the target, skipping
+       the intermediate images, transform and blending stages */
+    WFCboolean directCopy;
+
+    /*! part of dstRect not hidden by opaque elements above */
+    OWF_RECTANGLE visibleRect;
+    /*! image the transform stage writes and the blending stage reads:
+       scaledSourceImage, or the image of the element's transform cache
+       entry. transformCached is set if that entry was up to date, in
+       which case conversion and transform are skipped. */
+    OWF_IMAGE* transformedImage;
+    struct WFC_TRANSFORM_CACHE_ENTRY_* transformEntry;
+    WFCboolean transformCached;
+
+    /*! time spent in the source conversion and transform stages, which
+       may run on another worker */
+    OWFuint64 conversionTime;
+    OWFuint64 transformTime;
+
 } WFC_ELEMENT_STATE;
 
+/*! Everything a transformed source image depends on: the source buffer
+    content and the attributes of conversion, crop, flip, rotation,
+    scaling and premultiplication */
+typedef struct {
+    OWFNativeStreamType stream;
+    const void* pixels;
+    OWFuint32 serial;
+    WFCfloat sourceRect[4];
+    OWFint width;
+    OWFint height;
+    WFCRotation rotation;
+    WFCboolean flip;
+    WFCScaleFilter filter;
+    WFCboolean premultiplied;
+} WFC_TRANSFORM_KEY;
+
+/*! An element's transformed source, reused for as long as its key stays
+    the same */
+typedef struct WFC_TRANSFORM_CACHE_ENTRY_ {
+    WFCElement element;
+    OWFuint32 hash;
+    WFC_TRANSFORM_KEY key;
+    OWF_IMAGE* image;
+    /*! set while an element state refers to the image; such an entry is
+       not evicted */
+    WFCboolean inUse;
+} WFC_TRANSFORM_CACHE_ENTRY;
+
 typedef enum { WFC_IMAGE_SOURCE, WFC_IMAGE_MASK } WFC_IMAGE_PROVIDER_TYPE;
 
 typedef struct {
@@ -178,6 +222,8 @@ typedef struct {
     OWF_STREAM* stream;
     void* owner;
     WFC_LOCK_STREAM lockedStream;
+    /*! mask converted to internal format, for mask providers */
+    OWF_MASK_CACHE maskCache;
 
 } WFC_IMAGE_PROVIDER;
 
@@ -211,6 +257,16 @@ typedef struct {
     /*! Set in WFC_Element_BeginComposition to indicate whether
      * the mask stream should be included in composition */
     WFCboolean maskComposed;
+    /*! set by the visibility pass when opaque elements above cover the
+       element entirely */
+    WFCboolean occluded;
+    /*! bounds of the part of the element's destination rectangle that
+       opaque elements above leave uncovered, clipped to the target */
+    OWF_RECTANGLE visibleRect;
+    /*! serials of the source and mask buffers last composed, for damage
+       tracking; zero if not composed yet */
+    OWFuint32 sourceSerial;
+    OWFuint32 maskSerial;
 } WFC_ELEMENT;
 
 typedef enum {
@@ -220,6 +276,37 @@ typedef enum {
     WFC_CONTEXT_STATE_DEACTIVATING
 } WFC_CONTEXT_ACTIVATION_STATE;
 
+/*! composition stages timed by the composer */
+typedef enum {
+    WFC_STAGE_PREPARE,
+    WFC_STAGE_BEGIN, /* per-element setup, WFC_Pipeline_BeginComposition */
+    WFC_STAGE_SOURCE_CONVERSION,
+    WFC_STAGE_TRANSFORM,
+    WFC_STAGE_BLENDING,
+    WFC_STAGE_FINISH,
+    WFC_STAGE_COUNT
+} WFC_PIPELINE_STAGE;
+
+/*! most rectangles a damage region is kept in; more are merged */
+#define WFC_MAX_DAMAGE_RECTS 8
+/*! frames of damage remembered for multi-buffered targets */
+#define WFC_DAMAGE_HISTORY 4
+
+/*! region of the target that has to be redrawn, as disjoint rectangles
+    in internal target coordinates */
+typedef struct {
+    OWFboolean full;
+    OWFint count;
+    OWF_RECTANGLE rects[WFC_MAX_DAMAGE_RECTS];
+} WFC_DAMAGE;
+
+/*! accumulated composition timings, in nanoseconds */
+typedef struct {
+    OWFuint64 frames;
+    OWFuint64 elements;
+    OWFuint64 stageTime[WFC_STAGE_COUNT];
+} WFC_PIPELINE_STATS;
+
 typedef struct WFC_CONTEXT_ {
     WFCContext handle;
     WFC_DEVICE* device;
@@ -269,7 +356,38 @@ typedef struct WFC_CONTEXT_ {
     OWF_DISPCTX displayContext;
 
     WFCEGLDisplay nextSyncObjectDisplay;
-    WFC_ELEMENT_STATE prototypeElementState;
+    /*! states of the elements composed together; the source conversion
+       and transform stages of up to elementStateCount elements run
+       concurrently on the workers, one element per state */
+    WFC_ELEMENT_STATE elementStates[WFC_MAX_WORKERS];
+    OWFint elementStateCount;
+    /*! NULL if there is a single worker, the composer thread */
+    OWF_WORKER_POOL workers;
+
+    /*! per-stage composition timings; guarded by sceneMutex */
+    WFC_PIPELINE_STATS stats;
+
+    /*! committed scene's elements, bottom to top, for the visibility pass */
+    OWF_ARRAY visibilityOrder;
+
+    /*! damage tracking; composer thread only. pendingDamage collects
+       changes until the next composition, frameDamage is what that
+       composition redraws. damageHistory holds the frameDamage of the
+       latest frames, newest first, and damageBuffers the target buffer
+       each of them was written to. */
+    WFC_DAMAGE pendingDamage;
+    WFC_DAMAGE frameDamage;
+    WFC_DAMAGE damageHistory[WFC_DAMAGE_HISTORY];
+    OWFNativeStreamBuffer damageBuffers[WFC_DAMAGE_HISTORY];
+    OWFint damageHistoryLength;
+    /*! rotation and background color of the latest composition */
+    WFCRotation composedRotation;
+    OWFuint32 composedBackgroundColor;
+
+    /*! transformed element sources, most recently used first, and the
+       bytes of image data they hold; composer thread only */
+    OWF_ARRAY transformCache;
+    OWFint transformCacheSize;
 } WFC_CONTEXT;
 
 #define IMAGE_PROVIDER(x) ((WFC_IMAGE_PROVIDER*)(x))
@@ -363,6 +363,7 @@ WFC_API_CALL WFCSource WFC_APIENTRY wfcCreateSourceFromStream(
     WFC_DEVICE* device;
     WFC_IMAGE_PROVIDER* source;
     WFC_CONTEXT* context;
+    OWF_IMAGE_FORMAT format;
 
     GET_DEVICE(device, dev, WFC_INVALID_HANDLE);
 
@@ -376,6 +377,14 @@ WFC_API_CALL WFCSource WFC_APIENTRY wfcCreateSourceFromStream(
 
     COND_FAIL(context->stream != stream, WFC_ERROR_IN_USE, WFC_INVALID_HANDLE);
 
+    /* invalid streams are left for source creation to reject */
+    format.pixelFormat = OWF_IMAGE_NOT_SUPPORTED;
+    owfNativeStreamGetHeader((OWFNativeStreamType)stream, NULL, NULL, NULL,
+                             &format, NULL);
+    COND_FAIL(format.pixelFormat == OWF_IMAGE_NOT_SUPPORTED ||
+                  OWF_Image_IsSupportedSourceFormat(format.pixelFormat),
+              WFC_ERROR_UNSUPPORTED, WFC_INVALID_HANDLE);
+
     source = WFC_Device_CreateSource(device, context, stream);
     COND_FAIL(NULL != source, WFC_ERROR_OUT_OF_MEMORY, WFC_INVALID_HANDLE);
 
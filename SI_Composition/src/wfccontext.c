@@ -136,14 +136,16 @@ static WFCboolean WFC_Context_CreateState(
             OWF_Image_Create(context->targetWidth, context->targetHeight, &fInt,
                              context->scratchBuffer[1], 0);
     }
-    /* The internal target buffer composed to for 0 and 180 degree rotation */
+    /* The internal target buffer composed to for 0 and 180 degree rotation.
+     * Internal rows have their own padding; the target stream's stride
+     * would not fit the scratch buffer when rotated */
     context->state.unrotatedInternalTargetImage =
         OWF_Image_Create(context->targetWidth, context->targetHeight, &fInt,
-                         context->scratchBuffer[0], stride);
+                         context->scratchBuffer[0], 0);
     /* The internal target buffer composed to for 90 and 270 degree rotation */
     context->state.rotatedInternalTargetImage =
         OWF_Image_Create(context->targetHeight, context->targetWidth, &fInt,
-                         context->scratchBuffer[0], stride);
+                         context->scratchBuffer[0], 0);
 
     if (context->state.unrotatedTargetImage &&
         context->state.rotatedTargetImage &&
@@ -210,6 +212,8 @@ void WFC_CONTEXT_Dtor(void* self) {
     OWF_Semaphore_Destroy(&context->commitSemaphore);
     OWF_Mutex_Destroy(&context->updateFlagMutex);
     OWF_Mutex_Destroy(&context->sceneMutex);
+
+    OWF_Array_Destroy(&context->visibilityOrder);
 }
 
 /*---------------------------------------------------------------------------
@@ -370,21 +374,13 @@ static WFC_CONTEXT* WFC_Context_Initialize(WFC_CONTEXT* context,
         WFC_Context_SetTargetStream(context, stream);
     }
 
-    nbufs = SCRATCH_BUFFER_COUNT - 1;
+    nbufs = SCRATCH_BUFFER_COUNT;
     for (ii = 0; ii < nbufs; ii++) {
         scratch[ii] = OWF_Image_AllocData(MAX_SOURCE_WIDTH, MAX_SOURCE_HEIGHT,
                                           OWF_IMAGE_ARGB_INTERNAL);
         fail = fail || (scratch[ii] == NULL);
     }
 
-    /*
-     * allocate one-channel buffer for alpha
-     * obs! this assumes sizeof(OWFsubpixel) is 4.
-     */
-    scratch[nbufs] =
-        OWF_Image_AllocData(MAX_SOURCE_WIDTH, MAX_SOURCE_HEIGHT, OWF_IMAGE_L32);
-    fail = fail || (scratch[nbufs] == NULL);
-
     err2 = OWF_MessageQueue_Init(&context->composerQueue);
     fail = fail || (err2 != 0);
 
@@ -404,6 +400,11 @@ static WFC_CONTEXT* WFC_Context_Initialize(WFC_CONTEXT* context,
     context->screenNumber = screenNumber;
     context->activationState = WFC_CONTEXT_STATE_PASSIVE;
     context->sourceUpdateCount = 0;
+    OWF_Array_Initialize(&context->visibilityOrder);
+    /* nothing has been composed into the internal target yet */
+    context->pendingDamage.full = OWF_TRUE;
+    context->pendingDamage.count = 0;
+    context->damageHistoryLength = 0;
     ++nextContextHandle;
 
     for (ii = 0; ii < SCRATCH_BUFFER_COUNT; ii++) {
@@ -539,6 +540,189 @@ OWF_API_CALL WFC_ELEMENT* WFC_Context_FindElement(WFC_CONTEXT* context,
     return WFC_Scene_FindElement(context->workScene, element);
 }
 
+/*! Grow rect to the bounds of rect and other */
+static void WFC_Context_UniteRects(OWF_RECTANGLE* rect,
+                                   OWF_RECTANGLE const* other) {
+    OWFint left = MIN(rect->x, other->x);
+    OWFint top = MIN(rect->y, other->y);
+    OWFint right = MAX(rect->x + rect->width, other->x + other->width);
+    OWFint bottom = MAX(rect->y + rect->height, other->y + other->height);
+
+    OWF_Rect_Set(rect, left, top, right - left, bottom - top);
+}
+
+/*! Add a rectangle to a damage region, keeping the region's rectangles
+    disjoint: the ones it overlaps are merged into it. When the region has
+    no room left, it is merged with the rectangle whose bounds grow least. */
+static void WFC_Context_AddDamage(WFC_DAMAGE* damage,
+                                  OWF_RECTANGLE const* rect) {
+    OWF_RECTANGLE merged, overlap;
+    OWFint i, best;
+
+    if (damage->full || rect->width <= 0 || rect->height <= 0) {
+        return;
+    }
+
+    merged = *rect;
+    for (;;) {
+        for (i = 0; i < damage->count;) {
+            if (OWF_Rect_Clip(&overlap, &merged, &damage->rects[i])) {
+                WFC_Context_UniteRects(&merged, &damage->rects[i]);
+                damage->rects[i] = damage->rects[--damage->count];
+                i = 0;
+            } else {
+                i++;
+            }
+        }
+
+        if (damage->count < WFC_MAX_DAMAGE_RECTS) {
+            break;
+        }
+
+        best = 0;
+        for (i = 1; i < damage->count; i++) {
+            OWF_RECTANGLE a = merged, b = merged;
+
+            WFC_Context_UniteRects(&a, &damage->rects[i]);
+            WFC_Context_UniteRects(&b, &damage->rects[best]);
+            if ((OWFfloat)a.width * a.height <
+                (OWFfloat)b.width * b.height) {
+                best = i;
+            }
+        }
+        WFC_Context_UniteRects(&merged, &damage->rects[best]);
+        damage->rects[best] = damage->rects[--damage->count];
+    }
+
+    damage->rects[damage->count++] = merged;
+}
+
+/*! Internal target extent, which follows the context rotation */
+static void WFC_Context_GetInternalBounds(WFC_CONTEXT* context,
+                                          OWF_RECTANGLE* bounds) {
+    if ((context->rotation == WFC_ROTATION_90) ||
+        (context->rotation == WFC_ROTATION_270)) {
+        OWF_Rect_Set(bounds, 0, 0, context->targetHeight,
+                     context->targetWidth);
+    } else {
+        OWF_Rect_Set(bounds, 0, 0, context->targetWidth,
+                     context->targetHeight);
+    }
+}
+
+/*! Mark the element's destination rectangle for redrawing. It is clipped
+    to a square holding the target in either orientation, as the rotation
+    the next composition uses is not known yet. */
+static void WFC_Context_DamageElement(WFC_CONTEXT* context,
+                                      WFC_ELEMENT* element) {
+    OWF_RECTANGLE rect, bounds, clipped;
+    OWFint size = MAX(context->targetWidth, context->targetHeight);
+
+    OWF_Rect_Set(&bounds, 0, 0, size, size);
+    OWF_Rect_Set(&rect, element->dstRect[0], element->dstRect[1],
+                 element->dstRect[2], element->dstRect[3]);
+    if (OWF_Rect_Clip(&clipped, &rect, &bounds)) {
+        WFC_Context_AddDamage(&context->pendingDamage, &clipped);
+    }
+}
+
+/*! Whether any attribute that affects the element's pixels differs */
+static WFCboolean WFC_Context_ElementChanged(WFC_ELEMENT* before,
+                                             WFC_ELEMENT* after) {
+    OWFint i;
+
+    for (i = 0; i < 4; i++) {
+        if (before->srcRect[i] != after->srcRect[i] ||
+            before->dstRect[i] != after->dstRect[i]) {
+            return WFC_TRUE;
+        }
+    }
+
+    return (before->sourceFlip != after->sourceFlip ||
+            before->sourceRotation != after->sourceRotation ||
+            before->sourceScaleFilter != after->sourceScaleFilter ||
+            before->transparencyTypes != after->transparencyTypes ||
+            before->globalAlpha != after->globalAlpha ||
+            before->sourceHandle != after->sourceHandle ||
+            before->maskHandle != after->maskHandle)
+               ? WFC_TRUE
+               : WFC_FALSE;
+}
+
+/*! First node from node on whose element is also in other scene */
+static OWF_NODE* WFC_Context_NextSharedNode(OWF_NODE* node,
+                                            WFC_SCENE* other) {
+    while (node &&
+           !WFC_Scene_FindElement(other, ELEMENT(node->data)->handle)) {
+        node = node->next;
+    }
+    return node;
+}
+
+/*!---------------------------------------------------------------------------
+ * \brief Damage caused by a commit.
+ *  Removed and added elements damage their destination rectangle, changed
+ *  ones both the old and the new one. Elements carry the serials of their
+ *  composed content over, so an unchanged source is not redrawn.
+ *  \param context Context
+ *  \param before Scene committed so far
+ *  \param after Scene being committed
+ *----------------------------------------------------------------------------*/
+static void WFC_Context_CommitDamage(WFC_CONTEXT* context, WFC_SCENE* before,
+                                     WFC_SCENE* after) {
+    OWF_NODE* node = NULL;
+    OWF_NODE* other = NULL;
+
+    for (node = before->elements; NULL != node; node = node->next) {
+        WFC_ELEMENT* element = ELEMENT(node->data);
+
+        if (!WFC_Scene_FindElement(after, element->handle)) {
+            WFC_Context_DamageElement(context, element);
+        }
+    }
+
+    for (node = after->elements; NULL != node; node = node->next) {
+        WFC_ELEMENT* element = ELEMENT(node->data);
+        WFC_ELEMENT* previous;
+
+        previous = WFC_Scene_FindElement(before, element->handle);
+        if (!previous) {
+            WFC_Context_DamageElement(context, element);
+            continue;
+        }
+
+        if (WFC_Context_ElementChanged(previous, element)) {
+            WFC_Context_DamageElement(context, previous);
+            WFC_Context_DamageElement(context, element);
+        }
+        if (previous->sourceHandle == element->sourceHandle) {
+            element->sourceSerial = previous->sourceSerial;
+        }
+        if (previous->maskHandle == element->maskHandle) {
+            element->maskSerial = previous->maskSerial;
+        }
+    }
+
+    /* restacking: of two elements that swapped order, at least one has
+       left its place among the elements kept from the previous scene */
+    node = before->elements;
+    other = after->elements;
+    for (;;) {
+        node = WFC_Context_NextSharedNode(node, after);
+        other = WFC_Context_NextSharedNode(other, before);
+        if (!node || !other) {
+            break;
+        }
+
+        if (ELEMENT(node->data)->handle != ELEMENT(other->data)->handle) {
+            WFC_Context_DamageElement(context, ELEMENT(node->data));
+            WFC_Context_DamageElement(context, ELEMENT(other->data));
+        }
+        node = node->next;
+        other = other->next;
+    }
+}
+
 /*---------------------------------------------------------------------------
  *  Commit context scene graph changes
  *
@@ -563,6 +747,8 @@ static void WFC_Context_DoCommit(WFC_CONTEXT* context) {
     /* resolve sources and masks */
     DPRINT(("COMMIT: Committing scene changes"));
     WFC_Scene_Commit(context->snapshotScene);
+    WFC_Context_CommitDamage(context, context->committedScene,
+                             context->snapshotScene);
     DPRINT(("COMMIT: Destroying old committed scene"));
     WFC_Scene_Destroy(context->committedScene);
     DPRINT(("COMMIT: Setting new snapshot scene as committed one."));
@@ -679,11 +865,183 @@ static void WFC_Context_UnlockTarget(WFC_CONTEXT* context) {
             frontBuffer));
 }
 
+/*!---------------------------------------------------------------------------
+ * \brief Work out what the composition has to redraw.
+ *  That is what has been committed since the previous composition, plus
+ *  the elements whose source or mask buffer has been written to since it
+ *  was composed. A change of rotation or background color, or of the
+ *  internal target's layout, redraws everything.
+ *  Sources and masks must be locked.
+ *  \param context Context
+ *----------------------------------------------------------------------------*/
+static void WFC_Context_CollectDamage(WFC_CONTEXT* context) {
+    WFC_DAMAGE* pending = &context->pendingDamage;
+    WFC_DAMAGE* damage = &context->frameDamage;
+    OWF_RECTANGLE bounds, rect;
+    OWF_NODE* node = NULL;
+    OWFint i;
+
+    if (context->rotation != context->composedRotation ||
+        context->backgroundColor != context->composedBackgroundColor) {
+        pending->full = OWF_TRUE;
+    }
+    context->composedRotation = context->rotation;
+    context->composedBackgroundColor = context->backgroundColor;
+
+    for (node = context->committedScene->elements; NULL != node;
+         node = node->next) {
+        WFC_ELEMENT* element = ELEMENT(node->data);
+        OWFuint32 sourceSerial, maskSerial = 0;
+
+        if (element->skipCompose) {
+            continue;
+        }
+
+        sourceSerial = WFC_ImageProvider_GetSerial(element->source);
+        if (element->maskComposed) {
+            maskSerial = WFC_ImageProvider_GetSerial(element->mask);
+        }
+
+        if (sourceSerial != element->sourceSerial ||
+            maskSerial != element->maskSerial) {
+            WFC_Context_DamageElement(context, element);
+            element->sourceSerial = sourceSerial;
+            element->maskSerial = maskSerial;
+        }
+    }
+
+    WFC_Context_GetInternalBounds(context, &bounds);
+    damage->full = pending->full;
+    damage->count = 0;
+    if (damage->full) {
+        damage->rects[damage->count++] = bounds;
+    } else {
+        /* pending rectangles are disjoint already */
+        for (i = 0; i < pending->count; i++) {
+            if (OWF_Rect_Clip(&rect, &pending->rects[i], &bounds)) {
+                damage->rects[damage->count++] = rect;
+            }
+        }
+    }
+
+    pending->full = OWF_FALSE;
+    pending->count = 0;
+}
+
+/* height of the bands of the target a worker clears, blends and converts
+   at a time. Bands rather than square tiles keep every row span the same
+   as when the whole target is processed at once. */
+#ifndef WFC_TILE_HEIGHT
+#define WFC_TILE_HEIGHT 64
+#endif
+
+/*! A pass over the target split into bands processed by the workers */
+typedef struct {
+    WFC_CONTEXT* context;
+    /*! image the bands divide */
+    OWF_IMAGE* image;
+    OWFint bandHeight;
+    /*! premultiplied background colour, for clearing */
+    OWFsubpixel red, green, blue, alpha;
+    /*! element states composed, for blending */
+    OWFint count;
+    /*! image converted to and the part of it to convert, NULL for all */
+    OWF_IMAGE* target;
+    WFC_DAMAGE* damage;
+} WFC_TILE_JOB;
+
+/*! Split an image into bands; one band covers it all if there are no
+    other workers to share them with. Returns the number of bands. */
+static OWFint WFC_Context_SetupTiles(WFC_CONTEXT* context, WFC_TILE_JOB* job,
+                                     OWF_IMAGE* image) {
+    job->context = context;
+    job->image = image;
+    job->bandHeight = image->height;
+    if (OWF_WorkerPool_GetWorkerCount(context->workers) > 1) {
+        job->bandHeight = WFC_TILE_HEIGHT;
+    }
+    if (job->bandHeight <= 0) {
+        return 0;
+    }
+    return (image->height + job->bandHeight - 1) / job->bandHeight;
+}
+
+static void WFC_Context_GetTile(WFC_TILE_JOB* job, OWFint item,
+                                OWF_RECTANGLE* tile) {
+    OWFint y = item * job->bandHeight;
+
+    OWF_Rect_Set(tile, 0, y, job->image->width,
+                 MIN(job->bandHeight, job->image->height - y));
+}
+
+/*! Worker job: clear the frame's damage inside one band */
+static void WFC_Context_ClearTile(void* data, OWFint item, OWFint worker) {
+    WFC_TILE_JOB* job = (WFC_TILE_JOB*)data;
+    WFC_DAMAGE* damage = &job->context->frameDamage;
+    OWF_IMAGE target;
+    OWF_RECTANGLE tile, rect;
+    OWFint i;
+
+    worker = worker;
+
+    /* clearing updates the image's format flags; keep that to a copy
+       of the header shared by no other band */
+    target = *job->image;
+    WFC_Context_GetTile(job, item, &tile);
+    for (i = 0; i < damage->count; i++) {
+        if (OWF_Rect_Clip(&rect, &damage->rects[i], &tile)) {
+            OWF_Image_ClearRect(&target, &rect, job->red, job->green,
+                                job->blue, job->alpha);
+        }
+    }
+}
+
+/*! Worker job: blend the elements of a batch into one band, bottom to
+    top */
+static void WFC_Context_BlendTile(void* data, OWFint item, OWFint worker) {
+    WFC_TILE_JOB* job = (WFC_TILE_JOB*)data;
+    OWF_RECTANGLE tile;
+    OWFint i;
+
+    worker = worker;
+
+    WFC_Context_GetTile(job, item, &tile);
+    for (i = 0; i < job->count; i++) {
+        WFC_Pipeline_ExecuteBlendingStage(
+            job->context, &job->context->elementStates[i], &tile);
+    }
+}
+
+/*! Worker job: convert the out of date part of one band to the target
+    format */
+static void WFC_Context_ConvertTile(void* data, OWFint item, OWFint worker) {
+    WFC_TILE_JOB* job = (WFC_TILE_JOB*)data;
+    OWF_RECTANGLE tile, rect;
+    OWFint i;
+
+    worker = worker;
+
+    WFC_Context_GetTile(job, item, &tile);
+    if (NULL == job->damage || job->damage->full) {
+        OWF_Image_DestinationFormatConversionRect(job->target, job->image,
+                                                  &tile);
+        return;
+    }
+    for (i = 0; i < job->damage->count; i++) {
+        if (OWF_Rect_Clip(&rect, &job->damage->rects[i], &tile)) {
+            OWF_Image_DestinationFormatConversionRect(job->target, job->image,
+                                                      &rect);
+        }
+    }
+}
+
 /*---------------------------------------------------------------------------
  *
  *----------------------------------------------------------------------------*/
 static void WFC_Context_PrepareComposition(WFC_CONTEXT* context) {
     OWFsubpixel r, g, b, a;
+    WFC_TILE_JOB job;
+    OWFint tiles;
 
     OWF_ASSERT(context);
 
@@ -695,8 +1053,13 @@ static void WFC_Context_PrepareComposition(WFC_CONTEXT* context) {
         OWF_ASSERT(!"Couldn't lock");
     }
 
+    WFC_Scene_LockSourcesAndMasks(context->committedScene);
+
+    WFC_Context_CollectDamage(context);
+
     /* prepare for composition by "clearing the table" with
-       background color.  */
+       background color. the internal target keeps the previous
+       frame outside the damage. */
 
     r = (OWFsubpixel)OWF_RED_MAX_VALUE *
         ((context->backgroundColor >> 24) & 0xFF) / OWF_BYTE_MAX_VALUE;
@@ -707,13 +1070,66 @@ static void WFC_Context_PrepareComposition(WFC_CONTEXT* context) {
     a = (OWFsubpixel)OWF_ALPHA_MAX_VALUE * (context->backgroundColor & 0xFF) /
         OWF_BYTE_MAX_VALUE;
 
-    r = r * a / OWF_ALPHA_MAX_VALUE;
-    g = g * a / OWF_ALPHA_MAX_VALUE;
-    b = b * a / OWF_ALPHA_MAX_VALUE;
+    r = (r * a + OWF_PREMUL_ROUNDING_FACTOR) / OWF_ALPHA_MAX_VALUE;
+    g = (g * a + OWF_PREMUL_ROUNDING_FACTOR) / OWF_ALPHA_MAX_VALUE;
+    b = (b * a + OWF_PREMUL_ROUNDING_FACTOR) / OWF_ALPHA_MAX_VALUE;
+
+    tiles = WFC_Context_SetupTiles(context, &job,
+                                   context->state.internalTargetImage);
+    job.red = r;
+    job.green = g;
+    job.blue = b;
+    job.alpha = a;
+    OWF_WorkerPool_Run(context->workers, tiles, WFC_Context_ClearTile, &job);
+}
+
+/*! Work out the part of the target buffer being written that is out of
+    date: the frame's damage plus that of the frames composed since the
+    buffer was last written to. Buffers not written to in the remembered
+    frames are rewritten entirely. */
+static void WFC_Context_GetTargetDamage(WFC_CONTEXT* context,
+                                        WFC_DAMAGE* damage) {
+    OWFint age, i, j;
 
-    OWF_Image_Clear(context->state.internalTargetImage, r, g, b, a);
+    *damage = context->frameDamage;
 
-    WFC_Scene_LockSourcesAndMasks(context->committedScene);
+    for (age = 0; age < context->damageHistoryLength; age++) {
+        if (context->damageBuffers[age] == context->state.targetBuffer) {
+            break;
+        }
+    }
+
+    if (age == context->damageHistoryLength) {
+        damage->full = OWF_TRUE;
+        return;
+    }
+
+    for (i = 0; i < age; i++) {
+        WFC_DAMAGE* older = &context->damageHistory[i];
+
+        if (older->full) {
+            damage->full = OWF_TRUE;
+            break;
+        }
+        for (j = 0; j < older->count; j++) {
+            WFC_Context_AddDamage(damage, &older->rects[j]);
+        }
+    }
+}
+
+/*! Remember the frame's damage and the target buffer it went to */
+static void WFC_Context_RecordDamage(WFC_CONTEXT* context) {
+    OWFint i;
+
+    if (context->damageHistoryLength < WFC_DAMAGE_HISTORY) {
+        ++context->damageHistoryLength;
+    }
+    for (i = context->damageHistoryLength - 1; i > 0; i--) {
+        context->damageHistory[i] = context->damageHistory[i - 1];
+        context->damageBuffers[i] = context->damageBuffers[i - 1];
+    }
+    context->damageHistory[0] = context->frameDamage;
+    context->damageBuffers[0] = context->state.targetBuffer;
 }
 
 /*---------------------------------------------------------------------------
@@ -723,6 +1139,9 @@ static void WFC_Context_FinishComposition(WFC_CONTEXT* context) {
     OWF_ROTATION rotation = OWF_ROTATION_0;
     OWFint screenNumber;
     OWFboolean screenRotation;
+    WFC_DAMAGE damage;
+    WFC_TILE_JOB job;
+    OWFint tiles;
 
     OWF_ASSERT(context);
 
@@ -738,8 +1157,13 @@ static void WFC_Context_FinishComposition(WFC_CONTEXT* context) {
                 owfSetStreamFlipState(context->stream, OWF_FALSE);
             }
         }
-        OWF_Image_DestinationFormatConversion(
-            context->state.targetImage, context->state.internalTargetImage);
+        WFC_Context_GetTargetDamage(context, &damage);
+        tiles = WFC_Context_SetupTiles(context, &job,
+                                       context->state.internalTargetImage);
+        job.target = context->state.targetImage;
+        job.damage = &damage;
+        OWF_WorkerPool_Run(context->workers, tiles, WFC_Context_ConvertTile,
+                           &job);
     } else {
         switch (context->rotation) {
             case WFC_ROTATION_0: {
@@ -769,13 +1193,285 @@ static void WFC_Context_FinishComposition(WFC_CONTEXT* context) {
 
         /* Note: support of different target formats  can be put here */
 
-        OWF_Image_DestinationFormatConversion(
-            context->state.targetImage, context->state.rotatedTargetImage);
+        tiles = WFC_Context_SetupTiles(context, &job,
+                                       context->state.rotatedTargetImage);
+        job.target = context->state.targetImage;
+        job.damage = NULL;
+        OWF_WorkerPool_Run(context->workers, tiles, WFC_Context_ConvertTile,
+                           &job);
     }
+    WFC_Context_RecordDamage(context);
     WFC_Context_UnlockTarget(context);
     WFC_Scene_UnlockSourcesAndMasks(context->committedScene);
 }
 
+/* bounds on the work done by the visibility pass; exceeding them only
+   makes it cull less */
+#define WFC_MAX_OCCLUDERS 16
+#define WFC_MAX_VISIBLE_PIECES 16
+
+/*! An element fully replaces the target pixels under it unless global
+    alpha, source alpha or a mask let lower elements show through */
+static WFCboolean WFC_Context_ElementIsOpaque(WFC_ELEMENT* element) {
+    WFCbitfield transparency = element->transparencyTypes;
+
+    if ((transparency & WFC_TRANSPARENCY_ELEMENT_GLOBAL_ALPHA) &&
+        (OWFsubpixel)(element->globalAlpha + OWF_CONVERSION_ROUNDING_VALUE) <
+            OWF_FULLY_OPAQUE) {
+        return WFC_FALSE;
+    }
+
+    if ((transparency & WFC_TRANSPARENCY_SOURCE) &&
+        !element->source->lockedStream.image->format.opaque) {
+        return WFC_FALSE;
+    }
+
+    if ((transparency & WFC_TRANSPARENCY_MASK) && element->maskComposed) {
+        return WFC_FALSE;
+    }
+
+    return WFC_TRUE;
+}
+
+/*! Remove the occluders from rect. Returns WFC_FALSE if nothing is left,
+    otherwise shrinks rect to the bounds of what remains. Pieces that would
+    overflow the work list are kept whole, which only makes the result
+    larger than necessary. */
+static WFCboolean WFC_Context_SubtractOccluders(OWF_RECTANGLE* rect,
+                                                OWF_RECTANGLE* occluders,
+                                                OWFint occluderCount) {
+    OWF_RECTANGLE pieces[2][WFC_MAX_VISIBLE_PIECES];
+    OWFint count = 1, current = 0, i, j;
+
+    pieces[0][0] = *rect;
+
+    for (i = 0; i < occluderCount && count > 0; i++) {
+        OWF_RECTANGLE* in = pieces[current];
+        OWF_RECTANGLE* out = pieces[current ^ 1];
+        OWFint outCount = 0;
+
+        for (j = 0; j < count; j++) {
+            OWF_RECTANGLE hole, piece = in[j];
+            OWFint bottom, right;
+
+            if (!OWF_Rect_Clip(&hole, &piece, &occluders[i])) {
+                out[outCount++] = piece;
+                continue;
+            }
+
+            /* up to four pieces remain: full-width bands above and below
+               the hole, and the parts left and right of it */
+            if (outCount + 4 + (count - j - 1) > WFC_MAX_VISIBLE_PIECES) {
+                out[outCount++] = piece;
+                continue;
+            }
+
+            bottom = hole.y + hole.height;
+            right = hole.x + hole.width;
+
+            if (hole.y > piece.y) {
+                OWF_Rect_Set(&out[outCount++], piece.x, piece.y, piece.width,
+                             hole.y - piece.y);
+            }
+            if (bottom < piece.y + piece.height) {
+                OWF_Rect_Set(&out[outCount++], piece.x, bottom, piece.width,
+                             piece.y + piece.height - bottom);
+            }
+            if (hole.x > piece.x) {
+                OWF_Rect_Set(&out[outCount++], piece.x, hole.y,
+                             hole.x - piece.x, hole.height);
+            }
+            if (right < piece.x + piece.width) {
+                OWF_Rect_Set(&out[outCount++], right, hole.y,
+                             piece.x + piece.width - right, hole.height);
+            }
+        }
+
+        count = outCount;
+        current ^= 1;
+    }
+
+    if (count == 0) {
+        return WFC_FALSE;
+    }
+
+    {
+        OWFint left = pieces[current][0].x;
+        OWFint top = pieces[current][0].y;
+        OWFint right = left + pieces[current][0].width;
+        OWFint bottom = top + pieces[current][0].height;
+
+        for (j = 1; j < count; j++) {
+            OWF_RECTANGLE* piece = &pieces[current][j];
+
+            left = MIN(left, piece->x);
+            top = MIN(top, piece->y);
+            right = MAX(right, piece->x + piece->width);
+            bottom = MAX(bottom, piece->y + piece->height);
+        }
+        OWF_Rect_Set(rect, left, top, right - left, bottom - top);
+    }
+
+    return WFC_TRUE;
+}
+
+/*!---------------------------------------------------------------------------
+ * \brief Front-to-back visibility pass.
+ *  Walks the scene from the top element down, collecting the destination
+ *  rectangles of opaque elements. Elements entirely covered by them are
+ *  marked occluded; the others get the bounds of their uncovered part as
+ *  visible rectangle, which is all the pipeline writes for them.
+ *  An occluder must be composed for sure: elements outside the target
+ *  never become one, and WFC_Context_DoCompose falls back to the first
+ *  element state when another cannot set an element up.
+ *  \param context Context
+ *  \param scene Scene to be composed
+ *----------------------------------------------------------------------------*/
+static void WFC_Context_ComputeVisibility(WFC_CONTEXT* context,
+                                          WFC_SCENE* scene) {
+    OWF_RECTANGLE occluders[WFC_MAX_OCCLUDERS];
+    OWF_RECTANGLE bounds;
+    OWFint occluderCount = 0, i;
+    OWF_NODE* node = NULL;
+    OWFboolean ordered = OWF_TRUE;
+
+    WFC_Context_GetInternalBounds(context, &bounds);
+
+    OWF_Array_Reset(&context->visibilityOrder);
+    for (node = scene->elements; NULL != node; node = node->next) {
+        WFC_ELEMENT* element = ELEMENT(node->data);
+
+        element->occluded = WFC_FALSE;
+        OWF_Rect_Set(&element->visibleRect, element->dstRect[0],
+                     element->dstRect[1], element->dstRect[2],
+                     element->dstRect[3]);
+
+        if (ordered) {
+            ordered = OWF_Array_AppendItem(&context->visibilityOrder, element);
+        }
+    }
+
+    /* out of memory: compose everything */
+    if (!ordered) {
+        return;
+    }
+
+    for (i = context->visibilityOrder.length - 1; i >= 0; i--) {
+        WFC_ELEMENT* element =
+            ELEMENT(OWF_Array_GetItemAt(&context->visibilityOrder, i));
+        OWF_RECTANGLE rect, visible;
+
+        if (element->skipCompose ||
+            !OWF_Rect_Clip(&rect, &element->visibleRect, &bounds)) {
+            continue;
+        }
+
+        visible = rect;
+        if (!WFC_Context_SubtractOccluders(&visible, occluders,
+                                           occluderCount)) {
+            DPRINT(("  Element %d is occluded", element->handle));
+            element->occluded = WFC_TRUE;
+            continue;
+        }
+        element->visibleRect = visible;
+
+        if (occluderCount < WFC_MAX_OCCLUDERS &&
+            WFC_Context_ElementIsOpaque(element)) {
+            occluders[occluderCount++] = rect;
+        }
+    }
+}
+
+/*! Whether rect meets the frame's damage */
+static WFCboolean WFC_Context_IsDamaged(WFC_CONTEXT* context,
+                                        OWF_RECTANGLE* rect) {
+    OWF_RECTANGLE overlap;
+    OWFint i;
+
+    for (i = 0; i < context->frameDamage.count; i++) {
+        if (OWF_Rect_Clip(&overlap, rect, &context->frameDamage.rects[i])) {
+            return WFC_TRUE;
+        }
+    }
+    return WFC_FALSE;
+}
+
+/*! Worker job: source conversion and transform of one element of a
+    batch. Directly copied elements have neither; the blending pass
+    converts them straight into the target. */
+static void WFC_Context_PreprocessElement(void* data, OWFint item,
+                                          OWFint worker) {
+    WFC_CONTEXT* context = (WFC_CONTEXT*)data;
+    WFC_ELEMENT_STATE* state = &context->elementStates[item];
+    OWFuint64 t0, t1, t2;
+
+    worker = worker;
+
+    if (state->directCopy) {
+        state->conversionTime = 0;
+        state->transformTime = 0;
+        return;
+    }
+
+    t0 = OWF_Thread_GetNanoTime();
+    WFC_Pipeline_ExecuteSourceConversionStage(context, state);
+    t1 = OWF_Thread_GetNanoTime();
+    WFC_Pipeline_ExecuteTransformStage(context, state);
+    t2 = OWF_Thread_GetNanoTime();
+
+    state->conversionTime = t1 - t0;
+    state->transformTime = t2 - t1;
+}
+
+/*!---------------------------------------------------------------------------
+ * \brief Compose a batch of elements whose composition has begun
+ *
+ * The elements are preprocessed concurrently, one per worker. Then the
+ * workers blend them into separate bands of the target, each band
+ * bottom to top.
+ *
+ * \param context Context
+ * \param batch Elements, bottom to top; element i uses element state i
+ * \param count Number of elements
+ *----------------------------------------------------------------------------*/
+static void WFC_Context_ComposeBatch(WFC_CONTEXT* context,
+                                     WFC_ELEMENT** batch, OWFint count) {
+    WFC_PIPELINE_STATS* stats = &context->stats;
+    OWFuint64 t0, t1, conversion = 0, transform = 0;
+    WFC_TILE_JOB job;
+    OWFint tiles, i;
+
+    t0 = OWF_Thread_GetNanoTime();
+    OWF_WorkerPool_Run(context->workers, count, WFC_Context_PreprocessElement,
+                       context);
+    t1 = OWF_Thread_GetNanoTime();
+
+    /* the stages overlap on the workers; split the time they took
+       together by their share of the work */
+    for (i = 0; i < count; i++) {
+        conversion += context->elementStates[i].conversionTime;
+        transform += context->elementStates[i].transformTime;
+    }
+    if (conversion + transform > 0) {
+        conversion = (t1 - t0) * conversion / (conversion + transform);
+    }
+    stats->stageTime[WFC_STAGE_SOURCE_CONVERSION] += conversion;
+    stats->stageTime[WFC_STAGE_TRANSFORM] += (t1 - t0) - conversion;
+
+    tiles = WFC_Context_SetupTiles(context, &job,
+                                   context->state.internalTargetImage);
+    job.count = count;
+    OWF_WorkerPool_Run(context->workers, tiles, WFC_Context_BlendTile, &job);
+
+    for (i = 0; i < count; i++) {
+        WFC_Pipeline_EndComposition(context, batch[i],
+                                    &context->elementStates[i]);
+        ++stats->elements;
+    }
+    t0 = OWF_Thread_GetNanoTime();
+    stats->stageTime[WFC_STAGE_BLENDING] += t0 - t1;
+}
+
 /*!---------------------------------------------------------------------------
  * \brief Actual composition routine.
  *  Mainly just calls other functions that executes different stages of
@@ -785,14 +1481,22 @@ static void WFC_Context_FinishComposition(WFC_CONTEXT* context) {
 static void WFC_Context_DoCompose(WFC_CONTEXT* context) {
     WFC_SCENE* scene = NULL;
     OWF_NODE* node = NULL;
+    WFC_PIPELINE_STATS* stats = NULL;
+    WFC_ELEMENT* batch[WFC_MAX_WORKERS];
+    OWFint batchSize = 0;
+    OWFuint64 t0 = 0, t1 = 0;
 
     OWF_ASSERT(context);
 
+    stats = &context->stats;
+
     OWF_Mutex_Lock(&context->updateFlagMutex);
     context->sourceUpdateCount = 0;
     OWF_Mutex_Unlock(&context->updateFlagMutex);
 
+    t0 = OWF_Thread_GetNanoTime();
     WFC_Context_PrepareComposition(context);
+    t1 = OWF_Thread_GetNanoTime();
 
     DPRINT(("WFC_Context_Compose"));
     /* Composition always uses the committed version
@@ -801,12 +1505,15 @@ static void WFC_Context_DoCompose(WFC_CONTEXT* context) {
 
     OWF_Mutex_Lock(&context->sceneMutex);
 
+    stats->stageTime[WFC_STAGE_PREPARE] += t1 - t0;
+
+    WFC_Context_ComputeVisibility(context, context->committedScene);
+
     scene = context->committedScene;
     OWF_ASSERT(scene);
 
     for (node = scene->elements; NULL != node; node = node->next) {
         WFC_ELEMENT* element = NULL;
-        WFC_ELEMENT_STATE* elementState = NULL;
         element = ELEMENT(node->data);
 
         if (element->skipCompose) {
@@ -816,26 +1523,62 @@ static void WFC_Context_DoCompose(WFC_CONTEXT* context) {
             continue;
         }
 
+        if (element->occluded) {
+            /* opaque elements above cover all of it */
+            continue;
+        }
+
+        if (!WFC_Context_IsDamaged(context, &element->visibleRect)) {
+            /* the previous frame is still valid where it shows */
+            continue;
+        }
+
         DPRINT(("  Composing element %d", element->handle));
 
         /* BeginComposition may fail e.g. if the element's destination
          * rectangle is something bizarre, i.e. causes overflows or
          * something.
          */
-        if ((elementState = WFC_Pipeline_BeginComposition(context, element)) !=
+        t0 = OWF_Thread_GetNanoTime();
+        if (WFC_Pipeline_BeginComposition(
+                context, element, &context->elementStates[batchSize]) !=
             NULL) {
-            WFC_Pipeline_ExecuteSourceConversionStage(context, elementState);
-            WFC_Pipeline_ExecuteCropStage(context, elementState);
-            WFC_Pipeline_ExecuteFlipStage(context, elementState);
-            WFC_Pipeline_ExecuteRotationStage(context, elementState);
-            WFC_Pipeline_ExecuteScalingStage(context, elementState);
-            WFC_Pipeline_ExecuteBlendingStage(context, elementState);
-
-            WFC_Pipeline_EndComposition(context, element, elementState);
+            batch[batchSize++] = element;
+        } else if (batchSize > 0) {
+            /* the state may have run out of memory for its images. The
+             * element may already hide others as an occluder, so it must
+             * not be dropped: compose the batch so far and retry on the
+             * first state, which works in the preallocated scratch
+             * buffers */
+            t1 = OWF_Thread_GetNanoTime();
+            stats->stageTime[WFC_STAGE_BEGIN] += t1 - t0;
+            WFC_Context_ComposeBatch(context, batch, batchSize);
+            batchSize = 0;
+
+            t0 = OWF_Thread_GetNanoTime();
+            if (WFC_Pipeline_BeginComposition(
+                    context, element, &context->elementStates[0]) != NULL) {
+                batch[batchSize++] = element;
+            }
+        }
+        t1 = OWF_Thread_GetNanoTime();
+        stats->stageTime[WFC_STAGE_BEGIN] += t1 - t0;
+
+        if (batchSize == context->elementStateCount) {
+            WFC_Context_ComposeBatch(context, batch, batchSize);
+            batchSize = 0;
         }
     }
 
+    if (batchSize > 0) {
+        WFC_Context_ComposeBatch(context, batch, batchSize);
+    }
+
+    t0 = OWF_Thread_GetNanoTime();
     WFC_Context_FinishComposition(context);
+    t1 = OWF_Thread_GetNanoTime();
+    stats->stageTime[WFC_STAGE_FINISH] += t1 - t0;
+    ++stats->frames;
 
     OWF_Mutex_Unlock(&context->sceneMutex);
 
@@ -1418,6 +2161,30 @@ OWF_API_CALL WFCboolean WFC_Context_Active(WFC_CONTEXT* context) {
            WFC_CONTEXT_STATE_ACTIVATING == context->activationState;
 }
 
+/*---------------------------------------------------------------------------
+ *
+ *----------------------------------------------------------------------------*/
+OWF_API_CALL void WFC_Context_GetPipelineStats(WFC_CONTEXT* context,
+                                               WFC_PIPELINE_STATS* stats) {
+    OWF_ASSERT(context);
+    OWF_ASSERT(stats);
+
+    OWF_Mutex_Lock(&context->sceneMutex);
+    *stats = context->stats;
+    OWF_Mutex_Unlock(&context->sceneMutex);
+}
+
+/*---------------------------------------------------------------------------
+ *
+ *----------------------------------------------------------------------------*/
+OWF_API_CALL void WFC_Context_ResetPipelineStats(WFC_CONTEXT* context) {
+    OWF_ASSERT(context);
+
+    OWF_Mutex_Lock(&context->sceneMutex);
+    memset(&context->stats, 0, sizeof(context->stats));
+    OWF_Mutex_Unlock(&context->sceneMutex);
+}
+
 #ifdef __cplusplus
 }
 #endif
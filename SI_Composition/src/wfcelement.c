@@ -82,6 +82,8 @@ void WFC_Element_Initialize(WFC_ELEMENT* element) {
     element->globalAlpha = OWF_ALPHA_MAX_VALUE;
     element->maskHandle = WFC_INVALID_HANDLE;
     element->sourceHandle = WFC_INVALID_HANDLE;
+    element->sourceSerial = 0;
+    element->maskSerial = 0;
 }
 
 /*---------------------------------------------------------------------------
@@ -57,6 +57,9 @@ OWF_API_CALL void WFC_IMAGE_PROVIDER_Ctor(void* self) {
 
     ip->lockedStream.image = NULL;
     ip->lockedStream.lockCount = 0;
+    ip->maskCache.image = NULL;
+    ip->maskCache.pixels = NULL;
+    ip->maskCache.serial = OWF_MASK_SERIAL_NONE;
 
     LEAVE(WFC_IMAGE_PROVIDER_Dtor);
 }
@@ -84,6 +87,7 @@ OWF_API_CALL void WFC_IMAGE_PROVIDER_Dtor(void* self) {
         }
         OWF_Image_Destroy(ip->lockedStream.image);
     }
+    OWF_Image_DestroyMaskCache(&ip->maskCache);
     LEAVE(WFC_IMAGE_PROVIDER_Dtor);
 }
 
@@ -202,6 +206,32 @@ OWF_API_CALL void WFC_ImageProvider_Unlock(WFC_IMAGE_PROVIDER* provider) {
     }
 }
 
+OWF_API_CALL OWF_IMAGE* WFC_ImageProvider_GetMask(
+    WFC_IMAGE_PROVIDER* provider) {
+    if (!provider) {
+        DPRINT(("WFC_ImageProvider_GetMask: provider = NULL"));
+        return NULL;
+    }
+    OWF_ASSERT(provider->lockedStream.lockCount > 0);
+
+    /* the locked buffer is converted again only when it has been
+       committed to since the previous conversion */
+    return OWF_Image_GetCachedMask(&provider->maskCache,
+                                   provider->lockedStream.image,
+                                   WFC_ImageProvider_GetSerial(provider));
+}
+
+/*! Content serial of the locked buffer; it changes whenever the buffer
+    has been written to */
+OWF_API_CALL OWFuint32 WFC_ImageProvider_GetSerial(
+    WFC_IMAGE_PROVIDER* provider) {
+    OWF_ASSERT(provider);
+    OWF_ASSERT(provider->lockedStream.lockCount > 0);
+
+    return owfNativeStreamGetBufferSerial(provider->stream->handle,
+                                          provider->lockedStream.buffer);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -50,6 +50,12 @@
 
 #define EXTRA_PIXEL_BOUNDARY 2
 
+/*! bytes of transformed element sources each context keeps for reuse;
+    zero disables the cache */
+#ifndef WFC_TRANSFORM_CACHE_BUDGET
+#define WFC_TRANSFORM_CACHE_BUDGET (32 * 1024 * 1024)
+#endif
+
 /*!
  *  \brief Check element destination visibility
  *
@@ -92,9 +98,9 @@ static void WFC_Pipeline_BlendInfo(WFC_CONTEXT* context,
 
     /* setup blending parameters */
     state->blendInfo.destination.image = context->state.internalTargetImage;
-    state->blendInfo.destination.rectangle = &state->dstRect;
-    state->blendInfo.source.image = state->scaledSourceImage;
-    state->blendInfo.source.rectangle = &state->scaledSrcRect;
+    state->blendInfo.destination.rectangle = NULL;
+    state->blendInfo.source.image = state->transformedImage;
+    state->blendInfo.source.rectangle = NULL;
     state->blendInfo.mask = state->originalMaskImage ? state->maskImage : NULL;
     state->blendInfo.globalAlpha = state->globalAlpha;
 
@@ -102,11 +108,33 @@ static void WFC_Pipeline_BlendInfo(WFC_CONTEXT* context,
     state->blendInfo.tsColor = NULL;
     state->blendInfo.destinationFullyOpaque = OWF_FALSE;
 
-    DPRINT(("  globalAplha = %f", state->globalAlpha));
+    DPRINT(("  globalAplha = %f", (OWFfloat)state->globalAlpha));
     /* no need to check with OWF_ALPHA_MIN_VALUE as it is zero */
     OWF_ASSERT(state->blendInfo.globalAlpha <= OWF_ALPHA_MAX_VALUE);
 }
 
+/*! Restrict the element's output to the part of its visible rectangle
+    inside one damage rectangle and the region being composed: drawRect
+    in the target, drawSrcRect the same pixels in the scaled source.
+    Returns WFC_FALSE if they do not meet. */
+static WFCboolean WFC_Pipeline_ClipToDamage(WFC_ELEMENT_STATE* state,
+                                            OWF_RECTANGLE* damage,
+                                            OWF_RECTANGLE* region,
+                                            OWF_RECTANGLE* drawRect,
+                                            OWF_RECTANGLE* drawSrcRect) {
+    OWF_RECTANGLE area;
+
+    if (!OWF_Rect_Clip(&area, damage, region) ||
+        !OWF_Rect_Clip(drawRect, &state->visibleRect, &area)) {
+        return WFC_FALSE;
+    }
+
+    OWF_Rect_Set(drawSrcRect, drawRect->x - state->dstRect.x,
+                 drawRect->y - state->dstRect.y, drawRect->width,
+                 drawRect->height);
+    return WFC_TRUE;
+}
+
 /*! Transform the source rectangle to represent the floating point viewport
     as an offset in the final rotation stage image */
 static void WFC_Pipeline_TransformSource(WFC_ELEMENT_STATE* state) {
@@ -213,68 +241,334 @@ static void WFC_Pipeline_OversizedViewport(WFC_ELEMENT_STATE* state) {
         (height - state->oversizedCropRect.y) + EXTRA_PIXEL_BOUNDARY;
 }
 
-/*-----------------------------------------------------------*
- * Initial creation of element state object created just once per context
- *-----------------------------------------------------------*/
-OWF_API_CALL void WFC_Pipeline_DestroyState(WFC_CONTEXT* context) {
-    WFC_ELEMENT_STATE* state;
-    state = &context->prototypeElementState;
-    OWF_Image_Destroy(state->scaledSourceImage);
-    OWF_Image_Destroy(state->croppedSourceImage);
-    OWF_Image_Destroy(state->convertedSourceImage);
-    OWF_Image_Destroy(state->rotatedSourceIntermediateImage);
-    OWF_Image_Destroy(state->flippedSourceImage);
-    OWF_Image_Destroy(state->rotatedSourceImage);
-    OWF_Image_Destroy(state->maskImage);
-    state->scaledSourceImage = NULL;
-    state->croppedSourceImage = NULL;
-    state->convertedSourceImage = NULL;
-    state->rotatedSourceIntermediateImage = NULL;
-    state->flippedSourceImage = NULL;
-    state->rotatedSourceImage = NULL;
-    state->maskImage = NULL;
+/*! Check whether the element can be converted straight into the target:
+    no flip, rotation or scaling, an integer viewport inside the source, and
+    no transparency that would make blending anything but a copy */
+static WFCboolean WFC_Pipeline_IsDirectCopy(WFC_ELEMENT* element,
+                                            WFC_ELEMENT_STATE* state) {
+    OWF_IMAGE* source = state->originalSourceImage;
+    WFCbitfield transparency = state->transparencyTypes;
+
+    if (state->rotation != WFC_ROTATION_0 || state->sourceFlip) {
+        return WFC_FALSE;
+    }
+
+    if (state->sourceRect[0] != floor(state->sourceRect[0]) ||
+        state->sourceRect[1] != floor(state->sourceRect[1]) ||
+        state->sourceRect[2] != state->dstRect.width ||
+        state->sourceRect[3] != state->dstRect.height) {
+        return WFC_FALSE;
+    }
+
+    /* edge replication is never needed */
+    if (state->sourceRect[0] < 0 || state->sourceRect[1] < 0 ||
+        state->sourceRect[0] + state->sourceRect[2] > source->width ||
+        state->sourceRect[1] + state->sourceRect[3] > source->height) {
+        return WFC_FALSE;
+    }
+
+    if ((transparency & WFC_TRANSPARENCY_ELEMENT_GLOBAL_ALPHA) &&
+        state->globalAlpha < OWF_FULLY_OPAQUE) {
+        return WFC_FALSE;
+    }
+
+    if ((transparency & WFC_TRANSPARENCY_SOURCE) && !source->format.opaque) {
+        return WFC_FALSE;
+    }
+
+    if ((transparency & WFC_TRANSPARENCY_MASK) && element->maskComposed) {
+        return WFC_FALSE;
+    }
+
+    return WFC_TRUE;
 }
 
-OWF_API_CALL OWFboolean WFC_Pipeline_CreateState(WFC_CONTEXT* context) {
-    WFC_ELEMENT_STATE* state;
+/*! FNV-1a hash of a transform cache key */
+static OWFuint32 WFC_Pipeline_HashKey(WFC_TRANSFORM_KEY const* key) {
+    const OWFuint8* bytes = (const OWFuint8*)key;
+    OWFuint32 hash = 2166136261u;
+    size_t i;
+
+    for (i = 0; i < sizeof(*key); i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static void WFC_Pipeline_DestroyCacheEntry(WFC_CONTEXT* context,
+                                           WFC_TRANSFORM_CACHE_ENTRY* entry) {
+    if (entry->image) {
+        context->transformCacheSize -= entry->image->dataMax;
+        OWF_Image_Destroy(entry->image);
+    }
+    xfree(entry);
+}
+
+/*! Remove the element's entry from the cache and return it, if any */
+static WFC_TRANSFORM_CACHE_ENTRY* WFC_Pipeline_TakeCacheEntry(
+    WFC_CONTEXT* context, WFCElement element) {
+    OWFint i;
+
+    for (i = 0; i < context->transformCache.length; i++) {
+        WFC_TRANSFORM_CACHE_ENTRY* entry =
+            OWF_Array_GetItemAt(&context->transformCache, i);
+
+        if (entry->element == element) {
+            return OWF_Array_RemoveItemAt(&context->transformCache, i);
+        }
+    }
+    return NULL;
+}
+
+/*!---------------------------------------------------------------------------
+ *  \brief Look the element's transformed source up in the context's cache
+ *
+ *  If the element's entry matches the source buffer and transform
+ *  attributes, it is used as is. Otherwise the entry is (re)claimed,
+ *  evicting the least recently used ones to stay within
+ *  WFC_TRANSFORM_CACHE_BUDGET, and the transform stage renders straight
+ *  into it. Without an entry the scratch image is used.
+ *
+ *  \param context          Context
+ *  \param element          Element
+ *  \param state            Element state, scaled image set up
+ *----------------------------------------------------------------------------*/
+static void WFC_Pipeline_LookupTransform(WFC_CONTEXT* context,
+                                         WFC_ELEMENT* element,
+                                         WFC_ELEMENT_STATE* state) {
+    OWF_IMAGE* scaled = state->scaledSourceImage;
+    WFC_TRANSFORM_CACHE_ENTRY* entry;
+    WFC_TRANSFORM_KEY key;
+    OWFuint32 hash;
+    OWFint size, x;
+
+    state->transformedImage = scaled;
+    state->transformEntry = NULL;
+    state->transformCached = WFC_FALSE;
+
+    /* the scratch image could not take the destination size */
+    if (scaled->width != state->scaledSrcRect.width ||
+        scaled->height != state->scaledSrcRect.height) {
+        return;
+    }
+
+    memset(&key, 0, sizeof(key));
+    key.stream = element->source->stream->handle;
+    key.pixels = state->originalSourceImage->data;
+    key.serial = WFC_ImageProvider_GetSerial(element->source);
+    for (x = 0; x < 4; x++) {
+        key.sourceRect[x] = state->sourceRect[x];
+    }
+    key.width = scaled->width;
+    key.height = scaled->height;
+    key.rotation = state->rotation;
+    key.flip = state->sourceFlip;
+    key.filter = state->sourceScaleFilter;
+    key.premultiplied =
+        (state->transparencyTypes & WFC_TRANSPARENCY_SOURCE) ? WFC_TRUE
+                                                             : WFC_FALSE;
+    hash = WFC_Pipeline_HashKey(&key);
+
+    entry = WFC_Pipeline_TakeCacheEntry(context, element->handle);
+    if (entry && entry->hash == hash &&
+        !memcmp(&entry->key, &key, sizeof(key))) {
+        if (!OWF_Array_InsertItem(&context->transformCache, 0, entry)) {
+            WFC_Pipeline_DestroyCacheEntry(context, entry);
+            return;
+        }
+        DPRINT(("  Reusing transformed source of element %d",
+                element->handle));
+        entry->inUse = WFC_TRUE;
+        state->transformedImage = entry->image;
+        state->transformEntry = entry;
+        state->transformCached = WFC_TRUE;
+        return;
+    }
+
+    size = scaled->stride * scaled->height;
+    if (size > WFC_TRANSFORM_CACHE_BUDGET) {
+        if (entry) {
+            WFC_Pipeline_DestroyCacheEntry(context, entry);
+        }
+        return;
+    }
+
+    if (entry && entry->image && entry->image->dataMax < size) {
+        context->transformCacheSize -= entry->image->dataMax;
+        OWF_Image_Destroy(entry->image);
+        entry->image = NULL;
+    }
+
+    /* entries of the other elements being composed must stay */
+    while (context->transformCache.length > 0 &&
+           context->transformCacheSize +
+                   ((entry && entry->image) ? 0 : size) >
+               WFC_TRANSFORM_CACHE_BUDGET) {
+        WFC_TRANSFORM_CACHE_ENTRY* last = OWF_Array_GetItemAt(
+            &context->transformCache, context->transformCache.length - 1);
+
+        if (last->inUse) {
+            break;
+        }
+        OWF_Array_RemoveItemAt(&context->transformCache,
+                               context->transformCache.length - 1);
+        WFC_Pipeline_DestroyCacheEntry(context, last);
+    }
+
+    if (context->transformCacheSize + ((entry && entry->image) ? 0 : size) >
+        WFC_TRANSFORM_CACHE_BUDGET) {
+        if (entry) {
+            WFC_Pipeline_DestroyCacheEntry(context, entry);
+        }
+        return;
+    }
+
+    if (!entry) {
+        entry = NEW0N(WFC_TRANSFORM_CACHE_ENTRY, 1);
+        if (!entry) {
+            return;
+        }
+        entry->element = element->handle;
+    }
+
+    if (entry->image) {
+        OWF_Image_SetSize(entry->image, scaled->width, scaled->height);
+    } else {
+        entry->image = OWF_Image_Create(scaled->width, scaled->height,
+                                        &scaled->format, NULL, 0);
+        if (!entry->image) {
+            WFC_Pipeline_DestroyCacheEntry(context, entry);
+            return;
+        }
+        context->transformCacheSize += entry->image->dataMax;
+    }
+    OWF_Image_SetFlags(entry->image, scaled->format.premultiplied,
+                       scaled->format.linear);
+
+    entry->key = key;
+    entry->hash = hash;
+    if (!OWF_Array_InsertItem(&context->transformCache, 0, entry)) {
+        WFC_Pipeline_DestroyCacheEntry(context, entry);
+        return;
+    }
+
+    entry->inUse = WFC_TRUE;
+    state->transformedImage = entry->image;
+    state->transformEntry = entry;
+}
+
+/*! Create the intermediate images of the first element state in the
+    context's scratch buffers, which hold the largest source */
+static OWFboolean WFC_Pipeline_CreateImages(WFC_ELEMENT_STATE* state,
+                                            void* croppedBuffer,
+                                            void* scaledBuffer) {
     OWF_IMAGE_FORMAT fmt;
 
     fmt.pixelFormat = OWF_IMAGE_ARGB_INTERNAL;
     fmt.linear = OWF_FALSE;
     fmt.premultiplied = OWF_FALSE;
     fmt.rowPadding = 1;
-    state = &context->prototypeElementState;
     /* All buffers are initially created the full size of the scratch buffers,
      * whicgh records the buffer size in bytes */
-    state->convertedSourceImage =
-        OWF_Image_Create(MAX_SOURCE_WIDTH, MAX_SOURCE_HEIGHT, &fmt,
-                         context->scratchBuffer[1], 0);
-    state->croppedSourceImage =
-        OWF_Image_Create(MAX_SOURCE_WIDTH, MAX_SOURCE_HEIGHT, &fmt,
-                         context->scratchBuffer[2], 0);
-    state->flippedSourceImage =
-        OWF_Image_Create(MAX_SOURCE_WIDTH, MAX_SOURCE_HEIGHT, &fmt,
-                         context->scratchBuffer[2], 0);
-
-    state->rotatedSourceIntermediateImage =
-        OWF_Image_Create(MAX_SOURCE_WIDTH, MAX_SOURCE_HEIGHT, &fmt,
-                         context->scratchBuffer[1], 0);
-    state->rotatedSourceImage =
-        OWF_Image_Create(MAX_SOURCE_WIDTH, MAX_SOURCE_HEIGHT, &fmt,
-                         context->scratchBuffer[2], 0);
-    state->scaledSourceImage =
-        OWF_Image_Create(MAX_SOURCE_WIDTH, MAX_SOURCE_HEIGHT, &fmt,
-                         context->scratchBuffer[3], 0);
-    fmt.pixelFormat = OWF_IMAGE_L32;
-    state->maskImage = OWF_Image_Create(MAX_SOURCE_WIDTH, MAX_SOURCE_HEIGHT,
-                                        &fmt, context->scratchBuffer[4], 0);
-    if (!state->convertedSourceImage || !state->croppedSourceImage ||
-        !state->flippedSourceImage || !state->rotatedSourceIntermediateImage ||
-        !state->rotatedSourceImage || !state->scaledSourceImage ||
-        !state->maskImage) {
+    state->croppedSourceImage = OWF_Image_Create(
+        MAX_SOURCE_WIDTH, MAX_SOURCE_HEIGHT, &fmt, croppedBuffer, 0);
+    state->scaledSourceImage = OWF_Image_Create(
+        MAX_SOURCE_WIDTH, MAX_SOURCE_HEIGHT, &fmt, scaledBuffer, 0);
+    state->maskImage = NULL;
+    if (!state->croppedSourceImage || !state->scaledSourceImage) {
+        OWF_Image_Destroy(state->scaledSourceImage);
+        OWF_Image_Destroy(state->croppedSourceImage);
+        state->scaledSourceImage = NULL;
+        state->croppedSourceImage = NULL;
+        return OWF_FALSE;
+    }
+    return OWF_TRUE;
+}
+
+/*! Make an image of one of the other element states big enough for
+    width x height pixels. Larger sources are cut to the scratch buffer
+    size as on the first state. The image only grows, so after the
+    largest element a state is given it is not reallocated again. */
+static OWFboolean WFC_Pipeline_ReserveImage(OWF_IMAGE** image, OWFint width,
+                                            OWFint height) {
+    OWF_IMAGE_FORMAT fmt;
+    OWF_IMAGE* grown;
+
+    memset(&fmt, 0, sizeof(fmt));
+    fmt.pixelFormat = OWF_IMAGE_ARGB_INTERNAL;
+    fmt.rowPadding = 1;
+
+    if (width > MAX_SOURCE_WIDTH || height > MAX_SOURCE_HEIGHT) {
+        width = MAX_SOURCE_WIDTH;
+        height = MAX_SOURCE_HEIGHT;
+    }
+
+    if (*image && OWF_Image_GetStride(width, &fmt, 0) * height <=
+                      (*image)->dataMax) {
+        return OWF_TRUE;
+    }
+
+    grown = OWF_Image_Create(width, height, &fmt, NULL, 0);
+    if (!grown) {
+        return OWF_FALSE;
+    }
+    OWF_Image_Destroy(*image);
+    *image = grown;
+    return OWF_TRUE;
+}
+
+/*-----------------------------------------------------------*
+ * Initial creation of element state object created just once per context
+ *-----------------------------------------------------------*/
+OWF_API_CALL void WFC_Pipeline_DestroyState(WFC_CONTEXT* context) {
+    WFC_ELEMENT_STATE* state;
+    OWFint i;
+
+    OWF_WorkerPool_Destroy(context->workers);
+    context->workers = NULL;
+
+    while (context->transformCache.length > 0) {
+        WFC_Pipeline_DestroyCacheEntry(
+            context,
+            OWF_Array_RemoveItemAt(&context->transformCache,
+                                   context->transformCache.length - 1));
+    }
+    OWF_Array_Destroy(&context->transformCache);
+
+    for (i = 0; i < WFC_MAX_WORKERS; i++) {
+        state = &context->elementStates[i];
+        OWF_Image_Destroy(state->scaledSourceImage);
+        OWF_Image_Destroy(state->croppedSourceImage);
+        state->scaledSourceImage = NULL;
+        state->croppedSourceImage = NULL;
+        state->maskImage = NULL;
+    }
+}
+
+OWF_API_CALL OWFboolean WFC_Pipeline_CreateState(WFC_CONTEXT* context) {
+    OWFint workers;
+
+    OWF_Array_Initialize(&context->transformCache);
+    context->transformCacheSize = 0;
+
+    /* the other states allocate images as their elements need them */
+    if (!WFC_Pipeline_CreateImages(&context->elementStates[0],
+                                   context->scratchBuffer[2],
+                                   context->scratchBuffer[3])) {
         WFC_Pipeline_DestroyState(context);
         return OWF_FALSE;
     }
+
+    /* one worker per processor; the composer thread is one of them */
+    workers = OWF_Thread_GetProcessorCount();
+    if (workers > WFC_MAX_WORKERS) {
+        workers = WFC_MAX_WORKERS;
+    }
+    context->workers = (workers > 1) ? OWF_WorkerPool_Create(workers) : NULL;
+    context->elementStateCount =
+        OWF_WorkerPool_GetWorkerCount(context->workers);
+    DPRINT(("  Composing with %d workers", context->elementStateCount));
+
     return OWF_TRUE;
 }
 
@@ -283,8 +577,9 @@ OWF_API_CALL OWFboolean WFC_Pipeline_CreateState(WFC_CONTEXT* context) {
  *
  *  \param context          Context
  *  \param element          Element
+ *  \param state            One of the context's element states
  *
- *  \return Boolean value indicating whether preparation succeeded
+ *  \return The element state, or NULL if the element is not composed
  *----------------------------------------------------------------------------*/
 #ifdef DEBUG
 /* reset size to original extent then try to set it to the target size */
@@ -305,19 +600,15 @@ OWF_API_CALL OWFboolean WFC_Pipeline_CreateState(WFC_CONTEXT* context) {
     }
 #endif
 OWF_API_CALL WFC_ELEMENT_STATE* WFC_Pipeline_BeginComposition(
-    WFC_CONTEXT* context, WFC_ELEMENT* element) {
-    WFC_ELEMENT_STATE* state = &context->prototypeElementState;
+    WFC_CONTEXT* context, WFC_ELEMENT* element, WFC_ELEMENT_STATE* state) {
     OWF_IMAGE_FORMAT imgf;
-    OWFint sourceWidth;
-    OWFint sourceHeight;
     OWFint x;
-    OWFint tempWidth, tempHeight;
 
     DPRINT(("WFC_Element_BeginComposition(%x,%x)",
             context ? context->handle : 0, element ? element->handle : 0));
 
-    if (!context || !element) {
-        DPRINT(("  context == NULL || element == NULL"));
+    if (!context || !element || !state) {
+        DPRINT(("  context == NULL || element == NULL || state == NULL"));
         return NULL;
     }
 
@@ -338,7 +629,8 @@ OWF_API_CALL WFC_ELEMENT_STATE* WFC_Pipeline_BeginComposition(
     state->originalSourceImage = element->source->lockedStream.image;
     state->rotation = element->sourceRotation;
     state->sourceFlip = element->sourceFlip;
-    state->globalAlpha = element->globalAlpha;
+    state->globalAlpha =
+        (OWFsubpixel)(element->globalAlpha + OWF_CONVERSION_ROUNDING_VALUE);
     state->sourceScaleFilter = element->sourceScaleFilter;
     state->transparencyTypes = element->transparencyTypes;
     /* replicate the source viewport rectangle and target extent rectangle */
@@ -349,6 +641,23 @@ OWF_API_CALL WFC_ELEMENT_STATE* WFC_Pipeline_BeginComposition(
     OWF_Rect_Set(&state->dstRect, element->dstRect[0], element->dstRect[1],
                  element->dstRect[2], element->dstRect[3]);
 
+    /* only the part left uncovered by opaque elements above is written,
+       and of that only what lies in the frame's damage */
+    state->visibleRect = element->visibleRect;
+
+    /* the state is reused for other elements; nothing is cached until
+       the lookup below says so */
+    state->transformEntry = NULL;
+    state->transformCached = WFC_FALSE;
+
+    state->directCopy = WFC_Pipeline_IsDirectCopy(element, state);
+    if (state->directCopy) {
+        DPRINT(("  Element is copied directly to target"));
+        state->originalMaskImage = NULL;
+        state->maskImage = NULL;
+        return state;
+    }
+
     /* transform the source rectangle to represent the floating point viewport
        as an offset in the final rotation stage image */
     WFC_Pipeline_TransformSource(state);
@@ -359,115 +668,72 @@ OWF_API_CALL WFC_ELEMENT_STATE* WFC_Pipeline_BeginComposition(
         element->source->lockedStream.image->format.premultiplied;
     imgf.rowPadding = 1;
 
-    /* add a 1 pixel boundary so we can replicate the edges */
-    sourceWidth =
-        element->source->lockedStream.image->width + EXTRA_PIXEL_BOUNDARY;
-    sourceHeight =
-        element->source->lockedStream.image->height + EXTRA_PIXEL_BOUNDARY;
-
-    CREATE_WITH_LIMITS(state->convertedSourceImage, sourceWidth, sourceHeight,
-                       &imgf, MAX_SOURCE_WIDTH, MAX_SOURCE_HEIGHT);
-
     /* calculate the oversized integer crop region (inc. 1 pixel boundary)
        so edge replication can be performed */
     WFC_Pipeline_OversizedViewport(state);
 
-    /* subsequent temporary renderstage pipeline images need to use the
-       oversized integer crop region */
-    CREATE_WITH_LIMITS(state->croppedSourceImage,
-                       state->oversizedCropRect.width,
-                       state->oversizedCropRect.height, &imgf, MAX_SOURCE_WIDTH,
-                       MAX_SOURCE_HEIGHT);
+    if (state != &context->elementStates[0] &&
+        !(WFC_Pipeline_ReserveImage(&state->croppedSourceImage,
+                                    state->oversizedCropRect.width,
+                                    state->oversizedCropRect.height) &&
+          WFC_Pipeline_ReserveImage(&state->scaledSourceImage,
+                                    element->dstRect[2],
+                                    element->dstRect[3]))) {
+        DPRINT(("  Cannot create the images of another element state"));
+        return NULL;
+    }
 
-    CREATE_WITH_LIMITS(state->flippedSourceImage,
+    /* the cropped image covers the oversized integer crop region; it is
+       flipped, rotated and scaled into the scaled image in one pass */
+    CREATE_WITH_LIMITS(state->croppedSourceImage,
                        state->oversizedCropRect.width,
                        state->oversizedCropRect.height, &imgf, MAX_SOURCE_WIDTH,
                        MAX_SOURCE_HEIGHT);
 
-    if (state->rotation == WFC_ROTATION_90 ||
-        state->rotation == WFC_ROTATION_270) {
-        tempHeight = state->oversizedCropRect.width;
-        tempWidth = state->oversizedCropRect.height;
-    } else {
-        tempWidth = state->oversizedCropRect.width;
-        tempHeight = state->oversizedCropRect.height;
-    }
-
-    CREATE_WITH_LIMITS(state->rotatedSourceIntermediateImage, tempWidth,
-                       tempHeight, &imgf, MAX_SOURCE_WIDTH, MAX_SOURCE_HEIGHT);
-
-    /* no rotation required - just use the previous stages (flip) buffer */
-    CREATE_WITH_LIMITS(state->rotatedSourceImage, tempWidth, tempHeight, &imgf,
-                       MAX_SOURCE_WIDTH, MAX_SOURCE_HEIGHT);
-
-    /* finally, scaled image uses destination width and height */
+    /* scaled image uses destination width and height */
     OWF_Rect_Set(&state->scaledSrcRect, 0, 0, element->dstRect[2],
                  element->dstRect[3]);
     CREATE_WITH_LIMITS(state->scaledSourceImage, state->scaledSrcRect.width,
                        state->scaledSrcRect.height, &imgf, MAX_SOURCE_WIDTH,
                        MAX_SOURCE_HEIGHT);
 
-    if (!(state->convertedSourceImage && state->croppedSourceImage &&
-          state->scaledSourceImage && state->rotatedSourceIntermediateImage &&
-          state->flippedSourceImage && state->rotatedSourceImage)) {
+    if (!(state->croppedSourceImage && state->scaledSourceImage)) {
         DPRINT(
             ("  Preparation of intermediate pipeline image buffers failed"
              "  (May be caused by overflow or out-of-memory situation)"));
-        DPRINT(("    convertedSourceImage = %p", state->convertedSourceImage));
         DPRINT(("    croppedSourceImage = %p", state->croppedSourceImage));
         DPRINT(("    scaledSourceImage = %p", state->scaledSourceImage));
-        DPRINT(("    rotatedSourceIntermediateImage = %p",
-                state->rotatedSourceIntermediateImage));
-        DPRINT(("    flippedSourceImage = %p", state->flippedSourceImage));
-        DPRINT(("    rotatedSourceImage = %p", state->rotatedSourceImage));
 
         return WFC_FALSE;
     }
 
 #ifdef DEBUG
-    OWF_Image_Clear(state->convertedSourceImage, 0, 0, 0, 0);
     OWF_Image_Clear(state->croppedSourceImage, 0, 0, 0, 0);
     OWF_Image_Clear(state->scaledSourceImage, 0, 0, 0, 0);
-    OWF_Image_Clear(state->rotatedSourceIntermediateImage, 0, 0, 0, 0);
-    OWF_Image_Clear(state->flippedSourceImage, 0, 0, 0, 0);
-    OWF_Image_Clear(state->rotatedSourceImage, 0, 0, 0, 0);
 #endif
 
+    /* a static element reuses its transformed source */
+    WFC_Pipeline_LookupTransform(context, element, state);
+
     /* setup mask in case the element has one */
     if (element->maskComposed) {
-        OWF_IMAGE* image = NULL;
-        OWFsubpixel* pix = NULL;
-        WFCint i = 0;
-
         DPRINT(("Processing element mask"));
         OWF_ASSERT(&element->mask);
         OWF_ASSERT(&element->mask->stream);
-        image = element->mask->lockedStream.image;
-        OWF_ASSERT(image);
+        OWF_ASSERT(element->mask->lockedStream.image);
 
         state->originalMaskImage = element->mask->lockedStream.image;
 
-        imgf.pixelFormat = OWF_IMAGE_L32;
-        imgf.linear = image->format.linear;
-        imgf.premultiplied = image->format.premultiplied;
-
-        /* mask size is always same as destination rect's */
-        DPRINT(("Binding stream image to scratch buffer"));
-        CREATE_WITH_LIMITS(state->maskImage, state->scaledSrcRect.width,
-                           state->scaledSrcRect.height, &imgf, MAX_SOURCE_WIDTH,
-                           MAX_SOURCE_HEIGHT);
-
-        /* initialize mask */
-        DPRINT(("Initializing mask, size = %dx%d", state->scaledSrcRect.width,
-                state->scaledSrcRect.height));
-        pix = (OWFsubpixel*)state->maskImage->data;
-        for (i = 0;
-             i < state->scaledSrcRect.width * state->scaledSrcRect.height;
-             i++) {
-            pix[i] = OWF_FULLY_OPAQUE;
+        /* mask size is always same as destination rect's, so the converted
+           mask is used as is; it is converted only when its content has
+           changed since the previous composition */
+        state->maskImage = WFC_ImageProvider_GetMask(element->mask);
+        if (!state->maskImage) {
+            state->originalMaskImage = NULL;
         }
     } else {
         state->originalMaskImage = NULL;
+        state->maskImage = NULL;
     }
 
     WFC_Pipeline_BlendInfo(context, state);
@@ -477,15 +743,6 @@ OWF_API_CALL WFC_ELEMENT_STATE* WFC_Pipeline_BeginComposition(
             state->croppedSourceImage->height));
     DPRINT(("  Scaled source image size is %dx%d",
             state->scaledSourceImage->width, state->scaledSourceImage->height));
-    DPRINT(("  Mirrored source intermediate image size is %dx%d",
-            state->rotatedSourceIntermediateImage->width,
-            state->rotatedSourceIntermediateImage->height));
-    DPRINT(("  Mirrored source image size is %dx%d",
-            state->flippedSourceImage->width,
-            state->flippedSourceImage->height));
-    DPRINT(("  Rotated source image size is %dx%d",
-            state->rotatedSourceImage->width,
-            state->rotatedSourceImage->height));
 
     return state;
 }
@@ -506,19 +763,31 @@ OWF_API_CALL void WFC_Pipeline_EndComposition(WFC_CONTEXT* context,
     }
 
     OWF_ASSERT(state);
+    if (state->transformEntry) {
+        state->transformEntry->inUse = WFC_FALSE;
+        state->transformEntry = NULL;
+    }
     state->originalSourceImage = NULL;
     state->originalMaskImage = NULL;
+    state->maskImage = NULL;
 }
 
 /*---------------------------------------------------------------------------
  *  \brief Source conversion stage
  *
+ *  Converts the oversized crop region of the source straight into the
+ *  cropped source image; pixels of the 1 pixel boundary that fall outside
+ *  the source are edge-replicated. Only the viewport is read.
+ *
+ *  Elements that need no transform or blending are skipped; the blending
+ *  stage converts them directly into the internal target.
+ *
  *  \param context          Context
  *  \param element          Element
  *----------------------------------------------------------------------------*/
 OWF_API_CALL void WFC_Pipeline_ExecuteSourceConversionStage(
     WFC_CONTEXT* context, WFC_ELEMENT_STATE* state) {
-    /* this stage could be embedded in cropping stage */
+    OWF_RECTANGLE sourceRect;
 
     if (NULL == context || NULL == state) {
         DPRINT(
@@ -530,96 +799,60 @@ OWF_API_CALL void WFC_Pipeline_ExecuteSourceConversionStage(
 
     OWF_ASSERT(state->originalSourceImage);
 
-    OWF_Image_SourceFormatConversion(state->convertedSourceImage,
-                                     state->originalSourceImage);
-
-    /* convert mask from stream format to internal format */
-    if (state->originalMaskImage) {
-        if (!OWF_Image_ConvertMask(state->maskImage,
-                                   state->originalMaskImage)) {
-            state->originalMaskImage = NULL;
-        }
+    if (state->transformCached || state->directCopy) {
+        return;
     }
-}
 
-/*---------------------------------------------------------------------------
- *  \brief Crop stage
- *
- *  \param context          Context
- *  \param element          Element
- *----------------------------------------------------------------------------*/
-OWF_API_CALL void WFC_Pipeline_ExecuteCropStage(WFC_CONTEXT* context,
-                                                WFC_ELEMENT_STATE* state) {
-    OWF_RECTANGLE sourceRect, cropRect;
-
-    DPRINT(("WFC_Pipeline_ExecuteCropStage"));
-
-    if (NULL == context || NULL == state) {
-        DPRINT(("WFC_Context_ExecuteCropStage: context = %p, state = %p",
-                context, state));
-    } else {
-        /* Source rectangle */
-        OWF_Rect_Set(&sourceRect, state->oversizedCropRect.x,
-                     state->oversizedCropRect.y, state->oversizedCropRect.width,
-                     state->oversizedCropRect.height);
-
-        /* cropped source size - supports oversized integer and 1 pixel boundary
-         */
-        OWF_Rect_Set(&cropRect, 0, 0, state->oversizedCropRect.width,
-                     state->oversizedCropRect.height);
+    /* oversizedCropRect is relative to the source grown by the boundary */
+    OWF_Rect_Set(&sourceRect, state->oversizedCropRect.x - 1,
+                 state->oversizedCropRect.y - 1, state->oversizedCropRect.width,
+                 state->oversizedCropRect.height);
 
-        OWF_Image_Blit(state->croppedSourceImage, &cropRect,
-                       state->convertedSourceImage, &sourceRect);
-    }
+    OWF_Image_CroppedSourceFormatConversion(
+        state->croppedSourceImage, state->originalSourceImage, &sourceRect);
 }
 
 /*---------------------------------------------------------------------------
- *  \brief Flip stage
+ *  \brief Transform stage
+ *
+ *  Flips, rotates and scales the cropped source image into the
+ *  transformed image in a single pass, and premultiplies it if the
+ *  element uses source alpha. Nothing is done if the element's cached
+ *  transformed source is still valid.
  *
  *  \param context          Context
  *  \param element          Element
  *----------------------------------------------------------------------------*/
-OWF_API_CALL void WFC_Pipeline_ExecuteFlipStage(WFC_CONTEXT* context,
-                                                WFC_ELEMENT_STATE* state) {
+OWF_API_CALL void WFC_Pipeline_ExecuteTransformStage(
+    WFC_CONTEXT* context, WFC_ELEMENT_STATE* state) {
+    OWF_RECTANGLE scaledRect;
+    OWF_FILTERING filteringMode = OWF_FILTER_POINT_SAMPLING;
     OWF_FLIP_DIRECTION flipping;
+    OWF_ROTATION rot = OWF_ROTATION_0;
+    WFCScaleFilter filter;
+
+    DPRINT(("WFC_Context_ExecuteTransformStage(%p,%p)", context, state));
 
     if (NULL == context || NULL == state) {
-        DPRINT(("WFC_Context_ExecuteFlipStage: context = %p, state = %p",
+        DPRINT(("WFC_Context_ExecuteTransformStage: context = %p, state = %p",
                 context, state));
-    } else {
-        OWF_ASSERT(state);
-        flipping =
-            state->sourceFlip > 0.0f ? OWF_FLIP_VERTICALLY : OWF_FLIP_NONE;
-
-        OWF_Image_Flip(state->flippedSourceImage, flipping);
+        return;
     }
-}
 
-/*---------------------------------------------------------------------------
- *  \brief Rotation stage
- *
- *  \param context          Context
- *  \param element          Element
- *----------------------------------------------------------------------------*/
-OWF_API_CALL void WFC_Pipeline_ExecuteRotationStage(WFC_CONTEXT* context,
-                                                    WFC_ELEMENT_STATE* state) {
-    OWF_ROTATION rot = OWF_ROTATION_0;
-    OWF_RECTANGLE rect;
-    WFCRotation rotation;
+    OWF_ASSERT(state);
 
-    if (NULL == context || NULL == state) {
-        DPRINT(("WFC_Context_ExecuteRotationStage: context = %p, state = %p",
-                context, state));
+    if (state->directCopy || state->transformCached) {
         return;
     }
-    OWF_ASSERT(state);
 
-    rotation = state->rotation;
-    DPRINT(("  Element rotation = %d", rotation));
+    flipping = state->sourceFlip > 0.0f ? OWF_FLIP_VERTICALLY : OWF_FLIP_NONE;
 
-    switch (rotation) {
+    DPRINT(("  Element rotation = %d", state->rotation));
+
+    switch (state->rotation) {
         case WFC_ROTATION_0: {
-            return; /* Rotate copies back into input buffer so just skip */
+            rot = OWF_ROTATION_0;
+            break;
         }
 
         case WFC_ROTATION_90: {
@@ -642,45 +875,6 @@ OWF_API_CALL void WFC_Pipeline_ExecuteRotationStage(WFC_CONTEXT* context,
         }
     }
 
-    /* rotate the the image using rotatedSourceIntermediateImage */
-    OWF_Image_Rotate(state->rotatedSourceIntermediateImage,
-                     state->flippedSourceImage, rot);
-
-    /* blit rotated image back to original image buffer */
-    rect.x = 0;
-    rect.y = 0;
-    rect.width = state->rotatedSourceIntermediateImage->width;
-    rect.height = state->rotatedSourceIntermediateImage->height;
-
-    DPRINT(("  Source image dimensions after rotation = %dx%d", rect.width,
-            rect.height));
-
-    OWF_Image_Blit(state->rotatedSourceImage, &rect,
-                   state->rotatedSourceIntermediateImage, &rect);
-}
-
-/*---------------------------------------------------------------------------
- *  \brief Scaling stage
- *
- *  \param context          Context
- *  \param element          Element
- *----------------------------------------------------------------------------*/
-OWF_API_CALL void WFC_Pipeline_ExecuteScalingStage(WFC_CONTEXT* context,
-                                                   WFC_ELEMENT_STATE* state) {
-    OWF_RECTANGLE scaledRect, cropRect;
-    OWF_FILTERING filteringMode = OWF_FILTER_POINT_SAMPLING;
-    WFCScaleFilter filter;
-
-    DPRINT(("WFC_Context_ExecuteScalingStage(%p,%p)", context, state));
-
-    if (NULL == context || NULL == state) {
-        DPRINT(("WFC_Context_ExecuteScalingStage: context = %p, state = %p",
-                context, state));
-        return;
-    }
-
-    OWF_ASSERT(state);
-
     filter = state->sourceScaleFilter;
 
     switch (filter) {
@@ -691,8 +885,11 @@ OWF_API_CALL void WFC_Pipeline_ExecuteScalingStage(WFC_CONTEXT* context,
             break;
         }
         case WFC_SCALE_FILTER_BETTER: {
-            filteringMode = OWF_FILTER_BILINEAR;
-            DPRINT(("  Using bilinear filter"));
+            /* large downscales need more than the nearest 4 pixels */
+            filteringMode = OWF_Image_SelectQualityFilter(
+                state->transformedSourceRect[2] / state->destinationRect[2],
+                state->transformedSourceRect[3] / state->destinationRect[3]);
+            DPRINT(("  Using quality filter %d", filteringMode));
             break;
         }
 
@@ -705,38 +902,58 @@ OWF_API_CALL void WFC_Pipeline_ExecuteScalingStage(WFC_CONTEXT* context,
         }
     }
 
-    OWF_Rect_Set(&cropRect, 1, 1,
-                 state->rotatedSourceImage->width - EXTRA_PIXEL_BOUNDARY,
-                 state->rotatedSourceImage->height - EXTRA_PIXEL_BOUNDARY);
-
     OWF_Rect_Set(&scaledRect, 0, 0, state->destinationRect[2],
                  state->destinationRect[3]);
 
-    if (scaledRect.width != state->transformedSourceRect[2] ||
-        scaledRect.height != state->transformedSourceRect[3] ||
-        state->sourceRect[0] != floor(state->sourceRect[0]) ||
-        state->sourceRect[1] != floor(state->sourceRect[1])) {
-        /* scale the image */
-        OWF_Image_Stretch(state->scaledSourceImage, &scaledRect,
-                          state->rotatedSourceImage,
-                          state->transformedSourceRect, filteringMode);
-    } else {
-        /* 1:1 copy, no need to scale */
-        OWF_Image_Blit(state->scaledSourceImage, &scaledRect,
-                       state->rotatedSourceImage, &cropRect);
+    if (scaledRect.width == state->transformedSourceRect[2] &&
+        scaledRect.height == state->transformedSourceRect[3] &&
+        state->sourceRect[0] == floor(state->sourceRect[0]) &&
+        state->sourceRect[1] == floor(state->sourceRect[1])) {
+        /* 1:1 copy, no need to filter */
+        filteringMode = OWF_FILTER_POINT_SAMPLING;
+    }
+
+    /* transformedSourceRect is relative to the flipped and rotated
+       cropped source image */
+    if (!OWF_Image_Transform(state->transformedImage, &scaledRect,
+                             state->croppedSourceImage,
+                             state->transformedSourceRect, rot, flipping,
+                             filteringMode) &&
+        state->transformEntry) {
+        /* no source buffer ever has serial zero */
+        state->transformEntry->key.serial = 0;
+        state->transformEntry->hash = 0;
+    }
+
+    /* source alpha is blended premultiplied; doing it here keeps it off
+       the serial blending stage and in the cached image */
+    if (state->transparencyTypes & WFC_TRANSPARENCY_SOURCE) {
+        OWF_Image_PremultiplyAlpha(state->transformedImage);
     }
 }
 
 /*---------------------------------------------------------------------------
  *  \brief Blending stage
  *
+ *  Blends the scaled source into the parts of the frame's damage the
+ *  element covers, or converts the original source straight into them
+ *  if the element needs no transform or blending. Only the target
+ *  pixels inside the region are written, so disjoint regions can be
+ *  composed concurrently.
+ *
  *  \param context          Context
  *  \param element          Element
+ *  \param region           Part of the internal target to compose
  *----------------------------------------------------------------------------*/
-OWF_API_CALL void WFC_Pipeline_ExecuteBlendingStage(WFC_CONTEXT* context,
-                                                    WFC_ELEMENT_STATE* state) {
+OWF_API_CALL void WFC_Pipeline_ExecuteBlendingStage(
+    WFC_CONTEXT* context, WFC_ELEMENT_STATE* state,
+    OWF_RECTANGLE* region) {
     OWF_TRANSPARENCY blendMode = OWF_TRANSPARENCY_NONE;
     WFCbitfield transparency = 0;
+    OWF_BLEND_INFO blendInfo;
+    OWF_RECTANGLE drawRect, drawSrcRect, sourceRect;
+    OWF_IMAGE target;
+    OWFint i;
 
     DPRINT(("WFC_Pipeline_ExecuteBlendingStage"));
 
@@ -747,6 +964,28 @@ OWF_API_CALL void WFC_Pipeline_ExecuteBlendingStage(WFC_CONTEXT* context,
     DPRINT(("  context = %d, state = %d", context->handle, state));
 
     OWF_ASSERT(state);
+    OWF_ASSERT(region);
+
+    if (state->directCopy) {
+        /* the conversion updates the target's format flags; keep that
+           to a copy of the header shared by no other region */
+        target = *context->state.internalTargetImage;
+        for (i = 0; i < context->frameDamage.count; i++) {
+            if (!WFC_Pipeline_ClipToDamage(state,
+                                           &context->frameDamage.rects[i],
+                                           region, &drawRect, &drawSrcRect)) {
+                continue;
+            }
+            OWF_Rect_Set(&sourceRect,
+                         (OWFint)state->sourceRect[0] + drawSrcRect.x,
+                         (OWFint)state->sourceRect[1] + drawSrcRect.y,
+                         drawRect.width, drawRect.height);
+            OWF_Image_ConvertSourceRect(&target, &drawRect,
+                                        state->originalSourceImage,
+                                        &sourceRect);
+        }
+        return;
+    }
 
     transparency = state->transparencyTypes;
     blendMode = OWF_TRANSPARENCY_NONE;
@@ -756,7 +995,6 @@ OWF_API_CALL void WFC_Pipeline_ExecuteBlendingStage(WFC_CONTEXT* context,
     }
 
     if (transparency & WFC_TRANSPARENCY_SOURCE) {
-        OWF_Image_PremultiplyAlpha(state->scaledSourceImage);
         blendMode |= OWF_TRANSPARENCY_SOURCE_ALPHA;
     }
 
@@ -764,5 +1002,13 @@ OWF_API_CALL void WFC_Pipeline_ExecuteBlendingStage(WFC_CONTEXT* context,
         blendMode |= OWF_TRANSPARENCY_MASK;
     }
 
-    OWF_Image_Blend(&state->blendInfo, blendMode);
+    blendInfo = state->blendInfo;
+    blendInfo.destination.rectangle = &drawRect;
+    blendInfo.source.rectangle = &drawSrcRect;
+    for (i = 0; i < context->frameDamage.count; i++) {
+        if (WFC_Pipeline_ClipToDamage(state, &context->frameDamage.rects[i],
+                                      region, &drawRect, &drawSrcRect)) {
+            OWF_Image_Blend(&blendInfo, blendMode);
+        }
+    }
 }
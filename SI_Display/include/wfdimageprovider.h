@@ -51,6 +51,9 @@ OWF_API_CALL OWF_IMAGE *WFD_ImageProvider_LockForReading(
 OWF_API_CALL void WFD_ImageProvider_Unlock(WFD_IMAGE_PROVIDER *provider)
     OWF_APIEXIT;
 
+OWF_API_CALL OWF_IMAGE *WFD_ImageProvider_GetMask(
+    WFD_IMAGE_PROVIDER *provider) OWF_APIEXIT;
+
 OWF_API_CALL WFDboolean WFD_ImageProvider_IsRegionValid(
     WFD_IMAGE_PROVIDER *provider, const WFDRect *region) OWF_APIEXIT;
 
@@ -81,6 +81,8 @@ typedef struct WFD_IMAGE_PROVIDER_ {
         OWF_IMAGE *image;
         OWF_STREAM *stream;
     } source;
+    /*! mask converted to internal format, for mask providers */
+    OWF_MASK_CACHE maskCache;
 } WFD_IMAGE_PROVIDER;
 
 typedef struct WFD_IMAGE_PROVIDER_ WFD_SOURCE;
@@ -91,9 +93,7 @@ typedef struct WFD_IMAGE_PROVIDER_ WFD_MASK;
 /* ======================================================== */
 
 /*! Number of scratch buffers created per port */
-#define WFD_PORT_SCRATCH_COUNT 3
-/*! Index of the scratch buffer used for masks */
-#define WFD_PORT_MASK_INDEX 2
+#define WFD_PORT_SCRATCH_COUNT 2
 
 /*! Pointers for bound and cached pipelines. Only
  * the other of the two is in use at any moment of time,
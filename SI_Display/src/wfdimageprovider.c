@@ -53,6 +53,7 @@ void WFD_IMAGE_PROVIDER_Dtor(void *self) {
     REMREF(ip->pipeline);
 
     DPRINT(("WFD_IMAGE_PROVIDER_Dtor"));
+    OWF_Image_DestroyMaskCache(&ip->maskCache);
     switch (ip->sourceType) {
         case WFD_SOURCE_STREAM: {
             DPRINT(("  Releasing stream"));
@@ -166,6 +167,38 @@ WFD_ImageProvider_Unlock(WFD_IMAGE_PROVIDER *provider) OWF_APIEXIT {
     }
 }
 
+OWF_API_CALL OWF_IMAGE *OWF_APIENTRY
+WFD_ImageProvider_GetMask(WFD_IMAGE_PROVIDER *provider) OWF_APIEXIT {
+    OWF_IMAGE *image;
+    OWFuint32 serial = OWF_MASK_SERIAL_NONE;
+
+    if (!provider) {
+        DPRINT(("WFD_ImageProvider_GetMask: provider = NULL"));
+        return NULL;
+    }
+
+    switch (provider->sourceType) {
+        case WFD_SOURCE_STREAM: {
+            OWF_ASSERT(provider->source.stream->lockCount > 0);
+            image = provider->source.stream->image;
+            serial = owfNativeStreamGetBufferSerial(
+                provider->source.stream->handle,
+                provider->source.stream->buffer);
+            break;
+        }
+        case WFD_SOURCE_IMAGE: {
+            /* image content changes are not tracked; always convert */
+            image = provider->source.image;
+            break;
+        }
+        default: {
+            OWF_ASSERT(0);
+            return NULL;
+        }
+    }
+    return OWF_Image_GetCachedMask(&provider->maskCache, image, serial);
+}
+
 OWF_API_CALL WFDboolean OWF_APIENTRY WFD_ImageProvider_IsRegionValid(
     WFD_IMAGE_PROVIDER *provider, const WFDRect *region) OWF_APIEXIT {
     WFD_SOURCE *src;
@@ -948,9 +948,9 @@ WFD_Pipeline_SetTSColor(WFD_PIPELINE *pipeline, WFDTSColorFormat colorFormat,
     WFD_Util_ConverTSColor(colorFormat, count, color, &pipeline->tsColor);
 
     DPRINT(("Transparent source color is: r:%f, g:%f, b:%f",
-            pipeline->tsColor.color.color.red,
-            pipeline->tsColor.color.color.green,
-            pipeline->tsColor.color.color.blue));
+            (OWFfloat)pipeline->tsColor.color.color.red,
+            (OWFfloat)pipeline->tsColor.color.color.green,
+            (OWFfloat)pipeline->tsColor.color.color.blue));
 }
 
 /* ================================================================== */
@@ -991,6 +991,17 @@ static WFDboolean WFD_Pipeline_StreamSizeIsValid(WFD_PIPELINE *pPipeline,
     return WFD_Pipeline_SizeIsValid(pPipeline, width, height);
 }
 
+static WFDboolean WFD_Pipeline_StreamFormatIsValid(
+    WFDNativeStreamType stream) {
+    OWF_IMAGE_FORMAT format;
+
+    format.pixelFormat = OWF_IMAGE_NOT_SUPPORTED;
+    owfNativeStreamGetHeader(stream, NULL, NULL, NULL, &format, NULL);
+
+    return OWF_Image_IsSupportedSourceFormat(format.pixelFormat) ? WFD_TRUE
+                                                                 : WFD_FALSE;
+}
+
 OWF_API_CALL WFDErrorCode OWF_APIENTRY WFD_Pipeline_IsImageValidSource(
     WFD_PIPELINE *pPipeline, WFDEGLImage image) OWF_APIEXIT {
     OWF_ASSERT(pPipeline && pPipeline->config);
@@ -1015,7 +1026,8 @@ OWF_API_CALL WFDErrorCode OWF_APIENTRY WFD_Pipeline_IsStreamValidSource(
         return WFD_ERROR_ILLEGAL_ARGUMENT;
     }
 
-    if (!WFD_Pipeline_StreamSizeIsValid(pPipeline, stream)) {
+    if (!WFD_Pipeline_StreamSizeIsValid(pPipeline, stream) ||
+        !WFD_Pipeline_StreamFormatIsValid(stream)) {
         return WFD_ERROR_NOT_SUPPORTED;
     }
 
@@ -1549,14 +1561,6 @@ static void WFD_Pipeline_SourceStreamUpdated(OWFNativeStreamType stream,
 /*                    I M A G E   P I P E L I N E                     */
 /* ================================================================== */
 
-#define SWAP_IMG_PTRS(img1, img2) \
-    {                             \
-        OWF_IMAGE *tmp;           \
-        tmp = img2;               \
-        img2 = img1;              \
-        img1 = tmp;               \
-    }
-
 OWF_API_CALL void OWF_APIENTRY WFD_Pipeline_Clear(WFD_PIPELINE *pPipeline)
     OWF_APIEXIT {
     DPRINT(("WFD_Pipeline_Clear for pipeline %d", pPipeline->config->id));
@@ -1608,47 +1612,20 @@ WFD_Pipeline_Execute(WFD_PIPELINE *pPipeline, WFD_SOURCE *pSource) OWF_APIEXIT {
         OWF_IMAGE *inpImg;
         OWFfloat srcRectFloat[4];
 
-        /* 1. Source conversion */
-        inpImg = pImg;
+        /* 1. Source conversion, fused with cropping: only the source
+         *    rectangle is read from the source image */
         outImg = pPipeline->scratch[0];
-
-        /* NOTE: Image size is restricted to max source size
-         * of the pipeline. It is checked at source creation time.
-         * This restriction can be relaxed if cropping were
-         * done before source format conversion.
-         */
-        OWF_Image_SetSize(outImg, inpImg->width, inpImg->height);
-        outImg->format.premultiplied = inpImg->format.premultiplied;
-        outImg->format.linear = inpImg->format.linear;
-        OWF_Image_SourceFormatConversion(outImg, inpImg);
-
-        /* set-up for buffer pointer swapping */
-        inpImg = pPipeline->scratch[1];
-        OWF_Image_SetSize(inpImg, srcRect.width, srcRect.height);
-        inpImg->format.premultiplied = outImg->format.premultiplied;
-        inpImg->format.linear = outImg->format.linear;
-
-        /* 2. crop */
-        if (srcRect.x != 0 || srcRect.y != 0 ||
-            srcRect.height != pImg->height || srcRect.width != pImg->width) {
-            /* crop only if source rect differs from image size */
-            SWAP_IMG_PTRS(inpImg, outImg);
-
-            OWF_Rect_Set(&tmpRect, 0, 0, srcRect.width, srcRect.height);
-            OWF_Image_Blit(outImg, &tmpRect, inpImg, &srcRect);
-        }
-
-        /* 3. flip & mirror */
-        if (flip != 0) {
-            /* flipping & mirrorig is done in-image */
-            OWF_Image_Flip(outImg, flip);
-        }
-
-        /* 4. rotate */
-        if (plRotation) {
+        OWF_Image_SetSize(outImg, srcRect.width, srcRect.height);
+        outImg->format.premultiplied = pImg->format.premultiplied;
+        outImg->format.linear = pImg->format.linear;
+        OWF_Image_CroppedSourceFormatConversion(outImg, pImg, &srcRect);
+
+        /* 2. flip & mirror, rotate, scale & filter in one pass */
+        if (flip != 0 || plRotation != 0 || dstRect.width != srcRect.width ||
+            dstRect.height != srcRect.height) {
             OWF_ROTATION rotation = OWF_ROTATION_0;
-
-            SWAP_IMG_PTRS(inpImg, outImg);
+            OWF_FILTERING owfFilter = OWF_FILTER_POINT_SAMPLING;
+            WFDboolean sizeOK;
 
             switch (plRotation) {
                 case 0:
@@ -1667,41 +1644,44 @@ WFD_Pipeline_Execute(WFD_PIPELINE *pPipeline, WFD_SOURCE *pSource) OWF_APIEXIT {
                     OWF_ASSERT(0);
             }
 
-            OWF_Image_Rotate(outImg, inpImg, rotation);
+            /* source rectangle in rotated image coordinates */
+            srcRectFloat[0] = 0;
+            srcRectFloat[1] = 0;
             if (rotation == OWF_ROTATION_90 || rotation == OWF_ROTATION_270) {
-                OWF_Image_SwapWidthAndHeight(outImg);
+                srcRectFloat[2] = outImg->height;
+                srcRectFloat[3] = outImg->width;
+            } else {
+                srcRectFloat[2] = outImg->width;
+                srcRectFloat[3] = outImg->height;
             }
-        }
-
-        /* 5. scale & filter, positioning */
-        srcRectFloat[0] = 0;
-        srcRectFloat[1] = 0;
-        srcRectFloat[2] = outImg->width;
-        srcRectFloat[3] = outImg->height;
-        if (dstRect.height != srcRectFloat[3] ||
-            dstRect.width != srcRectFloat[2]) {
-            OWF_FILTERING owfFilter;
-            WFDboolean sizeOK;
 
-            SWAP_IMG_PTRS(inpImg, outImg);
-
-            switch (scaleFilter) {
-                case WFD_SCALE_FILTER_BETTER:
-                    owfFilter = OWF_FILTER_BILINEAR;
-                    break;
-                case WFD_SCALE_FILTER_FASTER:
-                    /* no faster filtering */
-                case WFD_SCALE_FILTER_NONE:
-                default:
-                    owfFilter = OWF_FILTER_POINT_SAMPLING;
-                    break;
+            if (dstRect.height != srcRectFloat[3] ||
+                dstRect.width != srcRectFloat[2]) {
+                switch (scaleFilter) {
+                    case WFD_SCALE_FILTER_BETTER:
+                        owfFilter = OWF_Image_SelectQualityFilter(
+                            srcRectFloat[2] / dstRect.width,
+                            srcRectFloat[3] / dstRect.height);
+                        break;
+                    case WFD_SCALE_FILTER_FASTER:
+                        /* no faster filtering */
+                    case WFD_SCALE_FILTER_NONE:
+                    default:
+                        owfFilter = OWF_FILTER_POINT_SAMPLING;
+                        break;
+                }
             }
 
+            inpImg = outImg;
+            outImg = pPipeline->scratch[1];
+            outImg->format.premultiplied = inpImg->format.premultiplied;
+            outImg->format.linear = inpImg->format.linear;
+
             sizeOK = OWF_Image_SetSize(outImg, dstRect.width, dstRect.height);
             OWF_ASSERT(sizeOK);
             OWF_Rect_Set(&tmpRect, 0, 0, dstRect.width, dstRect.height);
-            OWF_Image_Stretch(outImg, &tmpRect, inpImg, srcRectFloat,
-                              owfFilter);
+            OWF_Image_Transform(outImg, &tmpRect, inpImg, srcRectFloat,
+                                rotation, flip, owfFilter);
         }
 
         /*  At this point pipeline has rendered image to pipeline
@@ -1713,7 +1693,7 @@ WFD_Pipeline_Execute(WFD_PIPELINE *pPipeline, WFD_SOURCE *pSource) OWF_APIEXIT {
         /* swap buffers */
         pPipeline->frontBuffer = outImg;
 
-        /* 6.offset, 7. layer & blend  - left for port */
+        /* 3.offset, 4. layer & blend  - left for port */
     }
 
     /* unlock source */
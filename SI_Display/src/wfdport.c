@@ -1756,9 +1756,9 @@ static void WFD_Port_SetFrameBufferBackground(WFD_PORT *port, WFDfloat *color) {
 
     OWF_Image_SetSize(port->scratch[0], w, h);
 
-    red = color[0];
-    green = color[1];
-    blue = color[2];
+    red = OWF_SUBPIXEL_FROM_FLOAT(color[0]);
+    green = OWF_SUBPIXEL_FROM_FLOAT(color[1]);
+    blue = OWF_SUBPIXEL_FROM_FLOAT(color[2]);
 
     OWF_Image_Clear(port->scratch[0], red, green, blue, OWF_FULLY_OPAQUE);
 
@@ -2308,11 +2308,11 @@ static void WFD_Port_RenderInit(WFD_PORT *port) {
      * Otherwise, port background color is used.
      */
     if (port->config->fillPortArea) {
-        red = green = blue = 0.0;
+        red = green = blue = OWF_FULLY_TRANSPARENT;
     } else {
-        red = port->config->backgroundColor[0];
-        green = port->config->backgroundColor[1];
-        blue = port->config->backgroundColor[2];
+        red = OWF_SUBPIXEL_FROM_FLOAT(port->config->backgroundColor[0]);
+        green = OWF_SUBPIXEL_FROM_FLOAT(port->config->backgroundColor[1]);
+        blue = OWF_SUBPIXEL_FROM_FLOAT(port->config->backgroundColor[2]);
     }
 
     OWF_Image_Clear(port->scratch[0], red, green, blue, OWF_FULLY_OPAQUE);
@@ -2344,12 +2344,10 @@ static void WFD_Port_LayerAndBlend(WFD_PORT *pPort, WFD_PIPELINE *pPipeline,
     }
 
     if (pMask) {
-        maskImage = WFD_ImageProvider_LockForReading(pMask);
-        /* NOTE: mask could be converted at the time it is bound */
-        OWF_Image_SetSize(pPort->scratch[WFD_PORT_MASK_INDEX], maskImage->width,
-                          maskImage->height);
-        hasMask = OWF_Image_ConvertMask(pPort->scratch[WFD_PORT_MASK_INDEX],
-                                        maskImage);
+        WFD_ImageProvider_LockForReading(pMask);
+        /* converted only when the mask content has changed */
+        maskImage = WFD_ImageProvider_GetMask(pMask);
+        hasMask = (maskImage) ? WFD_TRUE : WFD_FALSE;
     }
 
     pipelineVisible =
@@ -2358,9 +2356,7 @@ static void WFD_Port_LayerAndBlend(WFD_PORT *pPort, WFD_PIPELINE *pPipeline,
     /* blend result only if pipeline is in refresh area */
     if (pipelineVisible) {
         WFD_Port_SetBlendParams(
-            &blend, pPort, pPipeline,
-            (hasMask) ? pPort->scratch[WFD_PORT_MASK_INDEX] : NULL, &dstRect,
-            &srcRect);
+            &blend, pPort, pPipeline, maskImage, &dstRect, &srcRect);
         blendMode = WFD_Util_GetBlendMode(pPipeline->config->transparencyEnable,
                                           hasMask);
         OWF_Image_PremultiplyAlpha(pPipeline->frontBuffer);
@@ -2382,15 +2378,16 @@ static void WFD_Port_SetBlendParams(OWF_BLEND_INFO *blend, WFD_PORT *pPort,
     blend->source.image = pPipeline->frontBuffer;
     blend->source.rectangle = srcRect;
     blend->mask = pMask;
-    blend->globalAlpha = pPipeline->config->globalAlpha;
+    blend->globalAlpha =
+        OWF_SUBPIXEL_FROM_FLOAT(pPipeline->config->globalAlpha);
     blend->destinationFullyOpaque = WFD_TRUE;
 
     if (pPipeline->config->transparencyEnable & WFD_TRANSPARENCY_SOURCE_COLOR) {
         blend->tsColor = &pPipeline->tsColor.color;
         DPRINT(("  blend mode = WFD_TRANSPARENCY_SOURCE_COLOR: %f, %f, %f",
-                pPipeline->tsColor.color.color.red,
-                pPipeline->tsColor.color.color.green,
-                pPipeline->tsColor.color.color.blue));
+                (OWFfloat)pPipeline->tsColor.color.color.red,
+                (OWFfloat)pPipeline->tsColor.color.color.green,
+                (OWFfloat)pPipeline->tsColor.color.color.blue));
     } else {
         blend->tsColor = NULL;
     }
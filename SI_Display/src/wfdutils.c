@@ -325,13 +325,19 @@ WFD_Util_InitScratchBuffer(OWF_IMAGE **scratchArray, WFDint arraySize, WFDint w,
 
     for (i = 0; i < arraySize; i++) {
         OWF_IMAGE_FORMAT format;
+        WFDint stride;
 
         format.pixelFormat = OWF_IMAGE_ARGB_INTERNAL;
         format.linear = OWF_FALSE;
         format.premultiplied = OWF_FALSE;
         format.rowPadding = OWF_Image_GetFormatPadding(format.pixelFormat);
 
-        scratchArray[i] = OWF_Image_Create(w, h, &format, NULL, 0);
+        /* rows are padded, so leave room for the image rotated by 90
+           degrees as well */
+        stride = OWF_Image_GetStride(h, &format, 0);
+        stride = (stride * w + h - 1) / h;
+
+        scratchArray[i] = OWF_Image_Create(w, h, &format, NULL, stride);
         ret = ret && scratchArray[i];
     }
 
@@ -390,19 +396,22 @@ WFD_Util_ConverTSColor(WFDTSColorFormat colorFormat, WFDint count,
         case WFD_TSC_FORMAT_UINT8_RGB_8_8_8_LINEAR:
             rgb = (WFDuint8 *)color;
 
-            tsColor->color.color.red = rgb[0] / 255.0;
-            tsColor->color.color.green = rgb[1] / 255.0;
-            tsColor->color.color.blue = rgb[2] / 255.0;
-            tsColor->color.color.alpha = 1.0;
+            tsColor->color.color.red = OWF_SUBPIXEL_FROM_BYTE(rgb[0]);
+            tsColor->color.color.green = OWF_SUBPIXEL_FROM_BYTE(rgb[1]);
+            tsColor->color.color.blue = OWF_SUBPIXEL_FROM_BYTE(rgb[2]);
+            tsColor->color.color.alpha = OWF_FULLY_OPAQUE;
 
             break;
         case WFD_TSC_FORMAT_UINT8_RGB_5_6_5_LINEAR:
             rgb = (WFDuint8 *)color;
 
-            tsColor->color.color.red = rgb[0] / 31.0f;
-            tsColor->color.color.green = rgb[1] / 63.0f;
-            tsColor->color.color.blue = rgb[2] / 31.0f;
-            tsColor->color.color.alpha = 1.0;
+            tsColor->color.color.red =
+                OWF_SUBPIXEL_FROM_FLOAT(rgb[0] / 31.0f);
+            tsColor->color.color.green =
+                OWF_SUBPIXEL_FROM_FLOAT(rgb[1] / 63.0f);
+            tsColor->color.color.blue =
+                OWF_SUBPIXEL_FROM_FLOAT(rgb[2] / 31.0f);
+            tsColor->color.color.alpha = OWF_FULLY_OPAQUE;
 
             break;
 